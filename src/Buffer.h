@@ -1,6 +1,7 @@
 #pragma once
 
 #include <d3d11.h>
+#include <d3d11_1.h>
 
 #include <Windows.Foundation.h>
 #include <stdio.h>
@@ -45,20 +46,125 @@ D3D11_BUFFER_DESC ConstantBufferDesc(bool dynamic = true)
 	return ConstantBufferDesc(sizeof(T), dynamic);
 }
 
+class ConstantBuffer;
+
+/**
+ * @brief One large dynamic constant buffer that small, frequently updated constant buffers are suballocated from.
+ *
+ * Uploads are appended with MAP_NO_OVERWRITE and bound with *SetConstantBuffers1 offsets, so the
+ * driver does not have to rename a small buffer for every draw. The ring is mapped with
+ * WRITE_DISCARD when it wraps, which discards every range handed out before. Each wrap starts a
+ * new generation; RestoreStale() re-uploads and rebinds the buffers whose latest range belongs to
+ * an older one. This needs D3D11.1 constant buffer offsetting; without it IsSupported() is false
+ * and ConstantBuffer keeps updating its own buffer.
+ */
+class ConstantUploadRing
+{
+public:
+	static constexpr UINT Alignment = 256;  // offsets and sizes are multiples of 16 constants
+
+	struct Range
+	{
+		UINT firstConstant;
+		UINT numConstants;
+		uint64_t generation;  // the ring generation the range was written in
+	};
+
+	explicit ConstantUploadRing(UINT a_capacity) :
+		allocator(a_capacity, Alignment)
+	{
+		auto device = globals::d3d::device;
+		D3D11_FEATURE_DATA_D3D11_OPTIONS options{};
+		if (FAILED(device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options))) ||
+			!options.ConstantBufferOffsetting || !options.MapNoOverwriteOnDynamicConstantBuffer ||
+			FAILED(globals::d3d::context->QueryInterface(IID_PPV_ARGS(context.put())))) {
+			logger::info("Constant buffer offsetting is not supported, small constant buffers are updated individually");
+			return;
+		}
+		auto desc = ConstantBufferDesc(a_capacity);
+		DX::ThrowIfFailed(device->CreateBuffer(&desc, nullptr, resource.put()));
+	}
+
+	bool IsSupported() const { return resource != nullptr; }
+	ID3D11Buffer* CB() const { return resource.get(); }
+	ID3D11DeviceContext1* Context() const { return context.get(); }
+	Util::RingAllocator::Stats GetStats() const { return allocator.GetStats(); }
+	uint64_t GetGeneration() const { return generation; }
+
+	void Register(ConstantBuffer* a_buffer) { buffers.push_back(a_buffer); }
+	void Unregister(ConstantBuffer* a_buffer) { std::erase(buffers, a_buffer); }
+
+	/**
+	 * @brief Re-uploads and rebinds the registered buffers that were bound from a discarded range.
+	 *
+	 * Call before every draw that may read them, since any upload can wrap the ring.
+	 */
+	void RestoreStale();
+
+	/**
+	 * @brief Copies data into the next free range of the ring.
+	 * @return The range to bind, or std::nullopt if the data does not fit into the ring.
+	 */
+	std::optional<Range> Upload(void const* src_data, size_t data_size)
+	{
+		auto allocation = allocator.Allocate(data_size);
+		if (!allocation)
+			return std::nullopt;
+		if (allocation->wrapped)
+			generation++;
+		D3D11_MAPPED_SUBRESOURCE mapped_buffer{};
+		DX::ThrowIfFailed(context->Map(resource.get(), 0u, allocation->wrapped ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE, 0u, &mapped_buffer));
+		memcpy(static_cast<uint8_t*>(mapped_buffer.pData) + allocation->offset, src_data, data_size);
+		context->Unmap(resource.get(), 0);
+		return Range{ static_cast<UINT>(allocation->offset / 16), static_cast<UINT>(allocation->size / 16), generation };
+	}
+
+private:
+	Util::RingAllocator allocator;
+	winrt::com_ptr<ID3D11Buffer> resource;
+	winrt::com_ptr<ID3D11DeviceContext1> context;
+	uint64_t generation = 0;                // wraps so far
+	std::vector<ConstantBuffer*> buffers;  // ring-backed buffers that RestoreStale() checks
+};
+
 class ConstantBuffer
 {
 public:
-	explicit ConstantBuffer(D3D11_BUFFER_DESC const& a_desc) :
-		desc(a_desc)
+	/**
+	 * @param a_desc The buffer description.
+	 * @param a_ring Optional upload ring for buffers updated per draw. Updates then land at a new
+	 * offset of the ring each time, so the buffer must be bound with PSSet() after every Update().
+	 * A copy of the latest contents is kept so they can be restored after the ring wraps.
+	 */
+	explicit ConstantBuffer(D3D11_BUFFER_DESC const& a_desc, ConstantUploadRing* a_ring = nullptr) :
+		desc(a_desc), ring(a_ring && a_ring->IsSupported() ? a_ring : nullptr)
 	{
 		auto device = globals::d3d::device;
 		DX::ThrowIfFailed(device->CreateBuffer(&desc, nullptr, resource.put()));
+		if (ring)
+			ring->Register(this);
 	}
 
+	~ConstantBuffer()
+	{
+		if (ring)
+			ring->Unregister(this);
+	}
+
+	ConstantBuffer(const ConstantBuffer&) = delete;
+	ConstantBuffer& operator=(const ConstantBuffer&) = delete;
+
 	ID3D11Buffer* CB() const { return resource.get(); }
 
 	void Update(void const* src_data, size_t data_size)
 	{
+		if (ring) {
+			contents.assign(static_cast<const uint8_t*>(src_data), static_cast<const uint8_t*>(src_data) + data_size);
+			range = ring->Upload(src_data, data_size);
+			if (range)
+				return;
+		}
+
 		auto ctx = globals::d3d::context;
 		if (desc.Usage & D3D11_USAGE_DYNAMIC) {
 			D3D11_MAPPED_SUBRESOURCE mapped_buffer{};
@@ -76,11 +182,47 @@ public:
 		Update(&src_data, sizeof(T));
 	}
 
+	/**
+	 * @brief Whether the latest contents were discarded by a wrap of the ring.
+	 */
+	bool IsStale() const { return range && range->generation != ring->GetGeneration(); }
+
+	/**
+	 * @brief Binds the latest contents to a pixel shader slot, re-uploading them first if they are stale.
+	 */
+	void PSSet(UINT a_slot)
+	{
+		if (IsStale())
+			range = ring->Upload(contents.data(), contents.size());
+		slot = a_slot;
+		if (range) {
+			ID3D11Buffer* buffer = ring->CB();
+			ring->Context()->PSSetConstantBuffers1(a_slot, 1, &buffer, &range->firstConstant, &range->numConstants);
+		} else {
+			ID3D11Buffer* buffer = resource.get();
+			globals::d3d::context->PSSetConstantBuffers(a_slot, 1, &buffer);
+		}
+	}
+
 private:
 	winrt::com_ptr<ID3D11Buffer> resource;
 	D3D11_BUFFER_DESC desc;
+	ConstantUploadRing* ring = nullptr;
+	std::optional<ConstantUploadRing::Range> range;  // where the latest update lives in the ring
+	std::vector<uint8_t> contents;                   // latest update, restored after the ring wraps
+	std::optional<UINT> slot;                        // pixel shader slot of the last PSSet()
+
+	friend class ConstantUploadRing;
 };
 
+inline void ConstantUploadRing::RestoreStale()
+{
+	for (auto* buffer : buffers) {
+		if (buffer->slot && buffer->IsStale())
+			buffer->PSSet(*buffer->slot);
+	}
+}
+
 template <typename T>
 D3D11_BUFFER_DESC StructuredBufferDesc(UINT a_count = 1, bool cpu_access = true)
 {
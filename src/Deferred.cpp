@@ -412,26 +412,27 @@ void Deferred::DeferredPasses()
 				ssgi_cocg,
 			};
 
-			context->CSSetShaderResources(0, ARRAYSIZE(srvs), srvs);
+			Util::ComputeState cs(context);
+			cs.SetShaderResources(0, ARRAYSIZE(srvs), srvs);
 
 			ID3D11UnorderedAccessView* uavs[2]{ main.UAV, prevDiffuseAmbientTexture->uav.get() };
-			context->CSSetUnorderedAccessViews(0, ARRAYSIZE(uavs), uavs, nullptr);
+			cs.SetUnorderedAccessViews(0, ARRAYSIZE(uavs), uavs);
 
 			auto shader = interior ? GetComputeAmbientCompositeInterior() : GetComputeAmbientComposite();
-			context->CSSetShader(shader, nullptr, 0);
+			cs.SetShader(shader);
 
 			context->Dispatch(dispatchCount.x, dispatchCount.y, 1);
-		}
 
-		// Clear
-		{
-			ID3D11ShaderResourceView* views[8]{ nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr };
-			context->CSSetShaderResources(0, ARRAYSIZE(views), views);
+			// Clear
+			{
+				ID3D11ShaderResourceView* views[8]{ nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr };
+				cs.SetShaderResources(0, ARRAYSIZE(views), views);
 
-			ID3D11UnorderedAccessView* uavs[2]{ nullptr, nullptr };
-			context->CSSetUnorderedAccessViews(0, ARRAYSIZE(uavs), uavs, nullptr);
+				ID3D11UnorderedAccessView* nullUavs[2]{ nullptr, nullptr };
+				cs.SetUnorderedAccessViews(0, ARRAYSIZE(nullUavs), nullUavs);
 
-			context->CSSetShader(nullptr, nullptr, 0);
+				cs.SetShader(nullptr);
+			}
 		}
 	}
 
@@ -466,32 +467,33 @@ void Deferred::DeferredPasses()
 			ssgi_hq_spec ? ssgi_gi_spec : nullptr,
 		};
 
+		Util::ComputeState cs(context);
 		if (dynamicCubemaps->loaded)
-			context->CSSetSamplers(0, 1, &linearSampler);
+			cs.SetSamplers(0, 1, &linearSampler);
 
-		context->CSSetShaderResources(0, ARRAYSIZE(srvs), srvs);
+		cs.SetShaderResources(0, ARRAYSIZE(srvs), srvs);
 
 		ID3D11UnorderedAccessView* uavs[3]{ main.UAV, normals.UAV, motionVectors.UAV };
-		context->CSSetUnorderedAccessViews(0, ARRAYSIZE(uavs), uavs, nullptr);
+		cs.SetUnorderedAccessViews(0, ARRAYSIZE(uavs), uavs);
 
 		auto shader = interior ? GetComputeMainCompositeInterior() : GetComputeMainComposite();
-		context->CSSetShader(shader, nullptr, 0);
+		cs.SetShader(shader);
 
 		context->Dispatch(dispatchCount.x, dispatchCount.y, 1);
-	}
 
-	// Clear
-	{
-		ID3D11ShaderResourceView* views[14]{ nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr };
-		context->CSSetShaderResources(0, ARRAYSIZE(views), views);
+		// Clear
+		{
+			ID3D11ShaderResourceView* views[14]{ nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr };
+			cs.SetShaderResources(0, ARRAYSIZE(views), views);
 
-		ID3D11UnorderedAccessView* uavs[3]{ nullptr, nullptr, nullptr };
-		context->CSSetUnorderedAccessViews(0, ARRAYSIZE(uavs), uavs, nullptr);
+			ID3D11UnorderedAccessView* nullUavs[3]{ nullptr, nullptr, nullptr };
+			cs.SetUnorderedAccessViews(0, ARRAYSIZE(nullUavs), nullUavs);
 
-		ID3D11Buffer* buffers[1] = { nullptr };
-		context->CSSetConstantBuffers(12, 1, buffers);
+			ID3D11Buffer* buffers[1] = { nullptr };
+			cs.SetConstantBuffers(12, 1, buffers);
 
-		context->CSSetShader(nullptr, nullptr, 0);
+			cs.SetShader(nullptr);
+		}
 	}
 
 	if (dynamicCubemaps->loaded)
@@ -28,6 +28,14 @@ struct Feature
 	virtual bool IsCore() const { return false; }
 
 	virtual void SetupResources() {}
+	/**
+	 * Whether SetupResources only uses the device, files and the feature's own state.
+	 * Such features are set up on worker threads alongside each other; the rest run on the
+	 * render thread in list order.
+	 *
+	 * \return true if SetupResources never touches the immediate context or other features
+	 */
+	virtual bool SupportsParallelSetup() const { return false; }
 	virtual void Reset() {}
 
 	virtual void DrawSettings() {}
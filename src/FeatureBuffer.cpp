@@ -10,30 +10,59 @@
 
 #include "TruePBR.h"
 
-template <class... Ts>
-std::pair<unsigned char*, size_t> _GetFeatureBufferData(Ts... feat_datas)
+namespace FeatureBuffer
 {
-	size_t totalSize = (... + sizeof(Ts));
-	auto data = new unsigned char[totalSize];
-	size_t offset = 0;
+	// slice order must match the feature cbuffer in the shaders
+	using Layout = PackedBuffer<
+		GrassLighting::Settings,
+		ExtendedMaterials::Settings,
+		DynamicCubemaps::Settings,
+		TerrainShadows::PerFrame,
+		LightLimitFix::PerFrame,
+		WetnessEffects::PerFrame,
+		Skylighting::SkylightingCB>;
 
-	([&] {
-		*((decltype(feat_datas)*)(data + offset)) = feat_datas;
-		offset += sizeof(decltype(feat_datas));
-	}(),
-		...);
+	static Layout buffer;
+	static Stats stats{};
 
-	return std::make_pair(data, totalSize);
-}
+	size_t GetSize()
+	{
+		return Layout::Size;
+	}
 
-std::pair<unsigned char*, size_t> GetFeatureBufferData(bool a_inWorld)
-{
-	return _GetFeatureBufferData(
-		globals::features::grassLighting->settings,
-		globals::features::extendedMaterials->settings,
-		globals::features::dynamicCubemaps->settings,
-		globals::features::terrainShadows->GetCommonBufferData(),
-		globals::features::lightLimitFix->GetCommonBufferData(),
-		globals::features::wetnessEffects->GetCommonBufferData(),
-		globals::features::skylighting->GetCommonBufferData(a_inWorld));
-}
\ No newline at end of file
+	const void* Pack(bool a_inWorld)
+	{
+		uint64_t repacked = 0;
+		repacked += buffer.Set<0>(globals::features::grassLighting->settings);
+		repacked += buffer.Set<1>(globals::features::extendedMaterials->settings);
+		repacked += buffer.Set<2>(globals::features::dynamicCubemaps->settings);
+		// written into zeroed slices, so padding the features leave alone compares equal
+		globals::features::terrainShadows->WriteCommonBufferData(buffer.Stage<3>());
+		globals::features::lightLimitFix->WriteCommonBufferData(buffer.Stage<4>());
+		globals::features::wetnessEffects->WriteCommonBufferData(buffer.Stage<5>());
+		globals::features::skylighting->WriteCommonBufferData(buffer.Stage<6>(), a_inWorld);
+		repacked += buffer.Commit<3>();
+		repacked += buffer.Commit<4>();
+		repacked += buffer.Commit<5>();
+		repacked += buffer.Commit<6>();
+
+		stats.frames++;
+		stats.slicesRepacked += repacked;
+		if (!buffer.TakeDirty())
+			return nullptr;
+		stats.uploads++;
+		stats.bytesUploaded += Layout::Size;
+		return buffer.Data();
+	}
+
+	Stats GetStats()
+	{
+		return stats;
+	}
+
+	std::string GetStatsString()
+	{
+		return std::format("{}/{} frames uploaded, {} KB, {} slices repacked",
+			stats.uploads, stats.frames, stats.bytesUploaded / 1024, stats.slicesRepacked);
+	}
+}
@@ -1,3 +1,113 @@
 #pragma once
 
-std::pair<unsigned char*, size_t> GetFeatureBufferData(bool a_early);
\ No newline at end of file
+/**
+ * @brief Persistent CPU copy of a constant buffer made of fixed slices, one per type.
+ *
+ * Slice offsets are laid out at compile time in the order of the types. Set() and Commit()
+ * only copy a slice when its bytes differ from the stored ones and mark it dirty, so the
+ * owner can skip the upload on frames where nothing changed.
+ *
+ * Slices are compared bytewise, padding included. Types whose padding is not reliably
+ * initialised are written in place through Stage(), which hands out a zeroed slice.
+ */
+template <class... Ts>
+class PackedBuffer
+{
+public:
+	static constexpr size_t Count = sizeof...(Ts);
+	static constexpr size_t Size = (0 + ... + sizeof(Ts));
+	static_assert(Count <= 32, "dirty slices are tracked in a 32-bit mask");
+	static_assert((std::is_trivially_copyable_v<Ts> && ...), "slices are compared and copied bytewise");
+
+	static constexpr std::array<size_t, Count> Offsets = []() {
+		constexpr std::array<size_t, Count> sizes{ sizeof(Ts)... };
+		std::array<size_t, Count> offsets{};
+		size_t offset = 0;
+		for (size_t i = 0; i < Count; i++) {
+			offsets[i] = offset;
+			offset += sizes[i];
+		}
+		return offsets;
+	}();
+
+	template <size_t I>
+	using Slice = std::tuple_element_t<I, std::tuple<Ts...>>;
+
+	/**
+	 * @brief Stores a slice if it changed.
+	 * @return true if the slice was repacked.
+	 */
+	template <size_t I>
+	bool Set(const Slice<I>& a_value)
+	{
+		return Store(I, &a_value, sizeof(Slice<I>));
+	}
+
+	/**
+	 * @brief Zeroes the staging copy of a slice for the owner to fill in place.
+	 */
+	template <size_t I>
+	Slice<I>& Stage()
+	{
+		static_assert(Offsets[I] % alignof(Slice<I>) == 0 && alignof(Slice<I>) <= 16, "slice is misaligned in the buffer");
+		auto slice = ::new (staging.data() + Offsets[I]) Slice<I>;
+		std::memset(slice, 0, sizeof(Slice<I>));
+		return *slice;
+	}
+
+	/**
+	 * @brief Stores the slice filled in after Stage() if it changed.
+	 * @return true if the slice was repacked.
+	 */
+	template <size_t I>
+	bool Commit()
+	{
+		return Store(I, staging.data() + Offsets[I], sizeof(Slice<I>));
+	}
+
+	const uint8_t* Data() const { return data.data(); }
+
+	/**
+	 * @brief Returns the slices changed since the last call as a bit mask and clears them.
+	 */
+	uint32_t TakeDirty() { return std::exchange(dirty, 0u); }
+
+private:
+	bool Store(size_t a_index, const void* a_value, size_t a_size)
+	{
+		auto slice = data.data() + Offsets[a_index];
+		if (!std::memcmp(slice, a_value, a_size))
+			return false;
+		std::memcpy(slice, a_value, a_size);
+		dirty |= 1u << a_index;
+		return true;
+	}
+
+	alignas(16) std::array<uint8_t, Size> data{};
+	alignas(16) std::array<uint8_t, Size> staging{};
+	uint32_t dirty = (1u << Count) - 1;  // everything is uploaded once
+};
+
+namespace FeatureBuffer
+{
+	struct Stats
+	{
+		uint64_t frames;          // calls to Pack()
+		uint64_t uploads;         // frames where a slice changed
+		uint64_t bytesUploaded;
+		uint64_t slicesRepacked;
+	};
+
+	size_t GetSize();
+
+	/**
+	 * @brief Repacks the slices of the features whose buffer data changed.
+	 *
+	 * @param a_inWorld Whether the player is in the world, passed to features that depend on it.
+	 * @return The whole buffer if any slice changed and it must be uploaded, otherwise nullptr.
+	 */
+	const void* Pack(bool a_inWorld);
+
+	Stats GetStats();
+	std::string GetStatsString();
+}
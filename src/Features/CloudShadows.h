@@ -25,6 +25,7 @@ struct CloudShadows : Feature
 	ID3D11BlendState* cloudShadowBlendState = nullptr;
 
 	virtual void SetupResources() override;
+	virtual bool SupportsParallelSetup() const override { return true; }
 
 	void CheckResourcesSide(int side);
 	void ModifySky(RE::BSRenderPass* Pass);
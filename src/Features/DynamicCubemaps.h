@@ -107,6 +107,7 @@ public:
 	bool HasShaderDefine(RE::BSShader::Type) override { return true; };
 
 	virtual void SetupResources() override;
+	virtual bool SupportsParallelSetup() const override { return true; }
 	virtual void Reset() override;
 
 	virtual void SaveSettings(json&) override;
@@ -44,6 +44,7 @@ struct GrassCollision : Feature
 	int eyeCount = !REL::Module::IsVR() ? 1 : 2;
 
 	virtual void SetupResources() override;
+	virtual bool SupportsParallelSetup() const override { return true; }
 	virtual void Reset() override;
 
 	virtual void DrawSettings() override;
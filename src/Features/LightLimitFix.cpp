@@ -110,14 +110,12 @@ void LightLimitFix::DrawSettings()
 	}
 }
 
-LightLimitFix::PerFrame LightLimitFix::GetCommonBufferData()
+void LightLimitFix::WriteCommonBufferData(PerFrame& a_data)
 {
-	PerFrame perFrame{};
-	perFrame.EnableContactShadows = settings.EnableContactShadows;
-	perFrame.EnableLightsVisualisation = settings.EnableLightsVisualisation;
-	perFrame.LightsVisualisationMode = settings.LightsVisualisationMode;
-	std::copy(clusterSize, clusterSize + 3, perFrame.ClusterSize);
-	return perFrame;
+	a_data.EnableContactShadows = settings.EnableContactShadows;
+	a_data.EnableLightsVisualisation = settings.EnableLightsVisualisation;
+	a_data.LightsVisualisationMode = settings.LightsVisualisationMode;
+	std::copy(clusterSize, clusterSize + 3, a_data.ClusterSize);
 }
 
 void LightLimitFix::CleanupParticleLights(RE::NiNode* a_node)
@@ -228,7 +226,7 @@ void LightLimitFix::SetupResources()
 	}
 
 	{
-		strictLightDataCB = new ConstantBuffer(ConstantBufferDesc<StrictLightDataCB>());
+		strictLightDataCB = new ConstantBuffer(ConstantBufferDesc<StrictLightDataCB>(), globals::state->constantRing);
 	}
 }
 
@@ -342,7 +340,6 @@ void LightLimitFix::BSLightingShader_SetupGeometry_GeometrySetupConstantPointLig
 void LightLimitFix::BSLightingShader_SetupGeometry_After(RE::BSRenderPass*)
 {
 	auto shaderCache = globals::shaderCache;
-	auto context = globals::d3d::context;
 	auto smState = globals::game::smState;
 
 	if (!shaderCache->IsEnabled())
@@ -356,17 +353,17 @@ void LightLimitFix::BSLightingShader_SetupGeometry_After(RE::BSRenderPass*)
 	const bool isWorld = accumulator->GetRuntimeData().activeShadowSceneNode == shadowSceneNode;
 	const int roomIndex = strictLightDataTemp.RoomIndex;
 
+	bool rebind = frameChecker.IsNewFrame();
 	if (!isEmpty || (isEmpty && !wasEmpty) || isWorld != wasWorld || previousRoomIndex != roomIndex) {
 		strictLightDataCB->Update(strictLightDataTemp);
 		wasEmpty = isEmpty;
 		wasWorld = isWorld;
 		previousRoomIndex = roomIndex;
+		rebind = true;  // every update lands at a new offset of the upload ring
 	}
 
-	if (frameChecker.IsNewFrame()) {
-		ID3D11Buffer* buffer = { strictLightDataCB->CB() };
-		context->PSSetConstantBuffers(3, 1, &buffer);
-	}
+	if (rebind)
+		strictLightDataCB->PSSet(3);
 }
 
 void LightLimitFix::SetLightPosition(LightLimitFix::LightData& a_light, RE::NiPoint3 a_initialPosition, bool a_cached)
@@ -939,6 +936,7 @@ void LightLimitFix::UpdateLights()
 	}
 
 	auto context = globals::d3d::context;
+	Util::ComputeState cs(context);
 
 	{
 		auto projMatrixUnjittered = Util::GetCameraData(0).projMatrixUnjittered;
@@ -958,17 +956,14 @@ void LightLimitFix::UpdateLights()
 			lightBuildingCB->Update(updateData);
 
 			ID3D11Buffer* buffer = lightBuildingCB->CB();
-			context->CSSetConstantBuffers(0, 1, &buffer);
+			cs.SetConstantBuffers(0, 1, &buffer);
 
 			ID3D11UnorderedAccessView* clusters_uav = clusters->uav.get();
-			context->CSSetUnorderedAccessViews(0, 1, &clusters_uav, nullptr);
+			cs.SetUnorderedAccessViews(0, 1, &clusters_uav);
 
-			context->CSSetShader(clusterBuildingCS, nullptr, 0);
+			cs.SetShader(clusterBuildingCS);
 			context->Dispatch(clusterSize[0], clusterSize[1], clusterSize[2]);
 
-			ID3D11UnorderedAccessView* null_uav = nullptr;
-			context->CSSetUnorderedAccessViews(0, 1, &null_uav, nullptr);
-
 			_fov = fov;
 			_lightsNear = lightsNear;
 			_lightsFar = lightsFar;
@@ -992,28 +987,29 @@ void LightLimitFix::UpdateLights()
 		context->ClearUnorderedAccessViewUint(lightIndexCounter->uav.get(), counterReset);
 
 		ID3D11Buffer* buffer = lightCullingCB->CB();
-		context->CSSetConstantBuffers(0, 1, &buffer);
+		cs.SetConstantBuffers(0, 1, &buffer);
 
+		// binding the clusters for reading nulls their UAV from the building pass
 		ID3D11ShaderResourceView* srvs[] = { clusters->srv.get(), lights->srv.get() };
-		context->CSSetShaderResources(0, ARRAYSIZE(srvs), srvs);
+		cs.SetShaderResources(0, ARRAYSIZE(srvs), srvs);
 
 		ID3D11UnorderedAccessView* uavs[] = { lightIndexCounter->uav.get(), lightIndexList->uav.get(), lightGrid->uav.get() };
-		context->CSSetUnorderedAccessViews(0, ARRAYSIZE(uavs), uavs, nullptr);
+		cs.SetUnorderedAccessViews(0, ARRAYSIZE(uavs), uavs);
 
-		context->CSSetShader(clusterCullingCS, nullptr, 0);
+		cs.SetShader(clusterCullingCS);
 		context->Dispatch((clusterSize[0] + 15) / 16, (clusterSize[1] + 15) / 16, (clusterSize[2] + 3) / 4);
 	}
 
-	context->CSSetShader(nullptr, nullptr, 0);
+	cs.SetShader(nullptr);
 
 	ID3D11Buffer* null_buffer = nullptr;
-	context->CSSetConstantBuffers(0, 1, &null_buffer);
+	cs.SetConstantBuffers(0, 1, &null_buffer);
 
 	ID3D11ShaderResourceView* null_srvs[2] = { nullptr };
-	context->CSSetShaderResources(0, 2, null_srvs);
+	cs.SetShaderResources(0, 2, null_srvs);
 
 	ID3D11UnorderedAccessView* null_uavs[3] = { nullptr };
-	context->CSSetUnorderedAccessViews(0, 3, null_uavs, nullptr);
+	cs.SetUnorderedAccessViews(0, 3, null_uavs);
 }
 
 void LightLimitFix::Hooks::BSBatchRenderer_RenderPassImmediately::thunk(RE::BSRenderPass* Pass, uint32_t Technique, bool AlphaTest, uint32_t RenderFlags)
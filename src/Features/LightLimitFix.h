@@ -78,7 +78,7 @@ public:
 		uint ClusterSize[4];
 	};
 
-	PerFrame GetCommonBufferData();
+	void WriteCommonBufferData(PerFrame& a_data);
 
 	struct alignas(16) StrictLightDataCB
 	{
@@ -151,6 +151,7 @@ public:
 	Util::FrameChecker frameChecker;
 
 	virtual void SetupResources() override;
+	virtual bool SupportsParallelSetup() const override { return true; }
 	virtual void Reset() override;
 
 	virtual void LoadSettings(json& o_json) override;
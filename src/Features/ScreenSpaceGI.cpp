@@ -663,18 +663,17 @@ void ScreenSpaceGI::DrawSSGI(Texture2D* srcPrevAmbient)
 	std::array<ID3D11SamplerState*, 2> samplers = { pointClampSampler.get(), linearClampSampler.get() };
 	auto cb = ssgiCB->CB();
 
+	// between passes only slots that would read a resource written by the next pass are nulled
+	Util::ComputeState cs(context);
 	auto resetViews = [&]() {
 		srvs.fill(nullptr);
 		uavs.fill(nullptr);
-
-		context->CSSetShaderResources(0, (uint)srvs.size(), srvs.data());
-		context->CSSetUnorderedAccessViews(0, (uint)uavs.size(), uavs.data(), nullptr);
 	};
 
 	//////////////////////////////////////////////////////
 
-	context->CSSetConstantBuffers(1, 1, &cb);
-	context->CSSetSamplers(0, (uint)samplers.size(), samplers.data());
+	cs.SetConstantBuffers(1, 1, &cb);
+	cs.SetSamplers(0, (uint)samplers.size(), samplers.data());
 
 	// prefilter depths
 	{
@@ -684,9 +683,9 @@ void ScreenSpaceGI::DrawSSGI(Texture2D* srcPrevAmbient)
 		for (int i = 0; i < 5; ++i)
 			uavs.at(i) = uavWorkingDepth[i].get();
 
-		context->CSSetShaderResources(0, (uint)srvs.size(), srvs.data());
-		context->CSSetUnorderedAccessViews(0, (uint)uavs.size(), uavs.data(), nullptr);
-		context->CSSetShader(prefilterDepthsCompute.get(), nullptr, 0);
+		cs.SetShaderResources(0, (uint)srvs.size(), srvs.data());
+		cs.SetUnorderedAccessViews(0, (uint)uavs.size(), uavs.data());
+		cs.SetShader(prefilterDepthsCompute.get());
 		context->Dispatch((resolution[0] + 15) >> 4, (resolution[1] + 15) >> 4, 1);
 	}
 
@@ -714,9 +713,9 @@ void ScreenSpaceGI::DrawSSGI(Texture2D* srcPrevAmbient)
 		uavs.at(4) = texIlCoCg[!inputGITexIdx]->uav.get();
 		uavs.at(5) = texGiSpecular[!inputAoTexIdx]->uav.get();
 
-		context->CSSetShaderResources(0, (uint)srvs.size(), srvs.data());
-		context->CSSetUnorderedAccessViews(0, (uint)uavs.size(), uavs.data(), nullptr);
-		context->CSSetShader(radianceDisoccCompute.get(), nullptr, 0);
+		cs.SetShaderResources(0, (uint)srvs.size(), srvs.data());
+		cs.SetUnorderedAccessViews(0, (uint)uavs.size(), uavs.data());
+		cs.SetShader(radianceDisoccCompute.get());
 		context->Dispatch((internalRes[0] + 7u) >> 3, (internalRes[1] + 7u) >> 3, 1);
 
 		context->GenerateMips(texRadiance->srv.get());
@@ -747,9 +746,9 @@ void ScreenSpaceGI::DrawSSGI(Texture2D* srcPrevAmbient)
 		uavs.at(3) = texGiSpecular[!inputAoTexIdx]->uav.get();
 		uavs.at(4) = texPrevGeo->uav.get();
 
-		context->CSSetShaderResources(0, (uint)srvs.size(), srvs.data());
-		context->CSSetUnorderedAccessViews(0, (uint)uavs.size(), uavs.data(), nullptr);
-		context->CSSetShader(giCompute.get(), nullptr, 0);
+		cs.SetShaderResources(0, (uint)srvs.size(), srvs.data());
+		cs.SetUnorderedAccessViews(0, (uint)uavs.size(), uavs.data());
+		cs.SetShader(giCompute.get());
 		context->Dispatch((internalRes[0] + 7u) >> 3, (internalRes[1] + 7u) >> 3, 1);
 
 		inputAoTexIdx = !inputAoTexIdx;
@@ -773,9 +772,9 @@ void ScreenSpaceGI::DrawSSGI(Texture2D* srcPrevAmbient)
 		uavs.at(1) = texIlY[!inputGITexIdx]->uav.get();
 		uavs.at(2) = texIlCoCg[!inputGITexIdx]->uav.get();
 
-		context->CSSetShaderResources(0, (uint)srvs.size(), srvs.data());
-		context->CSSetUnorderedAccessViews(0, (uint)uavs.size(), uavs.data(), nullptr);
-		context->CSSetShader(blurCompute.get(), nullptr, 0);
+		cs.SetShaderResources(0, (uint)srvs.size(), srvs.data());
+		cs.SetUnorderedAccessViews(0, (uint)uavs.size(), uavs.data());
+		cs.SetShader(blurCompute.get());
 		context->Dispatch((internalRes[0] + 7u) >> 3, (internalRes[1] + 7u) >> 3, 1);
 
 		inputGITexIdx = !inputGITexIdx;
@@ -797,9 +796,9 @@ void ScreenSpaceGI::DrawSSGI(Texture2D* srcPrevAmbient)
 		uavs.at(2) = texIlCoCg[!inputGITexIdx]->uav.get();
 		uavs.at(3) = texGiSpecular[!inputAoTexIdx]->uav.get();
 
-		context->CSSetShaderResources(0, (uint)srvs.size(), srvs.data());
-		context->CSSetUnorderedAccessViews(0, (uint)uavs.size(), uavs.data(), nullptr);
-		context->CSSetShader(upsampleCompute.get(), nullptr, 0);
+		cs.SetShaderResources(0, (uint)srvs.size(), srvs.data());
+		cs.SetUnorderedAccessViews(0, (uint)uavs.size(), uavs.data());
+		cs.SetShader(upsampleCompute.get());
 		context->Dispatch((resolution[0] + 7u) >> 3, (resolution[1] + 7u) >> 3, 1);
 
 		inputAoTexIdx = !inputAoTexIdx;
@@ -811,11 +810,13 @@ void ScreenSpaceGI::DrawSSGI(Texture2D* srcPrevAmbient)
 
 	// cleanup
 	resetViews();
+	cs.SetShaderResources(0, (uint)srvs.size(), srvs.data());
+	cs.SetUnorderedAccessViews(0, (uint)uavs.size(), uavs.data());
 
 	samplers.fill(nullptr);
 	cb = nullptr;
 
-	context->CSSetConstantBuffers(1, 1, &cb);
-	context->CSSetSamplers(0, (uint)samplers.size(), samplers.data());
-	context->CSSetShader(nullptr, nullptr, 0);
-}
\ No newline at end of file
+	cs.SetConstantBuffers(1, 1, &cb);
+	cs.SetSamplers(0, (uint)samplers.size(), samplers.data());
+	cs.SetShader(nullptr);
+}
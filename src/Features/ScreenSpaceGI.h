@@ -27,6 +27,7 @@ struct ScreenSpaceGI : Feature
 	virtual void SaveSettings(json& o_json) override;
 
 	virtual void SetupResources() override;
+	virtual bool SupportsParallelSetup() const override { return true; }
 	virtual void ClearShaderCache() override;
 	void CompileComputeShaders();
 	bool ShadersOK();
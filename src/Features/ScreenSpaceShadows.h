@@ -54,6 +54,7 @@ struct ScreenSpaceShadows : Feature
 	Texture2D* screenSpaceShadowsTexture = nullptr;
 
 	virtual void SetupResources() override;
+	virtual bool SupportsParallelSetup() const override { return true; }
 
 	virtual void DrawSettings() override;
 
@@ -172,14 +172,14 @@ void Skylighting::CompileComputeShaders()
 	}
 }
 
-Skylighting::SkylightingCB Skylighting::GetCommonBufferData(bool a_inWorld)
+void Skylighting::WriteCommonBufferData(SkylightingCB& a_data, bool a_inWorld)
 {
 	if (!a_inWorld)
-		return Skylighting::SkylightingCB{};
+		return;
 
 	if (auto ui = globals::game::ui)
 		if (ui->IsMenuOpen(RE::MapMenu::MENU_NAME))
-			return Skylighting::SkylightingCB{};
+			return;
 
 	static float3 prevCellID = { 0, 0, 0 };
 
@@ -204,18 +204,17 @@ Skylighting::SkylightingCB Skylighting::GetCommonBufferData(bool a_inWorld)
 		if (ssgi->settings.Enabled && ssgi->settings.EnableGI && ssgi->settings.GIStrength > 0.0f)
 			ambientDimmer = settings.SSGIAmbientDimmer;
 
-	return {
-		.OcclusionViewProj = OcclusionTransform,
-		.OcclusionDir = OcclusionDir,
-		.PosOffset = cellOrigin - eyePos,
-		.ArrayOrigin = {
-			((int)cellID.x - probeArrayDims[0] / 2) % probeArrayDims[0],
-			((int)cellID.y - probeArrayDims[1] / 2) % probeArrayDims[1],
-			((int)cellID.z - probeArrayDims[2] / 2) % probeArrayDims[2] },
-		.ValidMargin = { (int)cellIDDiff.x, (int)cellIDDiff.y, (int)cellIDDiff.z },
-		.MinDiffuseVisibility = settings.MinDiffuseVisibility * ambientDimmer,
-		.MinSpecularVisibility = settings.MinSpecularVisibility
-	};
+	a_data.OcclusionViewProj = OcclusionTransform;
+	a_data.OcclusionDir = OcclusionDir;
+	a_data.PosOffset = cellOrigin - eyePos;
+	a_data.ArrayOrigin[0] = ((int)cellID.x - probeArrayDims[0] / 2) % probeArrayDims[0];
+	a_data.ArrayOrigin[1] = ((int)cellID.y - probeArrayDims[1] / 2) % probeArrayDims[1];
+	a_data.ArrayOrigin[2] = ((int)cellID.z - probeArrayDims[2] / 2) % probeArrayDims[2];
+	a_data.ValidMargin[0] = (int)cellIDDiff.x;
+	a_data.ValidMargin[1] = (int)cellIDDiff.y;
+	a_data.ValidMargin[2] = (int)cellIDDiff.z;
+	a_data.MinDiffuseVisibility = settings.MinDiffuseVisibility * ambientDimmer;
+	a_data.MinSpecularVisibility = settings.MinSpecularVisibility;
 }
 
 void Skylighting::Prepass()
@@ -177,22 +177,18 @@ bool TerrainShadows::IsHeightMapReady()
 	return false;
 }
 
-TerrainShadows::PerFrame TerrainShadows::GetCommonBufferData()
+void TerrainShadows::WriteCommonBufferData(PerFrame& a_data)
 {
 	bool isHeightmapReady = IsHeightMapReady();
 
-	PerFrame data = {
-		.EnableTerrainShadow = settings.EnableTerrainShadow && isHeightmapReady,
-	};
+	a_data.EnableTerrainShadow = settings.EnableTerrainShadow && isHeightmapReady;
 
 	if (isHeightmapReady) {
 		auto invScale = cachedHeightmap->pos1 - cachedHeightmap->pos0;
-		data.Scale = float3(1.f, 1.f, 1.f) / invScale;
-		data.Offset = -cachedHeightmap->pos0 * float2{ data.Scale.x, data.Scale.y };
-		data.ZRange = cachedHeightmap->zRange;
+		a_data.Scale = float3(1.f, 1.f, 1.f) / invScale;
+		a_data.Offset = -cachedHeightmap->pos0 * float2{ a_data.Scale.x, a_data.Scale.y };
+		a_data.ZRange = cachedHeightmap->zRange;
 	}
-
-	return data;
 }
 
 void TerrainShadows::LoadHeightmap()
@@ -55,7 +55,7 @@ struct TerrainShadows : public Feature
 		float2 Offset;
 	};
 
-	PerFrame GetCommonBufferData();
+	void WriteCommonBufferData(PerFrame& a_data);
 
 	winrt::com_ptr<ID3D11ComputeShader> shadowUpdateProgram = nullptr;
 
@@ -65,6 +65,7 @@ struct TerrainShadows : public Feature
 	bool IsHeightMapReady();
 
 	virtual void SetupResources() override;
+	virtual bool SupportsParallelSetup() const override { return true; }
 	void ParseHeightmapPath(std::filesystem::path p, bool xlodgen_style);
 	void CompileComputeShaders();
 
@@ -151,13 +151,11 @@ void WetnessEffects::DrawSettings()
 	ImGui::Spacing();
 }
 
-WetnessEffects::PerFrame WetnessEffects::GetCommonBufferData()
+void WetnessEffects::WriteCommonBufferData(PerFrame& a_data)
 {
-	PerFrame data{};
-
-	data.Raining = 0.0f;
-	data.Wetness = 0.0f;
-	data.PuddleWetness = 0.0f;
+	a_data.Raining = 0.0f;
+	a_data.Wetness = 0.0f;
+	a_data.PuddleWetness = 0.0f;
 
 	if (settings.EnableWetnessEffects) {
 		if (auto sky = globals::game::sky) {
@@ -176,7 +174,7 @@ WetnessEffects::PerFrame WetnessEffects::GetCommonBufferData()
 							auto shaderProp = netimmerse_cast<RE::BSShaderProperty*>(effect.get());
 							auto particleShaderProperty = netimmerse_cast<RE::BSParticleShaderProperty*>(shaderProp);
 							auto rain = (RE::BSParticleShaderRainEmitter*)(particleShaderProperty->particleEmitter);
-							data.OcclusionViewProj = rain->occlusionProjection;
+							a_data.OcclusionViewProj = rain->occlusionProjection;
 						}
 					}
 
@@ -211,7 +209,7 @@ WetnessEffects::PerFrame WetnessEffects::GetCommonBufferData()
 						}
 					}
 
-					data.Raining = std::min(1.0f, currentRaining + lastRaining);
+					a_data.Raining = std::min(1.0f, currentRaining + lastRaining);
 				}
 
 				auto linearstep = [](float edge0, float edge1, float x) {
@@ -237,8 +235,8 @@ WetnessEffects::PerFrame WetnessEffects::GetCommonBufferData()
 				float wetness = std::min(1.0f, wetnessCurrentWeather + wetnessLastWeather);
 				float puddleWetness = std::min(1.0f, puddleCurrentWeather + puddleLastWeather);
 
-				data.Wetness = wetness;
-				data.PuddleWetness = puddleWetness;
+				a_data.Wetness = wetness;
+				a_data.PuddleWetness = puddleWetness;
 			}
 		}
 	}
@@ -246,19 +244,17 @@ WetnessEffects::PerFrame WetnessEffects::GetCommonBufferData()
 	static size_t rainTimer = 0;  // size_t for precision
 	if (!globals::game::ui->GameIsPaused())
 		rainTimer += (size_t)(RE::GetSecondsSinceLastFrame() * 1000);  // BSTimer::delta is always 0 for some reason
-	data.Time = rainTimer / 1000.f;
+	a_data.Time = rainTimer / 1000.f;
 
-	data.settings = settings;
+	a_data.settings = settings;
 	// Disable Shore Wetness if Wetness Effects are Disabled
-	data.settings.MaxShoreWetness = settings.EnableWetnessEffects ? settings.MaxShoreWetness : 0.0f;
+	a_data.settings.MaxShoreWetness = settings.EnableWetnessEffects ? settings.MaxShoreWetness : 0.0f;
 
 	// Calculating some parameters on cpu
-	data.settings.RaindropChance *= data.Raining * data.Raining;
-	data.settings.RaindropGridSize = 1.0f / settings.RaindropGridSize;
-	data.settings.RaindropInterval = 1.0f / settings.RaindropInterval;
-	data.settings.RippleLifetime = settings.RaindropInterval / settings.RippleLifetime;
-
-	return data;
+	a_data.settings.RaindropChance *= a_data.Raining * a_data.Raining;
+	a_data.settings.RaindropGridSize = 1.0f / settings.RaindropGridSize;
+	a_data.settings.RaindropInterval = 1.0f / settings.RaindropInterval;
+	a_data.settings.RippleLifetime = settings.RaindropInterval / settings.RippleLifetime;
 }
 
 void WetnessEffects::Prepass()
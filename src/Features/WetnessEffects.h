@@ -59,7 +59,7 @@ public:
 
 	Settings settings;
 
-	PerFrame GetCommonBufferData();
+	void WriteCommonBufferData(PerFrame& a_data);
 
 	virtual void Prepass() override;
 
@@ -2,99 +2,135 @@
 
 #include "ShaderTools/BSShaderHooks.h"
 
+#include "Deferred.h"
 #include "Menu.h"
 #include "ShaderCache.h"
 #include "State.h"
 #include "Streamline.h"
 #include "TruePBR.h"
 
-std::unordered_map<void*, std::pair<std::unique_ptr<uint8_t[]>, size_t>> ShaderBytecodeMap;
+// Bytecode is only needed to dump the shaders BSShader::LoadShaders creates, so copies are taken
+// while a load runs on this thread and handed to the dump writer, which frees them once written.
+// Shaders created anywhere else are not copied at all.
+std::unordered_map<void*, std::vector<uint8_t>> ShaderBytecodeMap;
+std::mutex ShaderBytecodeMutex;                     // guard for ShaderBytecodeMap
+thread_local bool CaptureShaderBytecode = false;    // set while BSShader::LoadShaders runs with dumping on
+std::atomic<uint64_t> ShaderBytecodeReleased = 0;   // bytes copied for dumping and freed afterwards
+std::atomic<uint64_t> ShaderBytecodeNotCopied = 0;  // bytes of shaders created outside a load, never copied
+
+Util::AsyncFileWriter& GetShaderDumpWriter()
+{
+	// never destroyed, the detached writer thread may still be running at exit
+	static auto* writer = new Util::AsyncFileWriter(64 * 1024 * 1024);
+	return *writer;
+}
 
 void RegisterShaderBytecode(void* Shader, const void* Bytecode, size_t BytecodeLength)
 {
+	if (!CaptureShaderBytecode) {
+		ShaderBytecodeNotCopied += BytecodeLength;
+		return;
+	}
 	// Grab a copy since the pointer isn't going to be valid forever
-	auto codeCopy = std::make_unique<uint8_t[]>(BytecodeLength);
-	memcpy(codeCopy.get(), Bytecode, BytecodeLength);
+	const auto* code = static_cast<const uint8_t*>(Bytecode);
 	logger::debug(fmt::runtime("Saving shader at index {:x} with {} bytes:\t{:x}"), (std::uintptr_t)Shader, BytecodeLength, (std::uintptr_t)Bytecode);
-	ShaderBytecodeMap.emplace(Shader, std::make_pair(std::move(codeCopy), BytecodeLength));
+	std::lock_guard lock(ShaderBytecodeMutex);
+	ShaderBytecodeMap.insert_or_assign(Shader, std::vector<uint8_t>(code, code + BytecodeLength));
 }
 
-const std::pair<std::unique_ptr<uint8_t[]>, size_t>& GetShaderBytecode(void* Shader)
+std::optional<std::vector<uint8_t>> TakeShaderBytecode(void* Shader)
 {
 	logger::debug(fmt::runtime("Loading shader at index {:x}"), (std::uintptr_t)Shader);
-	return ShaderBytecodeMap.at(Shader);
+	std::lock_guard lock(ShaderBytecodeMutex);
+	auto node = ShaderBytecodeMap.extract(Shader);
+	if (!node)
+		return std::nullopt;
+	return std::move(node.mapped());
+}
+
+void ReleaseShaderBytecode(const char* LoaderType, size_t DumpedCount, uint64_t DumpedBytes)
+{
+	uint64_t bytes = DumpedBytes;
+	{
+		std::lock_guard lock(ShaderBytecodeMutex);
+		for (const auto& [shader, bytecode] : ShaderBytecodeMap)
+			bytes += bytecode.size();
+		ShaderBytecodeMap.clear();
+	}
+	ShaderBytecodeReleased += bytes;
+	constexpr double Megabyte = 1024.0 * 1024.0;
+	logger::info("Queued {} {} shaders for dumping; released {:.1f} KB of bytecode copies ({:.1f} MB released in total, {:.1f} MB of other shaders never copied)",
+		DumpedCount, LoaderType, static_cast<double>(bytes) / 1024.0, static_cast<double>(ShaderBytecodeReleased) / Megabyte, static_cast<double>(ShaderBytecodeNotCopied) / Megabyte);
 }
 
 template <class ShaderType>
-void DumpShader(const REX::BSShader* thisClass, const ShaderType* shader, const std::pair<std::unique_ptr<uint8_t[]>, size_t>& bytecode)
+void DumpShader(const REX::BSShader* thisClass, const ShaderType* shader, std::vector<uint8_t> bytecode)
 {
 	static_assert(std::is_same_v<ShaderType, RE::BSGraphics::VertexShader> || std::is_same_v<ShaderType, RE::BSGraphics::PixelShader>);
 
-	uint8_t* dxbcData = new uint8_t[bytecode.second];
-	size_t dxbcLen = bytecode.second;
-	memcpy(dxbcData, bytecode.first.get(), bytecode.second);
-
 	constexpr auto shaderExtStr = std::is_same_v<ShaderType, RE::BSGraphics::VertexShader> ? "vs" : "ps";
 	constexpr auto shaderTypeStr = std::is_same_v<ShaderType, RE::BSGraphics::VertexShader> ? "vertex" : "pixel";
 
 	std::string dumpDir = std::format("Data\\ShaderDump\\{}\\{:X}.{}.bin", thisClass->m_LoaderType, shader->id, shaderExtStr);
-	auto directoryPath = std::format("Data\\ShaderDump\\{}", thisClass->m_LoaderType);
 	logger::debug(fmt::runtime("Dumping {} shader {} with id {:x} at {}"), shaderTypeStr, thisClass->m_LoaderType, shader->id, dumpDir);
 
-	if (!std::filesystem::is_directory(directoryPath)) {
-		try {
-			std::filesystem::create_directories(directoryPath);
-		} catch (std::filesystem::filesystem_error const& ex) {
-			logger::error("Failed to create folder: {}", ex.what());
-		}
-	}
-
-	if (FILE * file; fopen_s(&file, dumpDir.c_str(), "wb") == 0) {
-		fwrite(dxbcData, 1, dxbcLen, file);
-		fclose(file);
-	}
-
-	delete[] dxbcData;
+	// written in the background so dumping does not slow down loading; the writer creates the folder
+	GetShaderDumpWriter().Write(std::move(dumpDir), std::move(bytecode));
 }
 
 struct BSShader_LoadShaders
 {
 	static void thunk(RE::BSShader* shader, std::uintptr_t stream)
 	{
-		func(shader, stream);
-
 		auto state = globals::state;
 		auto shaderCache = globals::shaderCache;
 		auto truePBR = globals::truePBR;
 
+		const bool dump = shaderCache->IsDump();
+		CaptureShaderBytecode = dump;
+		func(shader, stream);
+		CaptureShaderBytecode = false;
+		size_t dumpedCount = 0;
+		uint64_t dumpedBytes = 0;
+
+		shaderCache->QueueWarmList(*shader);
+
 		if (shaderCache->IsDiskCache() || shaderCache->IsDump()) {
 			if (shaderCache->IsDiskCache()) {
 				truePBR->GenerateShaderPermutations(shader);
 			}
 
 			for (const auto& entry : shader->vertexShaders) {
-				if (entry->shader && shaderCache->IsDump()) {
-					const auto& bytecode = GetShaderBytecode(entry->shader);
-					DumpShader((REX::BSShader*)shader, entry, bytecode);
+				if (entry->shader && dump) {
+					if (auto bytecode = TakeShaderBytecode(entry->shader)) {
+						dumpedCount++;
+						dumpedBytes += bytecode->size();
+						DumpShader((REX::BSShader*)shader, entry, std::move(*bytecode));
+					}
 				}
 				auto vertexShaderDesriptor = entry->id;
 				auto pixelShaderDescriptor = entry->id;
 				state->ModifyShaderLookup(*shader, vertexShaderDesriptor, pixelShaderDescriptor);
-				shaderCache->GetVertexShader(*shader, vertexShaderDesriptor);
+				shaderCache->GetVertexShader(*shader, vertexShaderDesriptor, SIE::CompilationPriority::Predicted);
 			}
 			for (const auto& entry : shader->pixelShaders) {
-				if (entry->shader && shaderCache->IsDump()) {
-					const auto& bytecode = GetShaderBytecode(entry->shader);
-					DumpShader((REX::BSShader*)shader, entry, bytecode);
+				if (entry->shader && dump) {
+					if (auto bytecode = TakeShaderBytecode(entry->shader)) {
+						dumpedCount++;
+						dumpedBytes += bytecode->size();
+						DumpShader((REX::BSShader*)shader, entry, std::move(*bytecode));
+					}
 				}
 				auto vertexShaderDesriptor = entry->id;
 				auto pixelShaderDescriptor = entry->id;
 				state->ModifyShaderLookup(*shader, vertexShaderDesriptor, pixelShaderDescriptor);
-				shaderCache->GetPixelShader(*shader, pixelShaderDescriptor);
+				shaderCache->GetPixelShader(*shader, pixelShaderDescriptor, SIE::CompilationPriority::Predicted);
 				state->ModifyShaderLookup(*shader, vertexShaderDesriptor, pixelShaderDescriptor, true);
-				shaderCache->GetPixelShader(*shader, pixelShaderDescriptor);
+				shaderCache->GetPixelShader(*shader, pixelShaderDescriptor, SIE::CompilationPriority::Predicted);
 			}
 		}
+		if (dump)
+			ReleaseShaderBytecode(((REX::BSShader*)shader)->m_LoaderType, dumpedCount, dumpedBytes);
 		BSShaderHooks::hk_LoadShaders((REX::BSShader*)shader, stream);
 	};
 	static inline REL::Relocation<decltype(thunk)> func;
@@ -104,6 +140,10 @@ bool Hooks::BSShader_BeginTechnique::thunk(RE::BSShader* shader, uint32_t vertex
 {
 	auto state = globals::state;
 	auto shaderCache = globals::shaderCache;
+	auto& profiler = state->drawProfiler;
+
+	auto timer = profiler.Start();
+	profiler.AddTechnique(shader, vertexDescriptor, pixelDescriptor, globals::deferred->deferredPass);
 
 	state->updateShader = true;
 	state->currentShader = shader;
@@ -115,9 +155,13 @@ bool Hooks::BSShader_BeginTechnique::thunk(RE::BSShader* shader, uint32_t vertex
 	state->modifiedPixelDescriptor = pixelDescriptor;
 
 	state->ModifyShaderLookup(*shader, state->modifiedVertexDescriptor, state->modifiedPixelDescriptor);
+	shaderCache->ResolveFallback(*shader, state->modifiedVertexDescriptor, state->modifiedPixelDescriptor, skipPixelShader);
+	profiler.StopTechnique(timer);
 
 	bool shaderFound = func(shader, vertexDescriptor, pixelDescriptor, skipPixelShader);
 
+	timer = profiler.Start();
+
 	if (!shaderFound && shader->shaderType.get() != RE::BSShader::Type::Effect) {
 		RE::BSGraphics::VertexShader* vertexShader = shaderCache->GetVertexShader(*shader, state->modifiedVertexDescriptor);
 		RE::BSGraphics::PixelShader* pixelShader = shaderCache->GetPixelShader(*shader, state->modifiedPixelDescriptor);
@@ -142,6 +186,7 @@ bool Hooks::BSShader_BeginTechnique::thunk(RE::BSShader* shader, uint32_t vertex
 	state->lastModifiedVertexDescriptor = state->modifiedVertexDescriptor;
 	state->lastModifiedPixelDescriptor = state->modifiedPixelDescriptor;
 
+	profiler.StopTechnique(timer);
 	return shaderFound;
 }
 
@@ -168,6 +213,7 @@ struct IDXGISwapChain_Present
 	static HRESULT WINAPI thunk(IDXGISwapChain* This, UINT SyncInterval, UINT Flags)
 	{
 		globals::state->Reset();
+		globals::shaderCache->OnPresent();
 		globals::menu->DrawOverlay();
 
 		auto streamline = globals::streamline;
@@ -179,6 +225,7 @@ struct IDXGISwapChain_Present
 		}
 
 		auto retval = func(This, SyncInterval, Flags);
+		globals::shaderCache->OnPresentEnd();
 		TracyD3D11Collect(globals::state->tracyCtx);
 		return retval;
 	}
@@ -188,7 +235,10 @@ struct IDXGISwapChain_Present
 void Hooks::BSGraphics_SetDirtyStates::thunk(bool isCompute)
 {
 	func(isCompute);
-	globals::state->Draw();
+	auto state = globals::state;
+	auto timer = state->drawProfiler.Start();
+	state->Draw();
+	state->drawProfiler.StopDraw(timer);
 }
 
 struct ID3D11Device_CreateVertexShader
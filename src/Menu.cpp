@@ -790,8 +790,24 @@ void Menu::DrawAdvancedSettings()
 			ImGui::Text(
 				"Number of threads to use to compile shaders while playing game. "
 				"This is activated if the startup compilation is skipped. "
+				"With adaptive background compilation this is the most threads used during gameplay. "
 				"The more threads the faster compilation will finish but may make the system unresponsive. ");
 		}
+		ImGui::Checkbox("Adaptive Background Compilation", &shaderCache->adaptiveBackgroundCompilation);
+		if (auto _tt = Util::HoverTooltipWrapper()) {
+			ImGui::Text(
+				"Adjusts background compiler threads to recent frame times. "
+				"Threads are removed while frames take longer than the frame budget and added back once there is headroom. "
+				"Loading screens and paused menus use all compiler threads.");
+		}
+		if (shaderCache->adaptiveBackgroundCompilation) {
+			ImGui::SliderFloat("Background Frame Budget", &shaderCache->backgroundFrameBudgetMs, 4.0f, 100.0f, "%.1f ms");
+			if (auto _tt = Util::HoverTooltipWrapper()) {
+				ImGui::Text(
+					"Average CPU frame time to stay under while compiling in the background. "
+					"Time spent waiting for vsync or a frame cap is not counted. 16.7 ms is 60 FPS.");
+			}
+		}
 
 		if (ImGui::SliderInt("Test Interval", reinterpret_cast<int*>(&testInterval), 0, 10)) {
 			if (testInterval == 0) {
@@ -823,6 +839,17 @@ void Menu::DrawAdvancedSettings()
 				"Automatically recompile shaders on file change. "
 				"Intended for developing.");
 		}
+		bool recordBuildManifest = shaderCache->IsRecordingBuildManifest();
+		ImGui::TableNextColumn();
+		if (ImGui::Checkbox("Record Cache Build Manifest", &recordBuildManifest)) {
+			shaderCache->SetRecordBuildManifest(recordBuildManifest);
+		}
+		if (auto _tt = Util::HoverTooltipWrapper()) {
+			ImGui::Text(
+				"Records every compiled shader permutation to Data/ShaderCache/BuildManifest.tsv. "
+				"The cs-cache-build tool compiles the manifest into a disk cache outside the game, so it can be shipped prebuilt. "
+				"Saved when unchecked and on game save. Record with developer mode off to match release compile flags.");
+		}
 
 		if (ImGui::Button("Dump Ini Settings", { -1, 0 })) {
 			Util::DumpSettingsOptions();
@@ -851,6 +878,54 @@ void Menu::DrawAdvancedSettings()
 		}
 		if (ImGui::TreeNodeEx("Statistics", ImGuiTreeNodeFlags_DefaultOpen)) {
 			ImGui::Text(std::format("Shader Compiler : {}", shaderCache->GetShaderStatsString()).c_str());
+			ImGui::Text(std::format("Feature Buffer : {}", FeatureBuffer::GetStatsString()).c_str());
+			if (auto ring = globals::state->constantRing; ring && ring->IsSupported()) {
+				auto stats = ring->GetStats();
+				ImGui::Text(std::format("Constant Ring : {} uploads, {} KB, {} wraps", stats.allocations, stats.bytes / 1024, stats.wraps).c_str());
+			}
+			{
+				auto stats = Util::ComputeState::GetStats();
+				auto frames = std::max(globals::state->frameCount, 1u);
+				ImGui::Text(std::format("Compute Bindings : {} of {} calls elided, {} per frame, {} hazards nulled", stats.elided, stats.calls, stats.elided / frames, stats.hazards).c_str());
+			}
+			ImGui::TreePop();
+		}
+		if (ImGui::TreeNodeEx("Draw Path")) {
+			auto& profiler = globals::state->drawProfiler;
+			ImGui::Checkbox("Profile Draw Path", &profiler.enabled);
+			if (auto _tt = Util::HoverTooltipWrapper()) {
+				ImGui::Text(
+					"Times the plugin's work in the technique and draw hooks, excluding the game functions they wrap. "
+					"Adds a little overhead to every draw while enabled. ");
+			}
+			if (profiler.enabled) {
+				auto frame = profiler.GetLastFrame();
+				ImGui::Text(std::format("Last Frame : {} draws, {} techniques, {:.0f} ns per draw", frame.draws, frame.techniques, frame.GetNsPerDraw()).c_str());
+			}
+
+			ImGui::BeginDisabled(profiler.IsRecording());
+			if (ImGui::Button("Record Frame"))
+				profiler.RecordNextFrame();
+			ImGui::EndDisabled();
+			if (auto _tt = Util::HoverTooltipWrapper()) {
+				ImGui::Text("Records the shader techniques of the next frame so they can be replayed through the shader lookups.");
+			}
+
+			static std::optional<Util::DrawPathProfiler::Result> replay;
+			if (!profiler.GetStream().empty() && !profiler.IsRecording()) {
+				ImGui::SameLine();
+				if (ImGui::Button("Replay x100"))
+					replay = globals::state->ReplayDrawStream(100);
+				ImGui::SameLine();
+				if (ImGui::Button("Save Stream"))
+					globals::state->SaveDrawStream("Data/ShaderCache/DrawStream.bin");
+				if (auto _tt = Util::HoverTooltipWrapper()) {
+					ImGui::Text("Saves the recorded techniques to Data/ShaderCache/DrawStream.bin for the headless DrawPathBenchmark.");
+				}
+				ImGui::Text(std::format("Recorded : {} techniques", profiler.GetStream().size()).c_str());
+			}
+			if (replay)
+				ImGui::Text(std::format("Replay : {} techniques, {:.0f} ns per technique", replay->techniques, replay->GetNsPerDraw()).c_str());
 			ImGui::TreePop();
 		}
 		ImGui::Checkbox("Frame Annotations", &globals::state->frameAnnotations);
@@ -13,12 +13,6 @@ namespace SIE
 	{
 		static void GetShaderDefines(const RE::BSShader&, uint32_t, D3D_SHADER_MACRO*);
 		static std::string GetShaderString(ShaderClass, const RE::BSShader&, uint32_t, bool = false);
-		/**
-		@brief Get the BSShader::Type from the ShaderString
-		@param a_key The key generated from GetShaderString
-		@return A string with a valid BSShader::Type
-		*/
-		static std::string GetTypeFromShaderString(const std::string&);
 		constexpr const char* VertexShaderProfile = "vs_5_0";
 		constexpr const char* PixelShaderProfile = "ps_5_0";
 		constexpr const char* ComputeShaderProfile = "cs_5_0";
@@ -1215,17 +1209,252 @@ namespace SIE
 			mapBufferConsts("PerGeometry", bufferSizes[2]);
 		}
 
-		std::wstring GetDiskPath(const std::string_view& name, uint32_t descriptor, ShaderClass shaderClass)
+		static std::span<const uint8_t> GetBytecode(ID3DBlob& a_blob)
 		{
-			switch (shaderClass) {
-			case ShaderClass::Pixel:
-				return std::format(L"Data/ShaderCache/{}/{:X}.pso", std::wstring(name.begin(), name.end()), descriptor);
-			case ShaderClass::Vertex:
-				return std::format(L"Data/ShaderCache/{}/{:X}.vso", std::wstring(name.begin(), name.end()), descriptor);
-			case ShaderClass::Compute:
-				return std::format(L"Data/ShaderCache/{}/{:X}.cso", std::wstring(name.begin(), name.end()), descriptor);
+			return { static_cast<const uint8_t*>(a_blob.GetBufferPointer()), a_blob.GetBufferSize() };
+		}
+
+		/**
+		 * Fills the constant buffer layout of a shader blob, from the reflection metadata stored in the
+		 * disk archive if available, otherwise by reflecting the blob and storing the result.
+		 * @return false if the blob could not be reflected.
+		 */
+		template <size_t MaxOffsetsSize>
+		static bool GetConstantBufferLayout(ID3DBlob& shaderData,
+			std::array<size_t, 3>& bufferSizes,
+			std::array<int8_t, MaxOffsetsSize>& constantOffsets,
+			uint64_t& vertexDesc,
+			ShaderClass shaderClass, uint32_t descriptor, const RE::BSShader& shader)
+		{
+			auto& cache = ShaderCache::Instance();
+			const auto start = high_resolution_clock::now();
+
+			// the layout depends only on the bytecode and on the variable tables of this plugin version
+			uint64_t metadataKey = 0;
+			ReflectionMetadata<MaxOffsetsSize> metadata;
+			if (cache.IsDiskCache()) {
+				metadataKey = ContentKey::HashCombine(SHADER_CACHE_FORMAT, std::format("reflection:{}:{}:{}", SHADER_CACHE_VERSION.string(),
+																   magic_enum::enum_name(shader.shaderType.get()), magic_enum::enum_name(shaderClass)));
+				metadataKey = ContentKey::HashCombine(metadataKey, { static_cast<const char*>(shaderData.GetBufferPointer()), shaderData.GetBufferSize() });
+				auto stored = cache.GetDiskArchive(shader.fxpFilename).Find(metadataKey);
+				if (stored && metadata.Deserialize(stored.data)) {
+					bufferSizes = metadata.bufferSizes;
+					constantOffsets = metadata.constantOffsets;
+					vertexDesc = metadata.vertexDesc;
+					cache.AddConstantLayoutTime(true, duration_cast<microseconds>(high_resolution_clock::now() - start));
+					return true;
+				}
+			}
+
+			winrt::com_ptr<ID3D11ShaderReflection> reflector;
+			const auto reflectionResult = D3DReflect(shaderData.GetBufferPointer(), shaderData.GetBufferSize(),
+				IID_PPV_ARGS(&reflector));
+			if (FAILED(reflectionResult)) {
+				logger::error("Failed to reflect {} shader {}::{:X}", magic_enum::enum_name(shaderClass),
+					magic_enum::enum_name(shader.shaderType.get()), descriptor);
+				return false;
+			}
+			ReflectConstantBuffers(*reflector.get(), metadata.bufferSizes, metadata.constantOffsets, metadata.vertexDesc,
+				shaderClass, descriptor, shader);
+			bufferSizes = metadata.bufferSizes;
+			constantOffsets = metadata.constantOffsets;
+			vertexDesc = metadata.vertexDesc;
+
+			if (metadataKey) {
+				auto& archive = cache.GetDiskArchive(shader.fxpFilename);
+				if (!archive.Append(metadataKey, metadata.Serialize())) {
+					logger::error("Failed to save reflection metadata to {}", archive.GetPath().string());
+				}
+			}
+			cache.AddConstantLayoutTime(false, duration_cast<microseconds>(high_resolution_clock::now() - start));
+			return true;
+		}
+
+		/**
+		 * Include handler that resolves files like the standard one (relative to the including
+		 * file, then the shader root) and records every file it opens, which gives the full
+		 * transitive include set of a permutation.
+		 */
+		class DependencyInclude : public ID3DInclude
+		{
+		public:
+			explicit DependencyInclude(const std::filesystem::path& a_sourcePath) :
+				sourceDirectory(a_sourcePath.parent_path()) {}
+
+			HRESULT STDMETHODCALLTYPE Open([[maybe_unused]] D3D_INCLUDE_TYPE IncludeType, LPCSTR pFileName, LPCVOID pParentData, LPCVOID* ppData, UINT* pBytes) override
+			{
+				*ppData = nullptr;
+				*pBytes = 0;
+
+				auto parentIt = openFiles.find(pParentData);
+				const auto& parentDirectory = parentIt != openFiles.end() ? parentIt->second.directory : sourceDirectory;
+				for (const auto& directory : { parentDirectory, ShaderRoot }) {
+					const auto filePath = (directory / pFileName).lexically_normal();
+					auto contents = ShaderCache::Instance().GetIncludeCache().Get(filePath);
+					if (!contents)
+						continue;
+
+					includes.insert(Util::FixFilePath(filePath.string()));
+					*ppData = contents->data();
+					*pBytes = static_cast<UINT>(contents->size());
+					// every include of the same file shares one cached buffer, so opens are counted per buffer
+					auto it = openFiles.try_emplace(contents->data(), OpenFile{ contents, filePath.parent_path() }).first;
+					it->second.openCount++;
+					return S_OK;
+				}
+				return E_FAIL;
+			}
+
+			HRESULT STDMETHODCALLTYPE Close(LPCVOID pData) override
+			{
+				auto it = openFiles.find(pData);
+				if (it != openFiles.end() && --it->second.openCount == 0)
+					openFiles.erase(it);
+				return S_OK;
+			}
+
+			const std::set<std::string>& GetIncludes() const { return includes; }
+
+		private:
+			struct OpenFile
+			{
+				IncludeCache::Contents contents;
+				std::filesystem::path directory;
+				uint32_t openCount = 0;
+			};
+
+			inline static const std::filesystem::path ShaderRoot = L"Data/Shaders";
+
+			std::filesystem::path sourceDirectory;
+			std::unordered_map<const void*, OpenFile> openFiles;
+			std::set<std::string> includes;  // normalized paths of every included file
+		};
+
+		/**
+		 * Derives the content-addressed archive key of a permutation from its fully
+		 * preprocessed source, define set, profile and compile flags.
+		 * Any edit to the shader, one of its includes or the active defines yields a new key,
+		 * so cached blobs stay valid across plugin and feature updates that do not touch them.
+		 * @return 0 if the source could not be preprocessed.
+		 */
+		static uint64_t GetContentKey(const std::filesystem::path& a_path, const D3D_SHADER_MACRO* a_defines, const std::string& a_mergedDefines, ID3DInclude* a_include, const char* a_profile, uint32_t a_flags, uint32_t a_stripFlags)
+		{
+			const auto source = ShaderCache::Instance().GetIncludeCache().Get(a_path);
+			if (!source)
+				return 0;
+			const auto sourceName = a_path.string();
+
+			winrt::com_ptr<ID3DBlob> preprocessed;
+			winrt::com_ptr<ID3DBlob> errors;
+			if (FAILED(D3DPreprocess(source->data(), source->size(), sourceName.c_str(), a_defines, a_include, preprocessed.put(), errors.put()))) {
+				logger::debug("Failed to preprocess {} for cache key:\n{}", sourceName, errors ? static_cast<char*>(errors->GetBufferPointer()) : "");
+				return 0;
+			}
+
+			return ContentKey::Get({ static_cast<const char*>(preprocessed->GetBufferPointer()), preprocessed->GetBufferSize() },
+				a_mergedDefines, a_profile, a_flags, a_stripFlags);
+		}
+
+		/**
+		 * Exposes a blob served from a ShaderArchive as an ID3DBlob without copying it.
+		 * Completed shaders keep their blob for the whole session, and with it the archive
+		 * mapping; ShaderArchive moves such files aside when it compacts or deletes them.
+		 */
+		class ArchiveBlob : public ID3DBlob
+		{
+		public:
+			explicit ArchiveBlob(ShaderArchive::Blob a_blob) :
+				blob(std::move(a_blob)) {}
+
+			HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppvObject) override
+			{
+				if (!ppvObject)
+					return E_POINTER;
+				if (riid == __uuidof(IUnknown) || riid == __uuidof(ID3D10Blob)) {
+					*ppvObject = static_cast<ID3DBlob*>(this);
+					AddRef();
+					return S_OK;
+				}
+				*ppvObject = nullptr;
+				return E_NOINTERFACE;
+			}
+
+			ULONG STDMETHODCALLTYPE AddRef() override { return ++refCount; }
+
+			ULONG STDMETHODCALLTYPE Release() override
+			{
+				const ULONG count = --refCount;
+				if (count == 0)
+					delete this;
+				return count;
+			}
+
+			// the mapping is read-only; D3D never writes through the pointer
+			LPVOID STDMETHODCALLTYPE GetBufferPointer() override { return const_cast<uint8_t*>(blob.data.data()); }
+			SIZE_T STDMETHODCALLTYPE GetBufferSize() override { return blob.data.size(); }
+
+		private:
+			~ArchiveBlob() = default;
+
+			ShaderArchive::Blob blob;
+			std::atomic<ULONG> refCount = 1;
+		};
+
+		/**
+		 * Compiles a shader requested through Util::CompileShader. Uses the same include
+		 * resolution and content key as BSShader permutations, stored in the permutation's archive.
+		 */
+		static winrt::com_ptr<ID3DBlob> CompileUtilityShader(const BuildManifest::Permutation& a_permutation, const char* a_entryPoint)
+		{
+			auto& cache = ShaderCache::Instance();
+			const std::filesystem::path path = a_permutation.source;
+			std::vector<D3D_SHADER_MACRO> macros;
+			for (const auto& [name, definition] : a_permutation.defines)
+				macros.push_back({ name.c_str(), definition.c_str() });
+			macros.push_back({ nullptr, nullptr });
+
+			DependencyInclude include(path);
+			uint64_t archiveKey = 0;
+			if (cache.IsDiskCache()) {
+				const auto keyProfile = std::string_view(a_entryPoint) == "main" ? a_permutation.profile : fmt::format("{}:{}", a_permutation.profile, a_entryPoint);
+				archiveKey = GetContentKey(path, macros.data(), ContentKey::MergeDefines(a_permutation.defines), &include, keyProfile.c_str(), a_permutation.flags, a_permutation.stripFlags);
+				auto& archive = cache.GetDiskArchive(a_permutation.archive);
+				if (auto archived = archiveKey ? archive.Find(archiveKey) : ShaderArchive::Blob{}) {
+					logger::debug("Loaded {} from {}", a_permutation.source, archive.GetPath().string());
+					cache.IndexArchivedShader(a_permutation.archive, archiveKey, ArchiveIndex::NoType, a_permutation.source, include.GetIncludes());
+					winrt::com_ptr<ID3DBlob> blob;
+					blob.attach(new ArchiveBlob(archived));
+					return blob;
+				}
+			}
+
+			winrt::com_ptr<ID3DBlob> blob;
+			winrt::com_ptr<ID3DBlob> errors;
+			HRESULT compileResult = E_FAIL;
+			if (const auto source = cache.GetIncludeCache().Get(path))
+				compileResult = D3DCompile(source->data(), source->size(), a_permutation.source.c_str(), macros.data(), &include, a_entryPoint,
+					a_permutation.profile.c_str(), a_permutation.flags, 0, blob.put(), errors.put());
+			if (FAILED(compileResult)) {
+				logger::warn("Shader compilation failed:\n\n{}", errors ? static_cast<char*>(errors->GetBufferPointer()) : "Unknown error");
+				return nullptr;
+			}
+			if (errors)
+				logger::debug("Shader logs:\n{}", static_cast<char*>(errors->GetBufferPointer()));
+
+			if (a_permutation.stripFlags) {
+				winrt::com_ptr<ID3DBlob> stripped;
+				if (SUCCEEDED(D3DStripShader(blob->GetBufferPointer(), blob->GetBufferSize(), a_permutation.stripFlags, stripped.put())))
+					blob = std::move(stripped);
+			}
+
+			if (archiveKey) {
+				auto& archive = cache.GetDiskArchive(a_permutation.archive);
+				if (!archive.Append(archiveKey, { static_cast<const uint8_t*>(blob->GetBufferPointer()), blob->GetBufferSize() }))
+					logger::error("Failed to save shader to {}", archive.GetPath().string());
+				else
+					cache.IndexArchivedShader(a_permutation.archive, archiveKey, ArchiveIndex::NoType, a_permutation.source, include.GetIncludes());
 			}
-			return {};
+			return blob;
 		}
 
 		static std::string GetShaderString(ShaderClass shaderClass, const RE::BSShader& shader, uint32_t descriptor, bool hashkey)
@@ -1241,17 +1470,6 @@ namespace SIE
 			return result;
 		}
 
-		std::string GetTypeFromShaderString(const std::string& a_key)
-		{
-			std::string type = "";
-			std::string::size_type pos = a_key.find(':');
-			if (pos != std::string::npos)
-				type = a_key.substr(0, pos);
-			if (type.starts_with("IS") || type == "ReflectionsRayTracing")
-				type = "ImageSpace";  // fix type for image space shaders
-			return type;
-		}
-
 		static ID3DBlob* CompileShader(ShaderClass shaderClass, const RE::BSShader& shader, uint32_t descriptor, bool useDiskCache)
 		{
 			// check hashmap
@@ -1266,27 +1484,6 @@ namespace SIE
 			}
 			const auto type = shader.shaderType.get();
 
-			// check diskcache
-			auto diskPath = GetDiskPath(shader.fxpFilename, descriptor, shaderClass);
-
-			if (useDiskCache && std::filesystem::exists(diskPath)) {
-				// check build time of cache
-				auto diskCacheTime = cache.UseFileWatcher() ? std::chrono::clock_cast<std::chrono::system_clock>(std::filesystem::last_write_time(diskPath)) : system_clock::now();
-				if (cache.ShaderModifiedSince(shader.fxpFilename, diskCacheTime)) {
-					logger::debug("Diskcached shader {} older than {}", SIE::SShaderCache::GetShaderString(shaderClass, shader, descriptor, true), std::format("{:%Y%m%d%H%M}", diskCacheTime));
-				} else if (FAILED(D3DReadFileToBlob(diskPath.c_str(), &shaderBlob))) {
-					logger::error("Failed to load {} shader {}::{:X}", magic_enum::enum_name(shaderClass), magic_enum::enum_name(type), descriptor);
-
-					if (shaderBlob != nullptr) {
-						shaderBlob->Release();
-					}
-				} else {
-					logger::debug("Loaded shader from {}", Util::WStringToString(diskPath));
-					cache.AddCompletedShader(shaderClass, shader, descriptor, shaderBlob);
-					return shaderBlob;
-				}
-			}
-
 			// prepare preprocessor defines
 			std::array<D3D_SHADER_MACRO, 64> defines{};
 			auto lastIndex = 0;
@@ -1320,13 +1517,48 @@ namespace SIE
 				logger::error("Failed to compile {} shader {}::{:X}: {} does not exist", magic_enum::enum_name(shaderClass), magic_enum::enum_name(type), descriptor, pathString);
 				return nullptr;
 			}
+
+			const uint32_t flags = !globals::state->IsDeveloperMode() ? D3DCOMPILE_OPTIMIZATION_LEVEL3 : D3DCOMPILE_DEBUG;
+			const uint32_t stripFlags = !globals::state->IsDeveloperMode() ?
+			                                D3DCOMPILER_STRIP_DEBUG_INFO | D3DCOMPILER_STRIP_TEST_BLOBS | D3DCOMPILER_STRIP_PRIVATE_DATA :
+			                                0;
+
+			DependencyInclude include(path);
+			if (cache.IsRecordingBuildManifest()) {
+				BuildManifest::Permutation permutation{ shader.fxpFilename, pathString, GetShaderProfile(shaderClass), flags, stripFlags };
+				for (const auto& define : defines) {
+					if (define.Name == nullptr)
+						break;
+					permutation.defines.emplace_back(define.Name, define.Definition ? define.Definition : "");
+				}
+				cache.RecordBuildPermutation(permutation);
+			}
+
+			// check diskcache
+			uint64_t archiveKey = 0;
+			if (useDiskCache) {
+				archiveKey = GetContentKey(path, defines.data(), MergeDefinesString(defines), &include, GetShaderProfile(shaderClass), flags, stripFlags);
+				auto& archive = cache.GetDiskArchive(shader.fxpFilename);
+				if (auto archived = archiveKey ? archive.Find(archiveKey) : ShaderArchive::Blob{}) {
+					shaderBlob = new ArchiveBlob(archived);
+					logger::debug("Loaded shader {}:{}:{:X} from {}", magic_enum::enum_name(type), magic_enum::enum_name(shaderClass), descriptor, archive.GetPath().string());
+					cache.IncDiskCacheHits();
+					cache.AddCompletedShader(shaderClass, shader, descriptor, shaderBlob, archiveKey, include.GetIncludes());
+					return shaderBlob;
+				}
+				cache.IncDiskCacheMisses();
+			}
+
 			logger::debug("Compiling {} {}:{}:{:X} to {}", pathString, magic_enum::enum_name(type), magic_enum::enum_name(shaderClass), descriptor, MergeDefinesString(defines));
 
 			// compile shaders
+			// the source comes from the include cache, which GetContentKey above has usually just filled
 			ID3DBlob* errorBlob = nullptr;
-			const uint32_t flags = !globals::state->IsDeveloperMode() ? D3DCOMPILE_OPTIMIZATION_LEVEL3 : D3DCOMPILE_DEBUG;
-			const HRESULT compileResult = D3DCompileFromFile(path.c_str(), defines.data(), D3D_COMPILE_STANDARD_FILE_INCLUDE, "main",
-				GetShaderProfile(shaderClass), flags, 0, &shaderBlob, &errorBlob);
+			HRESULT compileResult = E_FAIL;
+			const auto compileStart = high_resolution_clock::now();
+			if (const auto source = cache.GetIncludeCache().Get(path))
+				compileResult = D3DCompile(source->data(), source->size(), pathString.c_str(), defines.data(), &include, "main",
+					GetShaderProfile(shaderClass), flags, 0, &shaderBlob, &errorBlob);
 
 			if (FAILED(compileResult)) {
 				if (errorBlob != nullptr) {
@@ -1350,37 +1582,25 @@ namespace SIE
 			logger::debug("Compiled shader {}:{}:{:X}", magic_enum::enum_name(type), magic_enum::enum_name(shaderClass), descriptor);
 
 			// strip debug info
-			if (!globals::state->IsDeveloperMode()) {
+			if (stripFlags) {
 				ID3DBlob* strippedShaderBlob = nullptr;
-
-				const uint32_t stripFlags = D3DCOMPILER_STRIP_DEBUG_INFO |
-				                            D3DCOMPILER_STRIP_TEST_BLOBS |
-				                            D3DCOMPILER_STRIP_PRIVATE_DATA;
-
 				D3DStripShader(shaderBlob->GetBufferPointer(), shaderBlob->GetBufferSize(), stripFlags, &strippedShaderBlob);
 				std::swap(shaderBlob, strippedShaderBlob);
 				strippedShaderBlob->Release();
 			}
+			cache.RecordCompileTime(shaderClass, shader, descriptor, duration<float, std::milli>(high_resolution_clock::now() - compileStart).count());
 
 			// save shader to disk
-			if (useDiskCache) {
-				auto directoryPath = std::format("Data/ShaderCache/{}", shader.fxpFilename);
-				if (!std::filesystem::is_directory(directoryPath)) {
-					try {
-						std::filesystem::create_directories(directoryPath);
-					} catch (std::filesystem::filesystem_error const& ex) {
-						logger::error("Failed to create folder: {}", ex.what());
-					}
-				}
-
-				const HRESULT saveResult = D3DWriteBlobToFile(shaderBlob, diskPath.c_str(), true);
-				if (FAILED(saveResult)) {
-					logger::error("Failed to save shader to {}", Util::WStringToString(diskPath));
+			if (useDiskCache && archiveKey) {
+				auto& archive = cache.GetDiskArchive(shader.fxpFilename);
+				const std::span<const uint8_t> bytecode{ static_cast<const uint8_t*>(shaderBlob->GetBufferPointer()), shaderBlob->GetBufferSize() };
+				if (!archive.Append(archiveKey, bytecode)) {
+					logger::error("Failed to save shader to {}", archive.GetPath().string());
 				} else {
-					logger::debug("Saved shader to {}", Util::WStringToString(diskPath));
+					logger::debug("Saved shader to {}", archive.GetPath().string());
 				}
 			}
-			cache.AddCompletedShader(shaderClass, shader, descriptor, shaderBlob);
+			cache.AddCompletedShader(shaderClass, shader, descriptor, shaderBlob, archiveKey, include.GetIncludes());
 			return shaderBlob;
 		}
 
@@ -1405,17 +1625,10 @@ namespace SIE
 			newShader->id = descriptor;
 			newShader->shaderDesc = 0;
 
-			winrt::com_ptr<ID3D11ShaderReflection> reflector;
-			const auto reflectionResult = D3DReflect(shaderData.GetBufferPointer(), shaderData.GetBufferSize(),
-				IID_PPV_ARGS(&reflector));
-			if (FAILED(reflectionResult)) {
-				logger::error("Failed to reflect vertex shader {}::{:X}", magic_enum::enum_name(shader.shaderType.get()),
-					descriptor);
-			} else {
-				std::array<size_t, 3> bufferSizes = { 0, 0, 0 };
-				std::fill(newShader->constantTable.begin(), newShader->constantTable.end(), static_cast<uint8_t>(0));
-				ReflectConstantBuffers(*reflector.get(), bufferSizes, newShader->constantTable, newShader->shaderDesc,
-					ShaderClass::Vertex, descriptor, shader);
+			std::array<size_t, 3> bufferSizes = { 0, 0, 0 };
+			std::fill(newShader->constantTable.begin(), newShader->constantTable.end(), static_cast<uint8_t>(0));
+			if (GetConstantBufferLayout(shaderData, bufferSizes, newShader->constantTable, newShader->shaderDesc,
+					ShaderClass::Vertex, descriptor, shader)) {
 				if (bufferSizes[0] != 0) {
 					newShader->constantBuffers[0].buffer =
 						(REX::W32::ID3D11Buffer*)perTechniqueBuffersArray.get()[bufferSizes[0]];
@@ -1456,19 +1669,12 @@ namespace SIE
 			auto newShader = std::make_unique<RE::BSGraphics::PixelShader>();
 			newShader->id = descriptor;
 
-			winrt::com_ptr<ID3D11ShaderReflection> reflector;
-			const auto reflectionResult = D3DReflect(shaderData.GetBufferPointer(),
-				shaderData.GetBufferSize(), IID_PPV_ARGS(&reflector));
-			if (FAILED(reflectionResult)) {
-				logger::error("Failed to reflect vertex shader {}::{:X}", magic_enum::enum_name(shader.shaderType.get()),
-					descriptor);
-			} else {
-				std::array<size_t, 3> bufferSizes = { 0, 0, 0 };
-				std::ranges::fill(newShader->constantTable, (int8_t)0);
-				uint64_t dummy;
-				ReflectConstantBuffers(*reflector.get(), bufferSizes, newShader->constantTable,
+			std::array<size_t, 3> bufferSizes = { 0, 0, 0 };
+			std::ranges::fill(newShader->constantTable, (int8_t)0);
+			uint64_t dummy = 0;
+			if (GetConstantBufferLayout(shaderData, bufferSizes, newShader->constantTable,
 					dummy,
-					ShaderClass::Pixel, descriptor, shader);
+					ShaderClass::Pixel, descriptor, shader)) {
 				if (bufferSizes[0] != 0) {
 					newShader->constantBuffers[0].buffer =
 						(REX::W32::ID3D11Buffer*)perTechniqueBuffersArray.get()[bufferSizes[0]];
@@ -1659,7 +1865,7 @@ namespace SIE
 	}
 
 	RE::BSGraphics::VertexShader* ShaderCache::GetVertexShader(const RE::BSShader& shader,
-		uint32_t descriptor)
+		uint32_t descriptor, CompilationPriority priority)
 	{
 		if (shader.shaderType == RE::BSShader::Type::ImageSpace) {
 			const auto& isShader = static_cast<const RE::BSImagespaceShader&>(shader);
@@ -1688,17 +1894,17 @@ namespace SIE
 			}
 		}
 
-		{
-			std::lock_guard lockGuard(vertexShadersMutex);
-			auto& typeCache = vertexShaders[static_cast<size_t>(shader.shaderType.underlying())];
-			auto it = typeCache.find(descriptor);
-			if (it != typeCache.end()) {
-				return it->second.get();
-			}
-		}
+		// an entry refreshes its warm list age on its first hit only, so later hits stay lock free
+		const auto found = DrawPath::Find(vertexShaders[static_cast<size_t>(shader.shaderType.underlying())], descriptor, priority, CanRecordWarmPermutation(shader, priority));
+		if (found.record)
+			RecordWarmPermutation(ShaderClass::Vertex, shader, descriptor);
+		if (found.shader)
+			return found.shader;
 
 		if (IsAsync()) {
-			compilationSet.Add({ ShaderClass::Vertex, shader, descriptor });
+			// the mark keeps misses of queued permutations off the compilation set's mutex
+			if (found.queue)
+				compilationSet.Add({ ShaderClass::Vertex, shader, descriptor }, priority);
 		} else {
 			return MakeAndAddVertexShader(shader, descriptor);
 		}
@@ -1707,7 +1913,7 @@ namespace SIE
 	}
 
 	RE::BSGraphics::PixelShader* ShaderCache::GetPixelShader(const RE::BSShader& shader,
-		uint32_t descriptor)
+		uint32_t descriptor, CompilationPriority priority)
 	{
 		auto state = globals::state;
 		if (globals::game::isVR && strcmp(shader.fxpFilename, "OBBOcclusionTesting") == 0)
@@ -1736,17 +1942,17 @@ namespace SIE
 			}
 		}
 
-		{
-			std::lock_guard lockGuard(pixelShadersMutex);
-			auto& typeCache = pixelShaders[static_cast<size_t>(shader.shaderType.underlying())];
-			auto it = typeCache.find(descriptor);
-			if (it != typeCache.end()) {
-				return it->second.get();
-			}
-		}
+		// an entry refreshes its warm list age on its first hit only, so later hits stay lock free
+		const auto found = DrawPath::Find(pixelShaders[static_cast<size_t>(shader.shaderType.underlying())], descriptor, priority, CanRecordWarmPermutation(shader, priority));
+		if (found.record)
+			RecordWarmPermutation(ShaderClass::Pixel, shader, descriptor);
+		if (found.shader)
+			return found.shader;
 
 		if (IsAsync()) {
-			compilationSet.Add({ ShaderClass::Pixel, shader, descriptor });
+			// the mark keeps misses of queued permutations off the compilation set's mutex
+			if (found.queue)
+				compilationSet.Add({ ShaderClass::Pixel, shader, descriptor }, priority);
 		} else {
 			return MakeAndAddPixelShader(shader, descriptor);
 		}
@@ -1755,7 +1961,7 @@ namespace SIE
 	}
 
 	RE::BSGraphics::ComputeShader* ShaderCache::GetComputeShader(const RE::BSShader& shader,
-		uint32_t descriptor)
+		uint32_t descriptor, CompilationPriority priority)
 	{
 		auto state = globals::state;
 		if (!((ShaderCache::IsSupportedShader(shader) || state->IsDeveloperMode() && state->IsShaderEnabled(shader)) && state->enableCShaders)) {
@@ -1780,17 +1986,17 @@ namespace SIE
 			}
 		}
 
-		{
-			std::lock_guard lockGuard(computeShadersMutex);
-			auto& typeCache = computeShaders[static_cast<size_t>(shader.shaderType.underlying())];
-			auto it = typeCache.find(descriptor);
-			if (it != typeCache.end()) {
-				return it->second.get();
-			}
-		}
+		// an entry refreshes its warm list age on its first hit only, so later hits stay lock free
+		const auto found = DrawPath::Find(computeShaders[static_cast<size_t>(shader.shaderType.underlying())], descriptor, priority, CanRecordWarmPermutation(shader, priority));
+		if (found.record)
+			RecordWarmPermutation(ShaderClass::Compute, shader, descriptor);
+		if (found.shader)
+			return found.shader;
 
 		if (IsAsync()) {
-			compilationSet.Add({ ShaderClass::Compute, shader, descriptor });
+			// the mark keeps misses of queued permutations off the compilation set's mutex
+			if (found.queue)
+				compilationSet.Add({ ShaderClass::Compute, shader, descriptor }, priority);
 		} else {
 			return MakeAndAddComputeShader(shader, descriptor);
 		}
@@ -1798,6 +2004,62 @@ namespace SIE
 		return nullptr;
 	}
 
+	void ShaderCache::SetPendingMark(const ShaderCompilationTask& task, uint8_t mark)
+	{
+		const auto key = task.GetKey();
+		const auto type = static_cast<size_t>(key.GetType());
+		switch (key.GetClass()) {
+		case ShaderClass::Vertex:
+			vertexShaders[type].SetMark(key.GetDescriptor(), mark);
+			break;
+		case ShaderClass::Pixel:
+			pixelShaders[type].SetMark(key.GetDescriptor(), mark);
+			break;
+		case ShaderClass::Compute:
+			computeShaders[type].SetMark(key.GetDescriptor(), mark);
+			break;
+		default:
+			break;
+		}
+	}
+
+	void ShaderCache::ClearPendingMarks()
+	{
+		for (size_t type = 0; type < vertexShaders.size(); type++) {
+			vertexShaders[type].ClearMarks();
+			pixelShaders[type].ClearMarks();
+			computeShaders[type].ClearMarks();
+		}
+	}
+
+	bool ShaderCache::ResolveFallback(const RE::BSShader& shader, uint32_t& vertexDescriptor, uint32_t& pixelDescriptor, bool skipPixelShader)
+	{
+		const auto type = shader.shaderType.get();
+		const auto flags = DrawPath::GetFallbackFlags(static_cast<ShaderType>(type));
+		if (!IsEnabled() || !IsAsync() || (flags.pixel | flags.shared) == 0 || !globals::state->enabledClasses[type - 1])
+			return false;
+
+		const uint32_t exactVertexDescriptor = vertexDescriptor;
+		const uint32_t exactPixelDescriptor = pixelDescriptor;
+		// queue the exact permutations, since the draw hooks will only see the fallback descriptors
+		const auto queue = [&](bool a_vertexMissing, bool a_pixelMissing) {
+			if (a_vertexMissing)
+				GetVertexShader(shader, exactVertexDescriptor);
+			if (a_pixelMissing)
+				GetPixelShader(shader, exactPixelDescriptor);
+		};
+		switch (DrawPath::FindFallback(vertexShaders[static_cast<size_t>(type)], pixelShaders[static_cast<size_t>(type)], flags, vertexDescriptor, pixelDescriptor, skipPixelShader, queue)) {
+		case DrawPath::Fallback::Substituted:
+			fallbackDraws++;
+			return true;
+		case DrawPath::Fallback::NotFound:
+			fallbackMisses++;
+			return false;
+		default:
+			return false;
+		}
+	}
+
 	ShaderCache::~ShaderCache()
 	{
 		Clear();
@@ -1810,44 +2072,52 @@ namespace SIE
 		}
 	}
 
+	void ShaderCache::ReleaseShaderObject(RE::BSGraphics::VertexShader& a_shader)
+	{
+		vertexShaderObjects.Release(a_shader.shader);
+	}
+
+	void ShaderCache::ReleaseShaderObject(RE::BSGraphics::PixelShader& a_shader)
+	{
+		pixelShaderObjects.Release(a_shader.shader);
+	}
+
+	void ShaderCache::ReleaseShaderObject(RE::BSGraphics::ComputeShader& a_shader)
+	{
+		computeShaderObjects.Release(a_shader.shader);
+	}
+
 	void ShaderCache::Clear()
 	{
-		{
-			std::lock_guard lockGuardV(vertexShadersMutex);
-			for (auto& shaders : vertexShaders) {
-				for (auto& [id, shader] : shaders) {
-					shader->shader->Release();
-				}
-				shaders.clear();
-			}
+		// releases the D3D object of a cached shader before it is dropped from its lookup
+		const auto releaseShaderObject = [this](auto& a_shader) { ReleaseShaderObject(a_shader); };
+		for (auto& shaders : vertexShaders) {
+			shaders.Clear(releaseShaderObject);
 		}
-		{
-			std::lock_guard lockGuardP(pixelShadersMutex);
-			for (auto& shaders : pixelShaders) {
-				for (auto& [id, shader] : shaders) {
-					shader->shader->Release();
-				}
-				shaders.clear();
-			}
+		for (auto& shaders : pixelShaders) {
+			shaders.Clear(releaseShaderObject);
 		}
-		{
-			std::lock_guard lockGuardC(computeShadersMutex);
-			for (auto& shaders : computeShaders) {
-				for (auto& [id, shader] : shaders) {
-					shader->shader->Release();
-				}
-				shaders.clear();
-			}
+		for (auto& shaders : computeShaders) {
+			shaders.Clear(releaseShaderObject);
 		}
 		{
 			std::unique_lock lockM{ mapMutex };
 			shaderMap.clear();
+			for (auto& keys : shaderMapByType)
+				keys.clear();
 		}
 		{
 			std::unique_lock lockH{ hlslMapMutex };
 			hlslToShaderMap.clear();
+			shaderDependencies.clear();
 		}
 		compilationSet.Clear();
+		includeCache.Clear();
+		{
+			// features recompile below, which must see edited sources rather than a prefetch
+			std::lock_guard lockU{ utilityPrefetchMutex };
+			utilityPrefetch.clear();
+		}
 		globals::deferred->ClearShaderCache();
 		for (auto* feature : Feature::GetFeatureList()) {
 			if (feature->loaded) {
@@ -1856,25 +2126,42 @@ namespace SIE
 		}
 	}
 
-	template <typename ShaderType, typename MutexType>
-	void ReleaseShader(ShaderType& shaders,
-		MutexType& mutex, RE::BSShader::Type type, uint32_t descriptor)
+	template <typename ShaderType, typename F>
+	void ReleaseShader(ShaderType& shaders, RE::BSShader::Type type, uint32_t descriptor, F&& release)
 	{
-		std::lock_guard<MutexType> lockGuard(mutex);
-
 		if (static_cast<size_t>(type) < shaders.size()) {
-			auto& shaderMap = shaders[static_cast<size_t>(type)];
-			auto shaderIt = shaderMap.find(descriptor);
-			if (shaderIt != shaderMap.end()) {
-				auto& shaderPtr = shaderIt->second;
-				if (shaderPtr && shaderPtr->shader) {
-					shaderPtr->shader->Release();
-				}
-				shaderMap.erase(shaderIt);
-			}
+			shaders[static_cast<size_t>(type)].Erase(descriptor, release);
+		}
+	}
+	void ShaderCache::RemoveShaderDependencies(PermutationKey a_key)
+	{
+		auto it = shaderDependencies.find(a_key);
+		if (it == shaderDependencies.end())
+			return;
+
+		for (const auto& dependency : it->second) {
+			auto dependentsIt = hlslToShaderMap.find(dependency);
+			if (dependentsIt == hlslToShaderMap.end())
+				continue;
+			auto& dependents = dependentsIt->second;
+			std::erase_if(dependents, [&](const hlslRecord& r) { return r.key == a_key; });
+			if (dependents.empty())
+				hlslToShaderMap.erase(dependentsIt);
 		}
+		shaderDependencies.erase(it);
 	}
+
 	bool ShaderCache::Clear(const std::string& a_path)
+	{
+		std::vector<ShaderCompilationTask> released;
+		if (!Clear(a_path, released))
+			return false;
+		if (!released.empty())
+			compilationSet.Clear();
+		return true;
+	}
+
+	bool ShaderCache::Clear(const std::string& a_path, std::vector<ShaderCompilationTask>& a_released)
 	{
 		std::string lowerFilePath = Util::FixFilePath(a_path);
 
@@ -1889,98 +2176,115 @@ namespace SIE
 			}
 
 			entries = it->second;  // Copy the entries
-			hlslToShaderMap.erase(it);
+			for (const auto& entry : entries) {
+				RemoveShaderDependencies(entry.key);
+			}
 		}
 
 		// Step 2: Process the copied entries without holding hlslMapMutex
+		const auto releaseShaderObject = [this](auto& a_shader) { ReleaseShaderObject(a_shader); };
 		for (auto& entry : entries) {
 			// Remove shader key from shaderMap
 			{
 				std::unique_lock lockM{ mapMutex };
 				shaderMap.erase(entry.key);
+				shaderMapByType[static_cast<size_t>(entry.key.GetType())].erase(entry.key);
 			}
 
 			// Handle vertex, pixel, and compute shaders (each will lock)
 			switch (entry.shaderClass) {
 			case SIE::ShaderClass::Vertex:
-				ReleaseShader(vertexShaders, vertexShadersMutex, entry.type, entry.descriptor);
+				ReleaseShader(vertexShaders, entry.type, entry.descriptor, releaseShaderObject);
 				break;
 			case SIE::ShaderClass::Pixel:
-				ReleaseShader(pixelShaders, pixelShadersMutex, entry.type, entry.descriptor);
+				ReleaseShader(pixelShaders, entry.type, entry.descriptor, releaseShaderObject);
 				break;
 			case SIE::ShaderClass::Compute:
-				ReleaseShader(computeShaders, computeShadersMutex, entry.type, entry.descriptor);
+				ReleaseShader(computeShaders, entry.type, entry.descriptor, releaseShaderObject);
 				break;
 			default:
 				logger::warn("Unexpected shader class: {}", static_cast<int>(entry.shaderClass));
 				break;
 			}
 
-			// Delete the associated file
-			const auto& filePath = entry.diskPath;
-			const auto& filePathString = Util::WStringToString(filePath);
-			{
-				std::scoped_lock lockD{ compilationSet.compilationMutex };
-				try {
-					if (std::filesystem::exists(filePath)) {
-						std::filesystem::remove(filePath);
-						logger::debug("Deleted {}", filePathString);
-					}
-				} catch (const std::exception& e) {
-					logger::warn("Failed to delete file {}: {}", filePathString, e.what());
-				} catch (...) {
-					logger::warn("An unknown error occurred while trying to delete file '{}'", filePathString);
-				}
-			}
-
-			logger::debug("Marking recompile for shader: {}", entry.key);
+			logger::debug("Marking recompile for shader: {}:{}:{:X}", magic_enum::enum_name(entry.type), magic_enum::enum_name(entry.shaderClass), entry.descriptor);
+			a_released.emplace_back(entry.shaderClass, *entry.shader, entry.descriptor);
 		}
 
-		if (!entries.empty()) {
+		if (!entries.empty())
 			logger::debug("Marked {} entries for recompile due to change to {}", entries.size(), a_path);
-			compilationSet.Clear();
-		}
 
 		return true;
 	}
 
+	void ShaderCache::Recompile(std::span<const ShaderCompilationTask> a_tasks)
+	{
+		// forget processed tasks so the released permutations can be queued again
+		compilationSet.Clear();
+		if (!IsAsync() || a_tasks.empty())
+			return;
+		for (const auto& task : a_tasks)
+			compilationSet.Add(task, CompilationPriority::OnDemand);
+		logger::info("Recompiling {} permutations after source changes", a_tasks.size());
+	}
+
 	void ShaderCache::Clear(RE::BSShader::Type a_type)
 	{
 		logger::debug("Clearing cache for {}", magic_enum::enum_name(a_type));
-		std::lock_guard lockGuardV(vertexShadersMutex);
-		{
-			for (auto& [id, shader] : vertexShaders[static_cast<size_t>(a_type)]) {
-				shader->shader->Release();
-			}
-			vertexShaders[static_cast<size_t>(a_type)].clear();
-		}
-		std::lock_guard lockGuardP(pixelShadersMutex);
-		{
-			for (auto& [id, shader] : pixelShaders[static_cast<size_t>(a_type)]) {
-				shader->shader->Release();
-			}
-			pixelShaders[static_cast<size_t>(a_type)].clear();
-		}
-		std::lock_guard lockGuardC(computeShadersMutex);
-		{
-			for (auto& [id, shader] : computeShaders[static_cast<size_t>(a_type)]) {
-				shader->shader->Release();
-			}
-			computeShaders[static_cast<size_t>(a_type)].clear();
-		}
+		const auto releaseShaderObject = [this](auto& a_shader) { ReleaseShaderObject(a_shader); };
+		vertexShaders[static_cast<size_t>(a_type)].Clear(releaseShaderObject);
+		pixelShaders[static_cast<size_t>(a_type)].Clear(releaseShaderObject);
+		computeShaders[static_cast<size_t>(a_type)].Clear(releaseShaderObject);
 		ClearShaderMap(a_type);
 		compilationSet.Clear();
 	}
 
-	bool ShaderCache::AddCompletedShader(ShaderClass shaderClass, const RE::BSShader& shader, uint32_t descriptor, ID3DBlob* a_blob)
+	size_t ShaderCache::InvalidateDiskCache(const std::string& a_path)
+	{
+		return EraseArchived(archiveIndex.TakeFile(Util::FixFilePath(a_path)));
+	}
+
+	size_t ShaderCache::InvalidateDiskCache(RE::BSShader::Type a_type)
+	{
+		return EraseArchived(archiveIndex.TakeType(static_cast<uint32_t>(a_type)));
+	}
+
+	bool ShaderCache::HasCompleteDiskIndex() const
 	{
-		auto key = SIE::SShaderCache::GetShaderString(shaderClass, shader, descriptor, true);
-		auto keyWithDescriptor = SIE::SShaderCache::GetShaderString(shaderClass, shader, descriptor, false);
+		return archiveIndexComplete;
+	}
+
+	void ShaderCache::IndexArchivedShader(std::string_view a_archive, uint64_t a_archiveKey, uint32_t a_type, const std::string& a_source, const std::set<std::string>& a_includes)
+	{
+		std::vector<std::string> files{ Util::FixFilePath(a_source) };
+		files.insert(files.end(), a_includes.begin(), a_includes.end());
+		archiveIndex.Record(a_archive, a_archiveKey, a_type, files);
+	}
+
+	size_t ShaderCache::EraseArchived(const std::vector<ArchiveIndex::Entry>& a_entries)
+	{
+		size_t erased = 0;
+		for (const auto& entry : a_entries) {
+			if (GetDiskArchive(entry.archive).Erase(entry.key)) {
+				logger::debug("Erased {:X} from {} disk cache", entry.key, entry.archive);
+				erased++;
+			}
+		}
+		if (!a_entries.empty())
+			archiveIndex.Save();
+		return erased;
+	}
+
+	bool ShaderCache::AddCompletedShader(ShaderClass shaderClass, const RE::BSShader& shader, uint32_t descriptor, ID3DBlob* a_blob, uint64_t a_archiveKey, const std::set<std::string>& a_includes)
+	{
+		auto key = GetPermutationKey(shaderClass, shader, descriptor);
+		auto name = SIE::SShaderCache::GetShaderString(shaderClass, shader, descriptor, true);
 		auto status = a_blob ? ShaderCompilationTask::Status::Completed : ShaderCompilationTask::Status::Failed;
-		logger::debug("Adding {} shader to map: {}", magic_enum ::enum_name(status), keyWithDescriptor);
+		logger::debug("Adding {} shader to map: {:X}:{}", magic_enum ::enum_name(status), descriptor, name);
 		{
 			std::unique_lock lockM{ mapMutex };
-			shaderMap.insert_or_assign(key, ShaderCacheResult{ a_blob, status, system_clock::now() });
+			shaderMap.insert_or_assign(key, ShaderCacheResult{ a_blob, status, system_clock::now(), std::move(name) });
+			shaderMapByType[static_cast<size_t>(key.GetType())].insert(key);
 		}
 		const std::wstring path = SIE::SShaderCache::GetShaderPath(
 			shader.shaderType == RE::BSShader::Type::ImageSpace ?
@@ -1988,80 +2292,146 @@ namespace SIE
 				shader.fxpFilename);
 		auto pathString = Util::WStringToString(path);
 		if (a_blob) {  // only create hlsl record if successful
-			std::string lowerFilePath = Util::FixFilePath(pathString);
+			// the source file and everything it includes, so editing any of them recompiles this permutation
+			std::vector<std::string> dependencies{ Util::FixFilePath(pathString) };
+			dependencies.insert(dependencies.end(), a_includes.begin(), a_includes.end());
+			hlslRecord newRecord{ key, shader.shaderType.get(), descriptor, shaderClass, &shader };
+			if (a_archiveKey)
+				archiveIndex.Record(shader.fxpFilename, a_archiveKey, shader.shaderType.underlying(), dependencies);
 			{
 				std::unique_lock lockH{ hlslMapMutex };
-				auto it = hlslToShaderMap.find(lowerFilePath);
-				hlslRecord newRecord{ key, shader.shaderType.get(), descriptor, shaderClass, SIE::SShaderCache::GetDiskPath(shader.fxpFilename, descriptor, shaderClass) };
-
-				if (it != hlslToShaderMap.end()) {
-					auto& entries = it->second;
-
-					// Find and remove existing record with the same key
-					auto existingRecord = std::find_if(entries.begin(), entries.end(),
-						[&](const hlslRecord& r) { return r.key == key; });
-
-					if (existingRecord != entries.end()) {
-						entries.erase(existingRecord);  // Remove the old record
-					}
-
-					// Insert the new or updated record
-					entries.insert(newRecord);
-				} else {
-					// Create a new entry in hlslToShaderMap for this file path
-					hlslToShaderMap.emplace(lowerFilePath, std::set<hlslRecord>{ newRecord });
+				RemoveShaderDependencies(key);
+				for (const auto& dependency : dependencies) {
+					hlslToShaderMap[dependency].insert(newRecord);
 				}
+				shaderDependencies.insert_or_assign(key, std::move(dependencies));
 			}
 		}
 
 		return a_blob != nullptr;
 	}
 
-	ID3DBlob* ShaderCache::GetCompletedShader(const std::string& a_key)
+	ID3DBlob* ShaderCache::GetCompletedShader(PermutationKey a_key)
 	{
-		std::string type = SIE::SShaderCache::GetTypeFromShaderString(a_key);
-		UpdateShaderModifiedTime(type);
+		// modification times are only tracked with the file watcher; skip building the type string otherwise
+		std::string type;
+		if (UseFileWatcher()) {
+			type = magic_enum::enum_name(a_key.GetType());
+			UpdateShaderModifiedTime(type);
+		}
 		std::scoped_lock lockM{ mapMutex };
-		if (!shaderMap.empty() && shaderMap.contains(a_key)) {
-			if (ShaderModifiedSince(type, shaderMap.at(a_key).compileTime)) {
-				logger::debug("Shader {} compiled {} before changes at {}",
-					a_key,
-					std::format("{:%H:%M:%S}", shaderMap.at(a_key).compileTime),
-					std::format("{:%H:%M:%S}", GetModifiedShaderMapTime(type)));
-				return nullptr;
-			}
-			auto status = shaderMap.at(a_key).status;
-			if (status != ShaderCompilationTask::Status::Pending)
-				return shaderMap.at(a_key).blob;
+		auto it = shaderMap.find(a_key);
+		if (it == shaderMap.end())
+			return nullptr;
+		if (!type.empty() && ShaderModifiedSince(type, it->second.compileTime)) {
+			logger::debug("Shader {} compiled {} before changes at {}",
+				it->second.name,
+				std::format("{:%H:%M:%S}", it->second.compileTime),
+				std::format("{:%H:%M:%S}", GetModifiedShaderMapTime(type)));
+			return nullptr;
 		}
+		if (it->second.status != ShaderCompilationTask::Status::Pending)
+			return it->second.blob;
 		return nullptr;
 	}
 
 	ID3DBlob* ShaderCache::GetCompletedShader(ShaderClass shaderClass, const RE::BSShader& shader,
 		uint32_t descriptor)
 	{
-		auto key = SIE::SShaderCache::GetShaderString(shaderClass, shader, descriptor, true);
-		return GetCompletedShader(key);
+		return GetCompletedShader(GetPermutationKey(shaderClass, shader, descriptor));
 	}
 
 	ID3DBlob* ShaderCache::GetCompletedShader(const ShaderCompilationTask& a_task)
 	{
-		auto key = a_task.GetString();
-		return GetCompletedShader(key);
+		return GetCompletedShader(a_task.GetKey());
 	}
 
-	ShaderCompilationTask::Status ShaderCache::GetShaderStatus(const std::string& a_key)
+	ShaderCompilationTask::Status ShaderCache::GetShaderStatus(PermutationKey a_key)
 	{
 		std::scoped_lock lockM{ mapMutex };
-		if (!shaderMap.empty() && shaderMap.contains(a_key)) {
-			return shaderMap.at(a_key).status;
+		auto it = shaderMap.find(a_key);
+		if (it != shaderMap.end()) {
+			return it->second.status;
 		}
 		return ShaderCompilationTask::Status::Pending;
 	}
 
+	void ShaderCache::OnPresent()
+	{
+		// the time blocked in the previous Present is vsync or frame cap waiting, not work
+		const auto now = std::chrono::steady_clock::now();
+		const float frameMs = lastPresentEnd == std::chrono::steady_clock::time_point{} ? 0.0f : std::chrono::duration<float, std::milli>(now - lastPresentEnd).count();
+
+		const CompileThrottle::Settings settings{ backgroundFrameBudgetMs, 1, backgroundCompilationThreadCount, compilationThreadCount };
+		const auto current = compileThrottle.GetSettings();
+		if (settings.frameBudgetMs != current.frameBudgetMs || settings.maxWorkers != current.maxWorkers || settings.idleWorkers != current.idleWorkers)
+			compileThrottle.SetSettings(settings);
+
+		auto ui = globals::game::ui;
+		const bool idle = ui && (ui->GameIsPaused() || ui->IsMenuOpen(RE::LoadingMenu::MENU_NAME));
+		if (compileThrottle.OnFrame(frameMs, idle) && backgroundCompilation && adaptiveBackgroundCompilation)
+			compilationSet.Wake();
+	}
+
+	void ShaderCache::OnPresentEnd()
+	{
+		lastPresentEnd = std::chrono::steady_clock::now();
+	}
+
+	int32_t ShaderCache::GetBackgroundCompilationLimit() const
+	{
+		return adaptiveBackgroundCompilation ? compileThrottle.GetLimit() : backgroundCompilationThreadCount;
+	}
+
+	PermutationKey ShaderCache::GetPermutationKey(ShaderClass shaderClass, const RE::BSShader& shader, uint32_t descriptor) const
+	{
+		return { shader.shaderType.get(), shaderClass, descriptor, featureEpoch.load(std::memory_order_relaxed) };
+	}
+
+	void ShaderCache::BumpFeatureEpoch()
+	{
+		logger::debug("Shader feature set changed; moving to epoch {}", ++featureEpoch);
+	}
+
 	std::string ShaderCache::GetShaderStatsString(bool a_timeOnly)
 	{
-		return compilationSet.GetStatsString(a_timeOnly);
+		if (a_timeOnly)
+			return compilationSet.GetStatsString(a_timeOnly);
+
+		uint64_t requested = 0;
+		uint64_t created = 0;
+		for (auto [poolRequested, poolCreated] : { vertexShaderObjects.GetCounts(), pixelShaderObjects.GetCounts(), computeShaderObjects.GetCounts() }) {
+			requested += poolRequested;
+			created += poolCreated;
+		}
+		const auto averageMicroseconds = [this](bool a_restored) {
+			const uint64_t count = constantLayoutCounts[a_restored];
+			return count ? static_cast<double>(constantLayoutMicroseconds[a_restored]) / static_cast<double>(count) : 0.0;
+		};
+		std::string throttleStats;
+		if (backgroundCompilation && adaptiveBackgroundCompilation)
+			throttleStats = fmt::format("\nBackground workers: {}/{} ({:.1f} ms avg CPU frame, {:.1f} ms budget{})",
+				compileThrottle.GetLimit(), compileThrottle.IsIdle() ? compilationThreadCount : backgroundCompilationThreadCount,
+				compileThrottle.GetAverageFrameMs(), backgroundFrameBudgetMs, compileThrottle.IsIdle() ? ", idle" : "");
+		const auto includeStats = includeCache.GetStats();
+		constexpr double Megabyte = 1024.0 * 1024.0;
+		return fmt::format("{}\nDuplicate bytecode: {}/{} shaders ({:.1f}%) reused a device object\nConstant layouts: {} restored ({:.1f} us avg)\t{} reflected ({:.1f} us avg)\nInclude cache: {} reads avoided ({:.1f} MB served from memory)\t{} files read ({:.1f} MB)\t{} cached\nFallbacks: {} draws used a compiled neighbour\t{} draws had none{}",
+			compilationSet.GetStatsString(a_timeOnly),
+			requested - created,
+			requested,
+			requested ? 100.0 * static_cast<double>(requested - created) / static_cast<double>(requested) : 0.0,
+			(uint64_t)constantLayoutCounts[true],
+			averageMicroseconds(true),
+			(uint64_t)constantLayoutCounts[false],
+			averageMicroseconds(false),
+			includeStats.hits,
+			static_cast<double>(includeStats.bytesServed) / Megabyte,
+			includeStats.misses,
+			static_cast<double>(includeStats.bytesRead) / Megabyte,
+			includeStats.files,
+			(uint64_t)fallbackDraws,
+			(uint64_t)fallbackMisses,
+			throttleStats);
 	}
 
 	inline bool ShaderCache::IsShaderSourceAvailable(const RE::BSShader& shader)
@@ -2128,12 +2498,25 @@ namespace SIE
 	void ShaderCache::DeleteDiskCache()
 	{
 		std::scoped_lock lock{ compilationSet.compilationMutex };
-		try {
-			std::filesystem::remove_all(L"Data/ShaderCache");
+		// archives mapped by completed shaders are moved aside and deleted once those are released
+		DeleteDiskArchives();
+		std::error_code ec;
+		size_t remaining = 0;
+		for (const auto& entry : std::filesystem::directory_iterator(L"Data/ShaderCache", ec)) {
+			std::error_code removeError;
+			std::filesystem::remove_all(entry.path(), removeError);
+			if (removeError && entry.path().extension() != ".old") {
+				logger::error("Failed to delete {}: {}", entry.path().string(), removeError.message());
+				remaining++;
+			}
+		}
+		std::filesystem::remove(L"Data/ShaderCache", ec);
+		if (remaining)
+			logger::error("Failed to delete disk cache; {} files remain", remaining);
+		else
 			logger::info("Deleted disk cache");
-		} catch (std::filesystem::filesystem_error const& ex) {
-			logger::error("Failed to delete disk cache: {}", ex.what());
-		}
+		archiveIndex.Clear();
+		archiveIndexComplete = true;
 	}
 
 	void ShaderCache::ValidateDiskCache()
@@ -2141,35 +2524,241 @@ namespace SIE
 		CSimpleIniA ini;
 		ini.SetUnicode();
 		ini.LoadFile(L"Data\\ShaderCache\\Info.ini");
-		bool valid = true;
 
-		if (auto version = ini.GetValue("Cache", "Version")) {
-			if (strcmp(SHADER_CACHE_VERSION.string().c_str(), version) != 0 || !(globals::state->ValidateCache(ini))) {
-				logger::info("Disk cache outdated or invalid");
-				valid = false;
-			}
-		} else {
-			logger::info("Disk cache outdated or invalid");
-			valid = false;
+		// Cache keys are content hashes, so only a change to how they are derived invalidates the cache.
+		// Plugin and feature updates simply miss on the permutations they changed.
+		if (static_cast<uint32_t>(ini.GetLongValue("Cache", "Format", 0)) != SHADER_CACHE_FORMAT) {
+			logger::info("Disk cache format outdated or invalid");
+			DeleteDiskCache();
+			return;
 		}
 
-		if (valid) {
-			logger::info("Using disk cache");
-		} else {
-			DeleteDiskCache();
+		// archives written before the index existed, or by cs-cache-build, hold entries it cannot find
+		archiveIndexComplete = archiveIndex.Load();
+		if (!archiveIndexComplete) {
+			std::error_code ec;
+			archiveIndexComplete = true;
+			for (const auto& entry : std::filesystem::directory_iterator(L"Data/ShaderCache", ec)) {
+				if (entry.path().extension() == ".pak") {
+					archiveIndexComplete = false;
+					logger::info("Disk cache has no index; editing shaders will delete the whole cache until it is rebuilt");
+					break;
+				}
+			}
 		}
+
+		if (auto version = ini.GetValue("Cache", "Version"); version && strcmp(SHADER_CACHE_VERSION.string().c_str(), version) != 0)
+			logger::info("Disk cache written by version {}; changed shaders will be recompiled", version);
+		if (!globals::state->ValidateCache(ini))
+			logger::info("Feature set changed since disk cache was written; affected shaders will be recompiled");
+
+		logger::info("Using disk cache");
 	}
 
 	void ShaderCache::WriteDiskCacheInfo()
 	{
 		CSimpleIniA ini;
 		ini.SetUnicode();
+		ini.SetLongValue("Cache", "Format", static_cast<long>(SHADER_CACHE_FORMAT));
 		ini.SetValue("Cache", "Version", SHADER_CACHE_VERSION.string().c_str());
 		globals::state->WriteDiskCacheInfo(ini);
 		ini.SaveFile(L"Data\\ShaderCache\\Info.ini");
+		CompactDiskArchives();
+		archiveIndex.Save();
 		logger::info("Saved disk cache info");
 	}
 
+	ShaderArchive& ShaderCache::GetDiskArchive(std::string_view a_name)
+	{
+		std::lock_guard lockGuard(diskArchivesMutex);
+		auto it = diskArchives.find(std::string(a_name));
+		if (it == diskArchives.end()) {
+			auto archive = std::make_unique<ShaderArchive>(std::format("Data/ShaderCache/{}.pak", a_name));
+			archive->Open();
+			EraseExpired(a_name, *archive);
+			it = diskArchives.emplace(std::string(a_name), std::move(archive)).first;
+		}
+		return *it->second;
+	}
+
+	void ShaderCache::CompactDiskArchives()
+	{
+		std::lock_guard lockGuard(diskArchivesMutex);
+		for (auto& [name, archive] : diskArchives) {
+			archive->Compact();
+			EraseExpired(name, *archive);
+		}
+	}
+
+	void ShaderCache::EraseExpired(std::string_view a_name, ShaderArchive& a_archive)
+	{
+		const auto expired = a_archive.TakeExpired();
+		if (expired.empty())
+			return;
+		logger::info("Dropped {} disk cache entries of {} unused for {} sessions", expired.size(), a_name, ShaderArchive::MaxAge);
+		archiveIndex.Erase(a_name, expired);
+	}
+
+	void ShaderCache::DeleteDiskArchives()
+	{
+		std::lock_guard lockGuard(diskArchivesMutex);
+		for (auto& [name, archive] : diskArchives) {
+			if (!archive->Delete())
+				logger::warn("Failed to delete shader archive {}", archive->GetPath().string());
+		}
+	}
+
+	void ShaderCache::LoadWarmList()
+	{
+		warmList.Load();
+		compileCosts.Load();
+	}
+
+	void ShaderCache::SaveWarmList()
+	{
+		std::lock_guard lock(saveMutex);
+		warmList.Save();
+		compileCosts.Save();
+		archiveIndex.Save();
+		utilityShaderList.Save();
+		if (recordBuildManifest)
+			SaveBuildManifest();
+	}
+
+	void ShaderCache::OnCompilationDrained()
+	{
+		// on-demand compiles drain the set one at a time during play, so saves are rate limited
+		constexpr auto MinInterval = 60s;
+		const auto now = std::chrono::steady_clock::now();
+		auto last = lastDrainSave.load();
+		if (now - last < MinInterval || !lastDrainSave.compare_exchange_strong(last, now))
+			return;
+		compilationPool.push_task([this]() { SaveWarmList(); });
+	}
+
+	winrt::com_ptr<ID3DBlob> ShaderCache::GetUtilityShader(const BuildManifest::Permutation& a_permutation, const char* a_entryPoint)
+	{
+		if (std::string_view(a_entryPoint) != "main")
+			return SShaderCache::CompileUtilityShader(a_permutation, a_entryPoint);
+
+		utilityShaderList.Record(a_permutation);
+		if (recordBuildManifest)
+			RecordBuildPermutation(a_permutation);
+
+		std::shared_ptr<UtilityPrefetch> prefetch;
+		{
+			std::lock_guard lock(utilityPrefetchMutex);
+			if (auto node = utilityPrefetch.extract(BuildManifest::Format(a_permutation)))
+				prefetch = std::move(node.mapped());
+		}
+		// a prefetch still waiting in the pool is claimed and compiled here rather than waited on
+		if (prefetch && prefetch->started.exchange(true))
+			return prefetch->result.get();
+		return SShaderCache::CompileUtilityShader(a_permutation, a_entryPoint);
+	}
+
+	void ShaderCache::PrefetchUtilityShaders()
+	{
+		utilityShaderList.Load();
+		// shaders of removed features would otherwise be prefetched, and fail, every startup
+		if (const auto dropped = utilityShaderList.EraseMissingSources())
+			logger::info("Dropped {} utility shaders whose source no longer exists", dropped);
+		const auto permutations = utilityShaderList.GetPermutations();
+		std::lock_guard lock(utilityPrefetchMutex);
+		for (const auto& permutation : permutations) {
+			auto prefetch = std::make_shared<UtilityPrefetch>();
+			prefetch->result = prefetch->promise.get_future().share();
+			utilityPrefetch.insert_or_assign(BuildManifest::Format(permutation), prefetch);
+			compilationPool.push_task([prefetch, permutation]() {
+				if (!prefetch->started.exchange(true))
+					prefetch->promise.set_value(SShaderCache::CompileUtilityShader(permutation, "main"));
+			});
+		}
+		logger::info("Prefetching {} utility shaders", permutations.size());
+	}
+
+	bool ShaderCache::IsRecordingBuildManifest() const
+	{
+		return recordBuildManifest;
+	}
+
+	void ShaderCache::SetRecordBuildManifest(bool a_enabled)
+	{
+		if (recordBuildManifest.exchange(a_enabled) == a_enabled)
+			return;
+		if (a_enabled) {
+			buildManifest.Load();
+			buildManifest.EraseMissingSources();
+			logger::info("Recording compiled permutations to {} ({} already listed)", buildManifest.GetPath().string(), buildManifest.GetCount());
+		} else {
+			SaveBuildManifest();
+		}
+	}
+
+	void ShaderCache::RecordBuildPermutation(const BuildManifest::Permutation& a_permutation)
+	{
+		buildManifest.Record(a_permutation);
+	}
+
+	void ShaderCache::SaveBuildManifest()
+	{
+		if (buildManifest.Save())
+			logger::info("Saved {} permutations to {}", buildManifest.GetCount(), buildManifest.GetPath().string());
+		else
+			logger::error("Failed to write build manifest {}", buildManifest.GetPath().string());
+	}
+
+	void ShaderCache::QueueWarmList(const RE::BSShader& shader)
+	{
+		if (!IsEnabled())
+			return;
+
+		// prewarming is not a use, so it must not refresh the entries it queues
+		ScopedWarmListPause pause;
+		const auto permutations = warmList.GetPermutations(shader.shaderType.underlying());
+		for (const auto& permutation : permutations) {
+			switch (static_cast<ShaderClass>(permutation.shaderClass)) {
+			case ShaderClass::Vertex:
+				GetVertexShader(shader, permutation.descriptor, CompilationPriority::OnDemand);
+				break;
+			case ShaderClass::Pixel:
+				GetPixelShader(shader, permutation.descriptor, CompilationPriority::OnDemand);
+				break;
+			case ShaderClass::Compute:
+				GetComputeShader(shader, permutation.descriptor, CompilationPriority::OnDemand);
+				break;
+			default:
+				break;
+			}
+		}
+		if (!permutations.empty())
+			logger::info("Queued {} warm list permutations for {}", permutations.size(), shader.fxpFilename);
+	}
+
+	bool ShaderCache::CanRecordWarmPermutation(const RE::BSShader& shader, CompilationPriority priority) const
+	{
+		// image space shaders share a type across many shader objects, so the descriptor alone cannot identify them
+		return priority == CompilationPriority::OnDemand && !warmListPaused && shader.shaderType != RE::BSShader::Type::ImageSpace;
+	}
+
+	void ShaderCache::RecordWarmPermutation(ShaderClass shaderClass, const RE::BSShader& shader, uint32_t descriptor)
+	{
+		warmList.Record(WarmList::Pack(shader.shaderType.underlying(), static_cast<uint32_t>(shaderClass), descriptor));
+	}
+
+	float ShaderCache::EstimateCompileTime(ShaderClass shaderClass, const RE::BSShader& shader, uint32_t descriptor) const
+	{
+		return compileCosts.Estimate(WarmList::Pack(shader.shaderType.underlying(), static_cast<uint32_t>(shaderClass), descriptor));
+	}
+
+	void ShaderCache::RecordCompileTime(ShaderClass shaderClass, const RE::BSShader& shader, uint32_t descriptor, float milliseconds)
+	{
+		// image space shaders share a type and descriptors across shader objects, so their times would be mixed up
+		if (shader.shaderType == RE::BSShader::Type::ImageSpace)
+			return;
+		compileCosts.Record(WarmList::Pack(shader.shaderType.underlying(), static_cast<uint32_t>(shaderClass), descriptor), milliseconds);
+	}
+
 	ShaderCache::ShaderCache()
 	{
 		logger::debug("ShaderCache initialized with {} compiler threads", (int)compilationThreadCount);
@@ -2283,20 +2872,22 @@ namespace SIE
 			auto newShader = SShaderCache::CreateVertexShader(*shaderBlob, shader,
 				descriptor);
 
-			std::lock_guard lockGuard(vertexShadersMutex);
-
-			const auto result = device->CreateVertexShader(shaderBlob->GetBufferPointer(),
-				newShader->byteCodeSize, nullptr, reinterpret_cast<ID3D11VertexShader**>(&newShader->shader));
-			if (FAILED(result)) {
+			newShader->shader = vertexShaderObjects.Acquire(SShaderCache::GetBytecode(*shaderBlob), [&]() -> decltype(newShader->shader) {
+				decltype(newShader->shader) object = nullptr;
+				if (FAILED(device->CreateVertexShader(shaderBlob->GetBufferPointer(),
+						newShader->byteCodeSize, nullptr, reinterpret_cast<ID3D11VertexShader**>(&object)))) {
+					if (object != nullptr) {
+						object->Release();
+					}
+					return nullptr;
+				}
+				return object;
+			});
+			if (newShader->shader == nullptr) {
 				logger::error("Failed to create vertex shader {}::{:X}",
 					magic_enum::enum_name(shader.shaderType.get()), descriptor);
-				if (newShader->shader != nullptr) {
-					newShader->shader->Release();
-				}
 			} else {
-				return vertexShaders[static_cast<size_t>(shader.shaderType.get())]
-				    .insert_or_assign(descriptor, std::move(newShader))
-				    .first->second.get();
+				return vertexShaders[static_cast<size_t>(shader.shaderType.get())].InsertOrAssign(descriptor, std::move(newShader), [this](auto& a_shader) { ReleaseShaderObject(a_shader); });
 			}
 		}
 		return nullptr;
@@ -2312,20 +2903,23 @@ namespace SIE
 			auto newShader = SShaderCache::CreatePixelShader(*shaderBlob, shader,
 				descriptor);
 
-			std::lock_guard lockGuard(pixelShadersMutex);
-			const auto result = device->CreatePixelShader(shaderBlob->GetBufferPointer(),
-				shaderBlob->GetBufferSize(), nullptr, reinterpret_cast<ID3D11PixelShader**>(&newShader->shader));
-			if (FAILED(result)) {
+			newShader->shader = pixelShaderObjects.Acquire(SShaderCache::GetBytecode(*shaderBlob), [&]() -> decltype(newShader->shader) {
+				decltype(newShader->shader) object = nullptr;
+				if (FAILED(device->CreatePixelShader(shaderBlob->GetBufferPointer(),
+						shaderBlob->GetBufferSize(), nullptr, reinterpret_cast<ID3D11PixelShader**>(&object)))) {
+					if (object != nullptr) {
+						object->Release();
+					}
+					return nullptr;
+				}
+				return object;
+			});
+			if (newShader->shader == nullptr) {
 				logger::error("Failed to create pixel shader {}::{:X}",
 					magic_enum::enum_name(shader.shaderType.get()),
 					descriptor);
-				if (newShader->shader != nullptr) {
-					newShader->shader->Release();
-				}
 			} else {
-				return pixelShaders[static_cast<size_t>(shader.shaderType.get())]
-				    .insert_or_assign(descriptor, std::move(newShader))
-				    .first->second.get();
+				return pixelShaders[static_cast<size_t>(shader.shaderType.get())].InsertOrAssign(descriptor, std::move(newShader), [this](auto& a_shader) { ReleaseShaderObject(a_shader); });
 			}
 		}
 		return nullptr;
@@ -2341,20 +2935,23 @@ namespace SIE
 			auto newShader = SShaderCache::CreateComputeShader(*shaderBlob, shader,
 				descriptor);
 
-			std::lock_guard lockGuard(computeShadersMutex);
-			const auto result = device->CreateComputeShader(shaderBlob->GetBufferPointer(),
-				shaderBlob->GetBufferSize(), nullptr, reinterpret_cast<ID3D11ComputeShader**>(&newShader->shader));
-			if (FAILED(result)) {
-				logger::error("Failed to create pixel shader {}::{:X}",
+			newShader->shader = computeShaderObjects.Acquire(SShaderCache::GetBytecode(*shaderBlob), [&]() -> decltype(newShader->shader) {
+				decltype(newShader->shader) object = nullptr;
+				if (FAILED(device->CreateComputeShader(shaderBlob->GetBufferPointer(),
+						shaderBlob->GetBufferSize(), nullptr, reinterpret_cast<ID3D11ComputeShader**>(&object)))) {
+					if (object != nullptr) {
+						object->Release();
+					}
+					return nullptr;
+				}
+				return object;
+			});
+			if (newShader->shader == nullptr) {
+				logger::error("Failed to create compute shader {}::{:X}",
 					magic_enum::enum_name(shader.shaderType.get()),
 					descriptor);
-				if (newShader->shader != nullptr) {
-					newShader->shader->Release();
-				}
 			} else {
-				return computeShaders[static_cast<size_t>(shader.shaderType.get())]
-				    .insert_or_assign(descriptor, std::move(newShader))
-				    .first->second.get();
+				return computeShaders[static_cast<size_t>(shader.shaderType.get())].InsertOrAssign(descriptor, std::move(newShader), [this](auto& a_shader) { ReleaseShaderObject(a_shader); });
 			}
 		}
 		return nullptr;
@@ -2390,6 +2987,22 @@ namespace SIE
 		compilationSet.cacheHitTasks++;
 	}
 
+	void ShaderCache::IncDiskCacheHits()
+	{
+		compilationSet.diskCacheHits++;
+	}
+
+	void ShaderCache::AddConstantLayoutTime(bool a_restored, microseconds a_time)
+	{
+		constantLayoutCounts[a_restored]++;
+		constantLayoutMicroseconds[a_restored] += a_time.count();
+	}
+
+	void ShaderCache::IncDiskCacheMisses()
+	{
+		compilationSet.diskCacheMisses++;
+	}
+
 	bool ShaderCache::IsHideErrors()
 	{
 		return hideError;
@@ -2400,15 +3013,11 @@ namespace SIE
 		std::string_view shaderTypeStr = magic_enum::enum_name(a_type);
 
 		std::unique_lock lockM{ SIE::ShaderCache::mapMutex };
-		logger::debug("Clearing shaderMap of {}", shaderTypeStr);
-		for (auto it = shaderMap.begin(); it != shaderMap.end();) {
-			auto typeInKey = SIE::SShaderCache::GetTypeFromShaderString(it->first);
-			if (typeInKey == shaderTypeStr) {
-				it = shaderMap.erase(it);
-			} else {
-				++it;
-			}
-		}
+		auto& keys = shaderMapByType[static_cast<size_t>(a_type)];
+		logger::debug("Clearing {} entries of {} from shaderMap", keys.size(), shaderTypeStr);
+		for (const auto& key : keys)
+			shaderMap.erase(key);
+		keys.clear();
 	}
 
 	void ShaderCache::InsertModifiedShaderMap(const std::string& a_shader, std::chrono::time_point<std::chrono::system_clock> a_time)
@@ -2438,7 +3047,7 @@ namespace SIE
 		auto index = 0;
 		for (auto& [key, value] : shaderMap) {
 			if (index++ == targetIndex) {
-				blockedKey = key;
+				blockedKey = value.name;
 				blockedKeyIndex = (uint)targetIndex;
 				blockedIDs.clear();
 				logger::debug("Blocking shader ({}/{}) {}", blockedKeyIndex + 1, shaderMap.size(), blockedKey);
@@ -2498,11 +3107,21 @@ namespace SIE
 		       (static_cast<size_t>(shaderClass) << 60);
 	}
 
+	PermutationKey ShaderCompilationTask::GetKey() const
+	{
+		return ShaderCache::Instance().GetPermutationKey(shaderClass, shader, descriptor);
+	}
+
 	std::string ShaderCompilationTask::GetString() const
 	{
 		return SIE::SShaderCache::GetShaderString(shaderClass, shader, descriptor, true);
 	}
 
+	float ShaderCompilationTask::GetEstimatedCost() const
+	{
+		return ShaderCache::Instance().EstimateCompileTime(shaderClass, shader, descriptor);
+	}
+
 	bool ShaderCompilationTask::operator==(const ShaderCompilationTask& other) const
 	{
 		return GetId() == other.GetId();
@@ -2514,68 +3133,106 @@ namespace SIE
 		auto shaderCache = globals::shaderCache;
 		if (!conditionVariable.wait(
 				lock, stoken,
-				[this, &shaderCache]() { return !availableTasks.empty() &&
-			                                    // check against all tasks in queue to trickle the work. It cannot be the active tasks count because the thread pool itself is maximum.
-			                                    (int)shaderCache->compilationPool.get_tasks_total() <=
-			                                        (!shaderCache->backgroundCompilation ? shaderCache->compilationThreadCount : shaderCache->backgroundCompilationThreadCount); })) {
+				[this, &shaderCache]() {
+					auto priority = availableTasks.Peek();
+					if (!priority.has_value())
+						return false;
+					// draw misses may use the full pool even while background compilation is throttled
+					auto threadCount = !shaderCache->backgroundCompilation || *priority == CompilationPriority::OnDemand ?
+					                       shaderCache->compilationThreadCount :
+					                       shaderCache->GetBackgroundCompilationLimit();
+					// check against all tasks in queue to trickle the work. It cannot be the active tasks count because the thread pool itself is maximum.
+					return (int)shaderCache->compilationPool.get_tasks_total() <= threadCount;
+				})) {
 			/*Woke up because of a stop request. */
 			return std::nullopt;
 		}
 		if (!shaderCache->IsCompiling()) {  // we just got woken up because there's a task, start clock
 			lastCalculation = lastReset = high_resolution_clock::now();
 		}
-		auto node = availableTasks.extract(availableTasks.begin());
-		auto& task = node.value();
-		tasksInProgress.insert(std::move(node));
+		auto task = availableTasks.Pop()->first;
+		tasksInProgress.insert(task);
 		return task;
 	}
 
-	void CompilationSet::Add(const ShaderCompilationTask& task)
+	void CompilationSet::Add(const ShaderCompilationTask& task, CompilationPriority priority)
 	{
+		const float cost = task.GetEstimatedCost();
 		std::unique_lock lock(compilationMutex);
 		auto inProgressIt = tasksInProgress.find(task);
 		auto processedIt = processedTasks.find(task);
 		if (inProgressIt == tasksInProgress.end() && processedIt == processedTasks.end() && !globals::shaderCache->GetCompletedShader(task)) {
-			auto [availableIt, wasAdded] = availableTasks.insert(task);
+			// longest known compiles start first so the tail of a full compile is not one huge shader on one core
+			auto result = availableTasks.Push(task, priority, cost);
+			if (result == decltype(availableTasks)::PushResult::Added && estimates.try_emplace(task, cost).second)
+				estimatedMs += cost;
+			// an unchanged entry is already more urgent, so marking the requested priority only costs a later Add
+			globals::shaderCache->SetPendingMark(task, DrawPath::QueuedMark(priority));
 			lock.unlock();
-			if (wasAdded) {
+			if (result == decltype(availableTasks)::PushResult::Added) {
 				conditionVariable.notify_one();
 				totalTasks++;
+			} else if (result == decltype(availableTasks)::PushResult::Promoted) {
+				logger::debug("Promoted compile task {} to {}", task.GetString(), magic_enum::enum_name(priority));
+				conditionVariable.notify_one();
 			}
+		} else if (inProgressIt != tasksInProgress.end()) {
+			globals::shaderCache->SetPendingMark(task, DrawPath::QueuedMark(priority));
 		}
 	}
 
 	void CompilationSet::Complete(const ShaderCompilationTask& task)
 	{
 		auto& cache = ShaderCache::Instance();
-		auto key = task.GetString();
-		auto shaderBlob = cache.GetCompletedShader(task);
+		auto key = task.GetKey();
+		auto shaderBlob = cache.GetCompletedShader(key);
 		if (shaderBlob) {
-			logger::debug("Compiling Task succeeded: {}", key);
+			logger::debug("Compiling Task succeeded: {}:{}:{:X}", magic_enum::enum_name(key.GetType()), magic_enum::enum_name(key.GetClass()), key.GetDescriptor());
 			completedTasks++;
 		} else {
-			logger::debug("Compiling Task failed: {}", key);
+			logger::debug("Compiling Task failed: {}:{}:{:X}", magic_enum::enum_name(key.GetType()), magic_enum::enum_name(key.GetClass()), key.GetDescriptor());
 			failedTasks++;
 		}
-		auto now = high_resolution_clock::now();
-		totalMs += duration_cast<milliseconds>(now - lastCalculation).count();
-		lastCalculation = now;
+		bool drained;
+		{
+			std::scoped_lock lock(compilationMutex);
+			auto now = high_resolution_clock::now();
+			totalMs += duration_cast<milliseconds>(now - lastCalculation).count();
+			lastCalculation = now;
+			if (auto node = estimates.extract(task))
+				estimatedDoneMs += node.mapped();
+			processedTasks.insert(task);
+			tasksInProgress.erase(task);
+			cache.SetPendingMark(task, shaderBlob ? DrawPath::NotPendingMark : DrawPath::FailedMark);
+			drained = tasksInProgress.empty() && availableTasks.Empty();
+			conditionVariable.notify_one();
+		}
+		if (drained)
+			cache.OnCompilationDrained();
+	}
+
+	void CompilationSet::Wake()
+	{
 		std::scoped_lock lock(compilationMutex);
-		processedTasks.insert(task);
-		tasksInProgress.erase(task);
 		conditionVariable.notify_one();
 	}
 
 	void CompilationSet::Clear()
 	{
 		std::scoped_lock lock(compilationMutex);
-		availableTasks.clear();
+		availableTasks.Clear();
 		tasksInProgress.clear();
 		processedTasks.clear();
+		ShaderCache::Instance().ClearPendingMarks();
+		estimates.clear();
+		estimatedMs = 0.0;
+		estimatedDoneMs = 0.0;
 		totalTasks = 0;
 		completedTasks = 0;
 		failedTasks = 0;
 		cacheHitTasks = 0;
+		diskCacheHits = 0;
+		diskCacheMisses = 0;
 		lastReset = high_resolution_clock::now();
 		lastCalculation = high_resolution_clock::now();
 		totalMs = (double)duration_cast<std::chrono::milliseconds>(lastReset - lastReset).count();
@@ -2595,9 +3252,12 @@ namespace SIE
 
 	double CompilationSet::GetEta()
 	{
-		auto rate = completedTasks / totalMs;
-		auto remaining = totalTasks - completedTasks - failedTasks;
-		return std::max(remaining / rate, 0.0);
+		std::scoped_lock lock(compilationMutex);
+		const double remaining = std::max(estimatedMs - estimatedDoneMs, 0.0);
+		if (estimatedDoneMs > 0.0 && totalMs > 0.0)
+			return remaining * totalMs / estimatedDoneMs;
+		// nothing finished yet, assume every compile thread is busy
+		return remaining / std::max(globals::shaderCache->compilationThreadCount, 1);
 	}
 
 	std::string CompilationSet::GetStatsString(bool a_timeOnly)
@@ -2606,28 +3266,28 @@ namespace SIE
 			return fmt::format("{}/{}",
 				GetHumanTime(totalMs),
 				GetHumanTime(GetEta() + totalMs));
-		return fmt::format("{}/{} (successful/total)\tfailed: {}\tcachehits: {}\nElapsed/Estimated Time: {}/{}",
+		return fmt::format("{}/{} (successful/total)\tfailed: {}\tcachehits: {}\tdiskcache: {}/{} (hits/misses)\nElapsed/Estimated Time: {}/{}",
 			(std::uint64_t)completedTasks,
 			(std::uint64_t)totalTasks,
 			(std::uint64_t)failedTasks,
 			(std::uint64_t)cacheHitTasks,
+			(std::uint64_t)diskCacheHits,
+			(std::uint64_t)diskCacheMisses,
 			GetHumanTime(totalMs),
 			GetHumanTime(GetEta() + totalMs));
 	}
 
-	void UpdateListener::UpdateCache(const std::filesystem::path& filePath, SIE::ShaderCache* cache, bool& clearCache, bool& fileDone)
+	void UpdateListener::UpdateCache(const std::filesystem::path& filePath, SIE::ShaderCache* cache, bool& clearCache, std::vector<ShaderCompilationTask>& recompile)
 	{
 		// Extract file components
 		const std::string extension = filePath.extension().string();
 		const std::string shaderTypeString = filePath.stem().string();
 		std::chrono::time_point<std::chrono::system_clock> modifiedTime{};
 		auto shaderType = magic_enum::enum_cast<RE::BSShader::Type>(shaderTypeString, magic_enum::case_insensitive);
-		fileDone = true;
 		// Check if the file exists and get its modified time
 		if (std::filesystem::exists(filePath)) {
 			modifiedTime = std::chrono::clock_cast<std::chrono::system_clock>(std::filesystem::last_write_time(filePath));
 		} else {
-			fileDone = true;
 			return;
 		}
 
@@ -2635,14 +3295,22 @@ namespace SIE
 		std::string lowerExtension = extension;
 		std::transform(lowerExtension.begin(), lowerExtension.end(), lowerExtension.begin(),
 			[](unsigned char c) { return static_cast<char>(std::tolower(c)); });
-		if (!std::filesystem::is_directory(filePath) && lowerExtension == ".hlsl") {
+		if (!std::filesystem::is_directory(filePath) && (lowerExtension == ".hlsl" || lowerExtension == ".hlsli")) {
+			cache->GetIncludeCache().Invalidate(filePath);
+
 			// Update cache with the modified shader
-			cache->InsertModifiedShaderMap(shaderTypeString, modifiedTime);
+			if (lowerExtension == ".hlsl")
+				cache->InsertModifiedShaderMap(shaderTypeString, modifiedTime);
+
+			// Erase archived permutations built from the file, including ones not loaded in this session
+			if (auto erased = cache->InvalidateDiskCache(filePath.string()))
+				logger::debug("Erased {} disk cached permutations depending on {}", erased, filePath.string());
 
-			// Attempt to mark the shader for recompilation
-			bool foundPath = cache->Clear(filePath.string());
+			// Release the shader and every permutation including it; the batch recompiles them together
+			bool foundPath = cache->Clear(filePath.string(), recompile);
 
-			if (!foundPath) {
+			// An include no loaded permutation depends on needs no invalidation
+			if (!foundPath && lowerExtension == ".hlsl") {
 				// File was not found in the the map so check its shader type
 				std::string parentDirName = filePath.parent_path().filename().string();
 				std::transform(parentDirName.begin(), parentDirName.end(), parentDirName.begin(),
@@ -2650,6 +3318,7 @@ namespace SIE
 
 				// Check if the parent directory name matches "shaders" in a case-insensitive way
 				if (lowerExtension == ".hlsl" && parentDirName == "shaders" && shaderType.has_value()) {
+					cache->InvalidateDiskCache(shaderType.value());
 					cache->Clear(shaderType.value());
 				} else {
 					// If it's not specifically handled, clear all cache
@@ -2657,62 +3326,57 @@ namespace SIE
 				}
 			}
 		}
-		// Indicate that file processing is not yet complete
-		fileDone = false;
 	}
 
 	void UpdateListener::processQueue()
 	{
 		SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
-		std::unique_lock lock(actionMutex, std::defer_lock);
 		auto cache = globals::shaderCache;
 		while (cache->UseFileWatcher()) {
-			lock.lock();
-			if (!queue.empty() && queue.size() == lastQueueSize) {
+			std::vector<std::string> batch;
+			{
+				std::lock_guard lock(actionMutex);
+				batch = changes.Take(ChangeCoalescer::Clock::now());
+			}
+			if (!batch.empty()) {
+				logger::debug("Processing {} changed files", batch.size());
 				bool clearCache = false;
-				for (fileAction fAction : queue) {
-					const std::filesystem::path filePath = std::filesystem::path(std::format("{}\\{}", fAction.dir, fAction.filename));
-					bool fileDone = false;
-					switch (fAction.action) {
-					case efsw::Actions::Add:
-						logger::debug("Detected Added path {}", filePath.string());
-						UpdateCache(filePath, cache, clearCache, fileDone);
-						break;
-					case efsw::Actions::Delete:
-						logger::debug("Detected Deleted path {}", filePath.string());
-						break;
-					case efsw::Actions::Modified:
-						logger::debug("Detected Changed path {}", filePath.string());
-						UpdateCache(filePath, cache, clearCache, fileDone);
-						break;
-					case efsw::Actions::Moved:
-						logger::debug("Detected Moved path {}", filePath.string());
-						break;
-					default:
-						logger::error("Filewatcher received invalid action {}", magic_enum::enum_name(fAction.action));
-					}
-					if (fileDone)
-						continue;
-				}
+				std::vector<ShaderCompilationTask> recompile;
+				for (const auto& path : batch)
+					UpdateCache(path, cache, clearCache, recompile);
 				if (clearCache) {
-					cache->DeleteDiskCache();
+					// with a complete index, the archived permutations of every changed file were erased above
+					if (!cache->HasCompleteDiskIndex())
+						cache->DeleteDiskCache();
 					cache->Clear();
+				} else {
+					cache->Recompile(recompile);
 				}
-				queue.clear();
 			}
-			lastQueueSize = queue.size();
-			lock.unlock();
-			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
 		}
-		queue.clear();
+		std::lock_guard lock(actionMutex);
+		changes.Clear();
 	}
 
-	void UpdateListener::handleFileAction(efsw::WatchID watchid, const std::string& dir, const std::string& filename, efsw::Action action, std::string oldFilename)
+	void UpdateListener::handleFileAction(efsw::WatchID, const std::string& dir, const std::string& filename, efsw::Action action, std::string oldFilename)
 	{
-		std::lock_guard lock(actionMutex);
-		if (queue.empty() || (queue.back().action != action && queue.back().filename != filename)) {
-			// only add if not a duplicate; esfw is very spammy
-			queue.push_back({ watchid, dir, filename, action, oldFilename });
+		const auto path = std::format("{}\\{}", dir, filename);
+		switch (action) {
+		case efsw::Actions::Add:
+		case efsw::Actions::Modified:
+		case efsw::Actions::Moved:  // editors save by renaming a temporary file over the target
+			logger::debug("Detected {} path {}{}", magic_enum::enum_name(action), path, oldFilename.empty() ? "" : std::format(" (from {})", oldFilename));
+			break;
+		case efsw::Actions::Delete:
+			logger::debug("Detected Deleted path {}", path);
+			return;
+		default:
+			logger::error("Filewatcher received invalid action {}", magic_enum::enum_name(action));
+			return;
 		}
+		// efsw reports several events per save; they are folded into one batch
+		std::lock_guard lock(actionMutex);
+		changes.Add(path, ChangeCoalescer::Clock::now());
 	}
 }
\ No newline at end of file
@@ -2,8 +2,25 @@
 
 #include <BS_thread_pool.hpp>
 #include <efsw/efsw.hpp>
-
-static constexpr REL::Version SHADER_CACHE_VERSION = { 0, 0, 0, 28 };
+#include <winrt/base.h>
+
+#include "ShaderCache/ArchiveIndex.h"
+#include "ShaderCache/BuildManifest.h"
+#include "ShaderCache/ChangeCoalescer.h"
+#include "ShaderCache/CompilationQueue.h"
+#include "ShaderCache/CompileCostHistory.h"
+#include "ShaderCache/CompileThrottle.h"
+#include "ShaderCache/ContentKey.h"
+#include "ShaderCache/DrawPath.h"
+#include "ShaderCache/IncludeCache.h"
+#include "ShaderCache/ReflectionMetadata.h"
+#include "ShaderCache/ShaderFlags.h"
+#include "ShaderCache/ShaderArchive.h"
+#include "ShaderCache/ShaderLookup.h"
+#include "ShaderCache/ShaderObjectPool.h"
+#include "ShaderCache/WarmList.h"
+
+static constexpr REL::Version SHADER_CACHE_VERSION = { 0, 0, 0, 29 };
 
 using namespace std::chrono;
 
@@ -203,6 +220,53 @@ namespace SIE
 		Total,
 	};
 
+	static_assert(static_cast<uint32_t>(ShaderType::Grass) == static_cast<uint32_t>(RE::BSShader::Type::Grass) &&
+				  static_cast<uint32_t>(ShaderType::Water) == static_cast<uint32_t>(RE::BSShader::Type::Water) &&
+				  static_cast<uint32_t>(ShaderType::Lighting) == static_cast<uint32_t>(RE::BSShader::Type::Lighting) &&
+				  static_cast<uint32_t>(ShaderType::Effect) == static_cast<uint32_t>(RE::BSShader::Type::Effect) &&
+				  static_cast<uint32_t>(ShaderType::Utility) == static_cast<uint32_t>(RE::BSShader::Type::Utility) &&
+				  static_cast<uint32_t>(ShaderType::DistantTree) == static_cast<uint32_t>(RE::BSShader::Type::DistantTree) &&
+				  static_cast<uint32_t>(ShaderType::Total) == static_cast<uint32_t>(RE::BSShader::Type::Total));
+
+	/**
+	 * @brief Packed identity of a shader permutation, used as the key of the completed shader map.
+	 *
+	 * Layout: descriptor in bits 0-31, shader type in bits 32-39, shader class in bits 40-43 and
+	 * feature-set epoch in bits 44-63. Bumping the epoch makes everything compiled under the
+	 * previous define set unreachable. Human-readable names are only built for logs and UI.
+	 */
+	struct PermutationKey
+	{
+		PermutationKey(RE::BSShader::Type a_type, ShaderClass a_class, uint32_t a_descriptor, uint32_t a_epoch) :
+			value(static_cast<uint64_t>(a_descriptor) |
+				  (static_cast<uint64_t>(a_type) & 0xFF) << 32 |
+				  (static_cast<uint64_t>(a_class) & 0xF) << 40 |
+				  (static_cast<uint64_t>(a_epoch) & 0xFFFFF) << 44)
+		{}
+
+		RE::BSShader::Type GetType() const { return static_cast<RE::BSShader::Type>((value >> 32) & 0xFF); }
+		ShaderClass GetClass() const { return static_cast<ShaderClass>((value >> 40) & 0xF); }
+		uint32_t GetDescriptor() const { return static_cast<uint32_t>(value); }
+		uint32_t GetEpoch() const { return static_cast<uint32_t>(value >> 44); }
+
+		auto operator<=>(const PermutationKey&) const = default;
+
+		uint64_t value;
+	};
+}
+
+template <>
+struct std::hash<SIE::PermutationKey>
+{
+	std::size_t operator()(const SIE::PermutationKey& key) const noexcept
+	{
+		return ankerl::unordered_dense::hash<uint64_t>{}(key.value);
+	}
+};
+
+namespace SIE
+{
+
 	class ShaderCompilationTask
 	{
 	public:
@@ -217,7 +281,12 @@ namespace SIE
 		void Perform() const;
 
 		size_t GetId() const;
+		PermutationKey GetKey() const;
 		std::string GetString() const;
+		/**
+		 * @brief Returns the expected compile time in milliseconds.
+		 */
+		float GetEstimatedCost() const;
 
 		bool operator==(const ShaderCompilationTask& other) const;
 
@@ -243,26 +312,43 @@ namespace SIE
 	{
 	public:
 		std::optional<ShaderCompilationTask> WaitTake(std::stop_token stoken);
-		void Add(const ShaderCompilationTask& task);
+		void Add(const ShaderCompilationTask& task, CompilationPriority priority = CompilationPriority::OnDemand);
 		void Complete(const ShaderCompilationTask& task);
+		/**
+		 * @brief Wakes the management thread so it re-checks how many tasks it may start.
+		 */
+		void Wake();
 		void Clear();
 		std::string GetHumanTime(double a_totalms);
+		/**
+		 * @brief Estimates the time left from the recorded compile times of the unfinished tasks.
+		 *
+		 * The estimates are scaled by the wall time the finished tasks took against their
+		 * estimates, which accounts for the worker count, disk cache hits and machine speed.
+		 *
+		 * @return The remaining time in milliseconds.
+		 */
 		double GetEta();
 		std::string GetStatsString(bool a_timeOnly = false);
 		std::atomic<uint64_t> completedTasks = 0;
 		std::atomic<uint64_t> totalTasks = 0;
 		std::atomic<uint64_t> failedTasks = 0;
 		std::atomic<uint64_t> cacheHitTasks = 0;  // number of compiles of a previously seen shader combo
+		std::atomic<uint64_t> diskCacheHits = 0;    // permutations loaded from the disk cache
+		std::atomic<uint64_t> diskCacheMisses = 0;  // permutations whose content key was not in the disk cache
 		std::mutex compilationMutex;
 
 	private:
-		std::unordered_set<ShaderCompilationTask> availableTasks;
+		CompilationQueue<ShaderCompilationTask, CompilationPriority> availableTasks;
 		std::unordered_set<ShaderCompilationTask> tasksInProgress;
 		std::unordered_set<ShaderCompilationTask> processedTasks;  // completed or failed
 		std::condition_variable_any conditionVariable;
 		std::chrono::steady_clock::time_point lastReset = high_resolution_clock::now();
 		std::chrono::steady_clock::time_point lastCalculation = high_resolution_clock::now();
 		double totalMs = (double)duration_cast<std::chrono::milliseconds>(lastReset - lastReset).count();
+		std::unordered_map<ShaderCompilationTask, float> estimates;  // expected compile time of queued and running tasks
+		double estimatedMs = 0.0;                                    // sum of the estimates of every task added since the last reset
+		double estimatedDoneMs = 0.0;                                // sum of the estimates of the processed tasks
 	};
 
 	struct ShaderCacheResult
@@ -270,6 +356,7 @@ namespace SIE
 		ID3DBlob* blob;
 		ShaderCompilationTask::Status status;
 		system_clock::time_point compileTime = system_clock::now();
+		std::string name;  // human-readable key, built once for logs and shader blocking
 	};
 
 	class UpdateListener;
@@ -328,6 +415,104 @@ namespace SIE
 		void DeleteDiskCache();
 		void ValidateDiskCache();
 		void WriteDiskCacheInfo();
+		/**
+		 * @brief Returns the packed disk archive for a shader file, opening it on first use.
+		 * 
+		 * @param a_name The shader file name (`fxpFilename`); the archive lives at `Data/ShaderCache/<name>.pak`.
+		 * @return The archive, which stays valid until the disk cache is deleted.
+		 */
+		ShaderArchive& GetDiskArchive(std::string_view a_name);
+		/**
+		 * @brief Returns the shader source cache shared by every compile and preprocess.
+		 *
+		 * @return The cache; entries revalidate against file write times on lookup.
+		 */
+		IncludeCache& GetIncludeCache() { return includeCache; }
+		void CompactDiskArchives();
+		void LoadWarmList();
+		/**
+		 * @brief Saves the warm list, compile costs, archive index and utility shader list.
+		 *
+		 * Called on game saves, once the startup compile finishes and when the compilation set
+		 * drains, so a session that never saves or ends in a crash still keeps what it learned.
+		 */
+		void SaveWarmList();
+		/**
+		 * @brief Called by the compilation set when its last task completes; saves at most once a minute.
+		 */
+		void OnCompilationDrained();
+		/**
+		 * @brief Queues the permutations of a shader that were bound in previous sessions.
+		 * 
+		 * Called as each shader is loaded so the permutations the player actually uses are
+		 * compiled at the highest priority, ahead of the rest of the prewarm set.
+		 * 
+		 * @param shader The shader that was just loaded.
+		 */
+		void QueueWarmList(const RE::BSShader& shader);
+		/**
+		 * @brief Stops shader lookups on the calling thread from recording warm list permutations while alive.
+		 *
+		 * For lookups that do not come from a real draw, such as warm list prewarming and draw stream replays.
+		 */
+		struct ScopedWarmListPause
+		{
+			ScopedWarmListPause() { warmListPaused++; }
+			~ScopedWarmListPause() { warmListPaused--; }
+
+			ScopedWarmListPause(const ScopedWarmListPause&) = delete;
+			ScopedWarmListPause& operator=(const ScopedWarmListPause&) = delete;
+		};
+		/**
+		 * @brief Returns the expected compile time of a permutation from previous compiles.
+		 *
+		 * Used to start the most expensive permutations first and to estimate the time left.
+		 */
+		float EstimateCompileTime(ShaderClass shaderClass, const RE::BSShader& shader, uint32_t descriptor) const;
+		void RecordCompileTime(ShaderClass shaderClass, const RE::BSShader& shader, uint32_t descriptor, float milliseconds);
+		/**
+		 * @brief Whether every compiled permutation is recorded for the offline cache builder (cs-cache-build).
+		 */
+		bool IsRecordingBuildManifest() const;
+		/**
+		 * @brief Feeds the background compile throttle with the CPU time of the frame.
+		 *
+		 * Called once per frame from the Present hook, before the swap chain's Present.
+		 */
+		void OnPresent();
+		/**
+		 * @brief Marks the end of Present, so the wait inside it is not counted as frame work.
+		 */
+		void OnPresentEnd();
+		/**
+		 * @brief Returns how many background compile tasks may run right now.
+		 *
+		 * @return The throttle's limit when adaptive background compilation is on, otherwise `backgroundCompilationThreadCount`.
+		 */
+		int32_t GetBackgroundCompilationLimit() const;
+		const CompileThrottle& GetCompileThrottle() const { return compileThrottle; }
+		/**
+		 * @brief Starts recording permutations into `Data/ShaderCache/BuildManifest.tsv`, or stops and saves it.
+		 */
+		void SetRecordBuildManifest(bool a_enabled);
+		void RecordBuildPermutation(const BuildManifest::Permutation& a_permutation);
+		/**
+		 * @brief Returns the bytecode of a shader requested through Util::CompileShader.
+		 *
+		 * Served from a startup prefetch when one is ready, otherwise from the permutation's disk
+		 * archive, and compiled only on a miss. Safe to call from any thread.
+		 *
+		 * @param a_permutation The resolved source, profile, flags and defines.
+		 * @param a_entryPoint The entry point; only `main` shaders are remembered for prefetching.
+		 * @return The bytecode, or nullptr if compilation failed.
+		 */
+		winrt::com_ptr<ID3DBlob> GetUtilityShader(const BuildManifest::Permutation& a_permutation, const char* a_entryPoint = "main");
+		/**
+		 * @brief Compiles every utility shader requested in previous sessions on the compiler pool.
+		 *
+		 * Feature setup then finds the bytecode ready instead of compiling it on the main thread.
+		 */
+		void PrefetchUtilityShaders();
 		bool UseFileWatcher() const;
 		void SetFileWatcher(bool value);
 
@@ -363,7 +548,8 @@ namespace SIE
 		/**
    		* @brief Clears and marks shaders for recompilation based on the given path.
  		*
- 		* This function looks up the provided `a_path` in the `hlslToShaderMap`. 
+ 		* This function looks up the provided `a_path` in the `hlslToShaderMap`, which indexes
+		* every permutation by its source file and all of its transitive includes.
 		* If the path exists in the map, it iterates through all the shader entries associated 
 		* with that path, clears the shaders, and marks them for recompilation by updating their 
 		* modified times, and logs the operation.
@@ -373,27 +559,97 @@ namespace SIE
 		* @returns bool whether a shader was found in the `hlslToShaderMap`
 		* 
 		* @note The function assumes that `a_path` corresponds to shaders stored in `hlslToShaderMap`.
-		* If the path is not found in the map, the function does nothing. Also, only files compiled
-		* during session will be identified. Disk cached shaders will not be cleared and a further 
-		* cache clear may be necessary.
+		* If the path is not found in the map, the function does nothing. Disk cached permutations
+		* are left alone; InvalidateDiskCache() erases those built from an edited file.
 		* 
 		* @threadsafe The function locks the internal map (`mapMutex`) to ensure thread safety when 
 		* accessing or modifying shared shader map data.
 		*/
 		bool Clear(const std::string& a_path);
+		/**
+		 * @brief Releases the shaders built from a file without touching the compilation queue.
+		 *
+		 * Used by the file watcher to gather a whole batch of changes before Recompile().
+		 *
+		 * @param a_path The changed file.
+		 * @param a_released Receives a compile task for every released permutation.
+		 * @returns bool whether a shader was found in the `hlslToShaderMap`
+		 */
+		bool Clear(const std::string& a_path, std::vector<ShaderCompilationTask>& a_released);
+		/**
+		 * @brief Resets the compilation queue once and queues a batch of released permutations at draw priority.
+		 */
+		void Recompile(std::span<const ShaderCompilationTask> a_tasks);
+		/**
+		 * @brief Erases every disk-cached permutation compiled from a file or one of its includes.
+		 *
+		 * Uses the persisted disk cache index, so permutations not loaded in this session are found too.
+		 *
+		 * @param a_path The edited source file.
+		 * @return The number of archive entries erased.
+		 */
+		size_t InvalidateDiskCache(const std::string& a_path);
+		/**
+		 * @brief Erases every disk-cached permutation of a shader type.
+		 */
+		size_t InvalidateDiskCache(RE::BSShader::Type a_type);
+		/**
+		 * @brief Whether every archived permutation is in the disk cache index.
+		 *
+		 * False while archives written before the index existed are in use; edits then have to
+		 * delete the whole disk cache to get rid of stale entries.
+		 */
+		bool HasCompleteDiskIndex() const;
+		/**
+		 * @brief Records the files an archived permutation was compiled from in the disk cache index.
+		 */
+		void IndexArchivedShader(std::string_view a_archive, uint64_t a_archiveKey, uint32_t a_type, const std::string& a_source, const std::set<std::string>& a_includes);
 
-		bool AddCompletedShader(ShaderClass shaderClass, const RE::BSShader& shader, uint32_t descriptor, ID3DBlob* a_blob);
-		ID3DBlob* GetCompletedShader(const std::string& a_key);
+		bool AddCompletedShader(ShaderClass shaderClass, const RE::BSShader& shader, uint32_t descriptor, ID3DBlob* a_blob, uint64_t a_archiveKey = 0, const std::set<std::string>& a_includes = {});
+		ID3DBlob* GetCompletedShader(PermutationKey a_key);
 		ID3DBlob* GetCompletedShader(const SIE::ShaderCompilationTask& a_task);
 		ID3DBlob* GetCompletedShader(ShaderClass shaderClass, const RE::BSShader& shader, uint32_t descriptor);
-		ShaderCompilationTask::Status GetShaderStatus(const std::string& a_key);
+		ShaderCompilationTask::Status GetShaderStatus(PermutationKey a_key);
+		PermutationKey GetPermutationKey(ShaderClass shaderClass, const RE::BSShader& shader, uint32_t descriptor) const;
+		/**
+		 * @brief Invalidates every completed shader by moving to a new feature-set epoch.
+		 * 
+		 * Called when the shader define set changes; permutations keyed under the old epoch are never looked up again.
+		 */
+		void BumpFeatureEpoch();
 		std::string GetShaderStatsString(bool a_timeOnly = false);
 
-		RE::BSGraphics::VertexShader* GetVertexShader(const RE::BSShader& shader, uint32_t descriptor);
+		RE::BSGraphics::VertexShader* GetVertexShader(const RE::BSShader& shader, uint32_t descriptor,
+			CompilationPriority priority = CompilationPriority::OnDemand);
 		RE::BSGraphics::PixelShader* GetPixelShader(const RE::BSShader& shader,
-			uint32_t descriptor);
+			uint32_t descriptor, CompilationPriority priority = CompilationPriority::OnDemand);
 		RE::BSGraphics::ComputeShader* GetComputeShader(const RE::BSShader& shader,
-			uint32_t descriptor);
+			uint32_t descriptor, CompilationPriority priority = CompilationPriority::OnDemand);
+
+		/**
+		 * @brief Substitutes the nearest compiled permutation while the exact one is still compiling.
+		 *
+		 * Drops as few of the type's optional flags (Snow, AnisoLighting/Glint, ProjectedUV) as
+		 * possible until both stages are compiled. The exact permutations are queued first, so the
+		 * fallback is only bound until they land.
+		 *
+		 * @param shader The shader beginning a technique.
+		 * @param vertexDescriptor The vertex descriptor, replaced by the fallback one if found.
+		 * @param pixelDescriptor The pixel descriptor, replaced by the fallback one if found.
+		 * @param skipPixelShader Whether the technique binds no pixel shader.
+		 * @return true if the descriptors were replaced.
+		 */
+		bool ResolveFallback(const RE::BSShader& shader, uint32_t& vertexDescriptor, uint32_t& pixelDescriptor, bool skipPixelShader);
+
+		/**
+		 * @brief Stores a compilation mark, see DrawPath::QueuedMark, in the permutation's lookup slot.
+		 * @note Caller must hold the compilation set's mutex, so marks follow the task's state.
+		 */
+		void SetPendingMark(const ShaderCompilationTask& task, uint8_t mark);
+		/**
+		 * @brief Resets every compilation mark, e.g. when the compilation set forgets its tasks.
+		 */
+		void ClearPendingMarks();
 
 		RE::BSGraphics::VertexShader* MakeAndAddVertexShader(const RE::BSShader& shader,
 			uint32_t descriptor);
@@ -409,6 +665,13 @@ namespace SIE
 		uint64_t GetFailedTasks();
 		uint64_t GetTotalTasks();
 		void IncCacheHitTasks();
+		void IncDiskCacheHits();
+		void IncDiskCacheMisses();
+		/**
+		 * @brief Records the time spent building one shader's constant buffer layout.
+		 * @param a_restored true if the layout came from stored reflection metadata, false if the blob was reflected.
+		 */
+		void AddConstantLayoutTime(bool a_restored, microseconds a_time);
 		void ToggleErrorMessages();
 		void DisableShaderBlocking();
 		void IterateShaderBlock(bool a_forward = true);
@@ -427,200 +690,26 @@ namespace SIE
 
 		int32_t compilationThreadCount = std::max({ static_cast<int32_t>(std::thread::hardware_concurrency()) - 4, static_cast<int32_t>(std::thread::hardware_concurrency()) * 3 / 4, 1 });
 		int32_t backgroundCompilationThreadCount = std::max(static_cast<int32_t>(std::thread::hardware_concurrency()) / 2, 1);
+		bool adaptiveBackgroundCompilation = true;  // scale background workers with frame time instead of using a fixed count
+		float backgroundFrameBudgetMs = 16.7f;      // gameplay frame time the adaptive throttle stays under
 		BS::thread_pool compilationPool{};
 		bool backgroundCompilation = false;
 		bool menuLoaded = false;
 
-		enum class LightingShaderTechniques
-		{
-			None = 0,
-			Envmap = 1,
-			Glowmap = 2,
-			Parallax = 3,
-			Facegen = 4,
-			FacegenRGBTint = 5,
-			Hair = 6,
-			ParallaxOcc = 7,
-			MTLand = 8,
-			LODLand = 9,
-			Snow = 10,  // unused
-			MultilayerParallax = 11,
-			TreeAnim = 12,
-			LODObjects = 13,
-			MultiIndexSparkle = 14,
-			LODObjectHD = 15,
-			Eye = 16,
-			Cloud = 17,  // unused
-			LODLandNoise = 18,
-			MTLandLODBlend = 19,
-		};
-
-		enum class LightingShaderFlags
-		{
-			VC = 1 << 0,
-			Skinned = 1 << 1,
-			ModelSpaceNormals = 1 << 2,
-			// flags 3 to 8 are unused by vanilla
-			// Community Shaders start
-			TruePbr = 1 << 3,
-			Deferred = 1 << 4,
-			// Community Shaders end
-			Specular = 1 << 9,
-			SoftLighting = 1 << 10,
-			RimLighting = 1 << 11,
-			BackLighting = 1 << 12,
-			ShadowDir = 1 << 13,
-			DefShadow = 1 << 14,
-			ProjectedUV = 1 << 15,
-			AnisoLighting = 1 << 16,  // Reused for glint with PBR
-			AmbientSpecular = 1 << 17,
-			WorldMap = 1 << 18,
-			BaseObjectIsSnow = 1 << 19,
-			DoAlphaTest = 1 << 20,
-			Snow = 1 << 21,
-			CharacterLight = 1 << 22,
-			AdditionalAlphaMask = 1 << 23
-		};
-
-		enum class BloodSplatterShaderTechniques
-		{
-			Splatter = 0,
-			Flare = 1,
-		};
-
-		enum class DistantTreeShaderTechniques
-		{
-			DistantTreeBlock = 0,
-			Depth = 1,
-		};
-
-		enum class DistantTreeShaderFlags
-		{
-			Deferred = 1 << 8,
-			AlphaTest = 1 << 16,
-		};
-
-		enum class SkyShaderTechniques
-		{
-			SunOcclude = 0,
-			SunGlare = 1,
-			MoonAndStarsMask = 2,
-			Stars = 3,
-			Clouds = 4,
-			CloudsLerp = 5,
-			CloudsFade = 6,
-			Texture = 7,
-			Sky = 8,
-		};
-
-		enum class GrassShaderTechniques
-		{
-			RenderDepth = 8,
-			TruePbr = 9,
-		};
-
-		enum class GrassShaderFlags
-		{
-			AlphaTest = 0x10000,
-		};
-
-		enum class ParticleShaderTechniques
-		{
-			Particles = 0,
-			ParticlesGryColor = 1,
-			ParticlesGryAlpha = 2,
-			ParticlesGryColorAlpha = 3,
-			EnvCubeSnow = 4,
-			EnvCubeRain = 5,
-		};
-
-		enum class WaterShaderTechniques
-		{
-			Underwater = 8,
-			Lod = 9,
-			Stencil = 10,
-			Simple = 11,
-		};
-
-		enum class WaterShaderFlags
-		{
-			Vc = 1 << 0,
-			NormalTexCoord = 1 << 1,
-			Reflections = 1 << 2,
-			Refractions = 1 << 3,
-			Depth = 1 << 4,
-			Interior = 1 << 5,
-			Wading = 1 << 6,
-			VertexAlphaDepth = 1 << 7,
-			Cubemap = 1 << 8,
-			Flowmap = 1 << 9,
-			BlendNormals = 1 << 10,
-		};
-
-		enum class EffectShaderFlags
-		{
-			Vc = 1 << 0,
-			TexCoord = 1 << 1,
-			TexCoordIndex = 1 << 2,
-			Skinned = 1 << 3,
-			Normals = 1 << 4,
-			BinormalTangent = 1 << 5,
-			Texture = 1 << 6,
-			IndexedTexture = 1 << 7,
-			Falloff = 1 << 8,
-			AddBlend = 1 << 10,
-			MultBlend = 1 << 11,
-			Particles = 1 << 12,
-			StripParticles = 1 << 13,
-			Blood = 1 << 14,
-			Membrane = 1 << 15,
-			Lighting = 1 << 16,
-			ProjectedUv = 1 << 17,
-			Soft = 1 << 18,
-			GrayscaleToColor = 1 << 19,
-			GrayscaleToAlpha = 1 << 20,
-			IgnoreTexAlpha = 1 << 21,
-			MultBlendDecal = 1 << 22,
-			AlphaTest = 1 << 23,
-			SkyObject = 1 << 24,
-			MsnSpuSkinned = 1 << 25,
-			MotionVectorsNormals = 1 << 26,
-			Deferred = 1 << 27
-		};
-
-		enum class UtilityShaderFlags : uint64_t
-		{
-			Vc = 1 << 0,
-			Texture = 1 << 1,
-			Skinned = 1 << 2,
-			Normals = 1 << 3,
-			BinormalTangent = 1 << 4,
-			AlphaTest = 1 << 7,
-			LodLandscape = 1 << 8,
-			RenderNormal = 1 << 9,
-			RenderNormalFalloff = 1 << 10,
-			RenderNormalClamp = 1 << 11,
-			RenderNormalClear = 1 << 12,
-			RenderDepth = 1 << 13,
-			RenderShadowmap = 1 << 14,
-			RenderShadowmapClamped = 1 << 15,
-			GrayscaleToAlpha = 1 << 15,
-			RenderShadowmapPb = 1 << 16,
-			AdditionalAlphaMask = 1 << 16,
-			DepthWriteDecals = 1 << 17,
-			DebugShadowSplit = 1 << 18,
-			DebugColor = 1 << 19,
-			GrayscaleMask = 1 << 20,
-			RenderShadowmask = 1 << 21,
-			RenderShadowmaskSpot = 1 << 22,
-			RenderShadowmaskPb = 1 << 23,
-			RenderShadowmaskDpb = 1 << 24,
-			RenderBaseTexture = 1 << 25,
-			TreeAnim = 1 << 26,
-			LodObject = 1 << 27,
-			LocalMapFogOfWar = 1 << 28,
-			OpaqueEffect = 1 << 29,
-		};
+		// the flag and technique enums are plain C++ in ShaderCache/ShaderFlags.h, so headless code can use them
+		using LightingShaderTechniques = SIE::LightingShaderTechniques;
+		using LightingShaderFlags = SIE::LightingShaderFlags;
+		using BloodSplatterShaderTechniques = SIE::BloodSplatterShaderTechniques;
+		using DistantTreeShaderTechniques = SIE::DistantTreeShaderTechniques;
+		using DistantTreeShaderFlags = SIE::DistantTreeShaderFlags;
+		using SkyShaderTechniques = SIE::SkyShaderTechniques;
+		using GrassShaderTechniques = SIE::GrassShaderTechniques;
+		using GrassShaderFlags = SIE::GrassShaderFlags;
+		using ParticleShaderTechniques = SIE::ParticleShaderTechniques;
+		using WaterShaderTechniques = SIE::WaterShaderTechniques;
+		using WaterShaderFlags = SIE::WaterShaderFlags;
+		using EffectShaderFlags = SIE::EffectShaderFlags;
+		using UtilityShaderFlags = SIE::UtilityShaderFlags;
 
 		uint blockedKeyIndex = (uint)-1;  // index in shaderMap; negative value indicates disabled
 		std::string blockedKey = "";
@@ -630,11 +719,11 @@ namespace SIE
 	private:
 		struct hlslRecord
 		{
-			std::string key;
+			PermutationKey key;
 			RE::BSShader::Type type;
 			std::uint32_t descriptor;
 			SIE::ShaderClass shaderClass;
-			std::wstring diskPath;
+			const RE::BSShader* shader;  // to queue the permutation again when its sources change
 
 			bool operator<(const hlslRecord& other) const
 			{
@@ -642,20 +731,53 @@ namespace SIE
 			}
 		};
 		ShaderCache();
+		size_t EraseArchived(const std::vector<ArchiveIndex::Entry>& a_entries);
 		void ManageCompilationSet(std::stop_token stoken);
 		void ProcessCompilationSet(std::stop_token stoken, SIE::ShaderCompilationTask task);
+		void DeleteDiskArchives();
+		void EraseExpired(std::string_view a_name, ShaderArchive& a_archive);
+		bool CanRecordWarmPermutation(const RE::BSShader& shader, CompilationPriority priority) const;
+		void RecordWarmPermutation(ShaderClass shaderClass, const RE::BSShader& shader, uint32_t descriptor);
+		void SaveBuildManifest();
+		/**
+		 * @brief Removes a shader key from the reverse index of every file it depends on.
+		 * 
+		 * @param a_key The shader key in `shaderMap`.
+		 * @note Caller must hold `hlslMapMutex`.
+		 */
+		void RemoveShaderDependencies(PermutationKey a_key);
+		/**
+		 * @brief Drops a cached shader's use of its device object, releasing the object once no permutation shares it.
+		 */
+		void ReleaseShaderObject(RE::BSGraphics::VertexShader& a_shader);
+		void ReleaseShaderObject(RE::BSGraphics::PixelShader& a_shader);
+		void ReleaseShaderObject(RE::BSGraphics::ComputeShader& a_shader);
 
 		~ShaderCache();
 
-		std::array<eastl::unordered_map<uint32_t, std::unique_ptr<RE::BSGraphics::VertexShader>>,
-			static_cast<size_t>(RE::BSShader::Type::Total)>
-			vertexShaders;
-		std::array<eastl::unordered_map<uint32_t, std::unique_ptr<RE::BSGraphics::PixelShader>>,
-			static_cast<size_t>(RE::BSShader::Type::Total)>
-			pixelShaders;
-		std::array<eastl::unordered_map<uint32_t, std::unique_ptr<RE::BSGraphics::ComputeShader>>,
-			static_cast<size_t>(RE::BSShader::Type::Total)>
-			computeShaders;
+		// per shader type; lookups from the render thread never block on compiler threads inserting results
+		std::array<ShaderLookup<RE::BSGraphics::VertexShader>, static_cast<size_t>(RE::BSShader::Type::Total)> vertexShaders;
+		std::array<ShaderLookup<RE::BSGraphics::PixelShader>, static_cast<size_t>(RE::BSShader::Type::Total)> pixelShaders;
+		std::array<ShaderLookup<RE::BSGraphics::ComputeShader>, static_cast<size_t>(RE::BSShader::Type::Total)> computeShaders;
+		// device objects shared by permutations that compile to identical bytecode
+		ShaderObjectPool<std::remove_pointer_t<decltype(RE::BSGraphics::VertexShader::shader)>> vertexShaderObjects;
+		ShaderObjectPool<std::remove_pointer_t<decltype(RE::BSGraphics::PixelShader::shader)>> pixelShaderObjects;
+		ShaderObjectPool<std::remove_pointer_t<decltype(RE::BSGraphics::ComputeShader::shader)>> computeShaderObjects;
+		// shader sources and includes read once and shared by every compile
+		IncludeCache includeCache;
+		CompileThrottle compileThrottle;
+		struct UtilityPrefetch
+		{
+			std::atomic<bool> started = false;  // claimed by the pool task or by the requester, whichever runs first
+			std::promise<winrt::com_ptr<ID3DBlob>> promise;
+			std::shared_future<winrt::com_ptr<ID3DBlob>> result;
+		};
+		BuildManifest utilityShaderList{ "Data/ShaderCache/UtilityShaders.tsv" };                  // Util::CompileShader requests of previous sessions
+		std::unordered_map<std::string, std::shared_ptr<UtilityPrefetch>> utilityPrefetch;         // by BuildManifest::Format line
+		std::mutex utilityPrefetchMutex;                                                           // guard for utilityPrefetch
+		std::chrono::steady_clock::time_point lastPresentEnd{};  // only touched by the Present hook
+		std::atomic<std::chrono::steady_clock::time_point> lastDrainSave{};  // last save queued by OnCompilationDrained
+		std::mutex saveMutex;                                                 // serializes SaveWarmList, which writes several files
 
 		bool isEnabled = true;
 		bool isDiskCache = true;
@@ -665,16 +787,29 @@ namespace SIE
 		bool useFileWatcher = false;
 
 		std::stop_source ssource;
-		std::mutex vertexShadersMutex;
-		std::mutex pixelShadersMutex;
-		std::mutex computeShadersMutex;
 		CompilationSet compilationSet;
-		std::unordered_map<std::string, ShaderCacheResult> shaderMap{};
-		std::mutex mapMutex;                                                            // guard for shaderMap
+		std::unordered_map<PermutationKey, ShaderCacheResult> shaderMap{};
+		std::array<std::unordered_set<PermutationKey>, static_cast<size_t>(RE::BSShader::Type::Total)> shaderMapByType{};  // shaderMap keys per shader type
+		std::mutex mapMutex;                                                            // guard for shaderMap and shaderMapByType
+		std::atomic<uint32_t> featureEpoch = 0;                                         // feature-set epoch baked into every PermutationKey
+		std::array<std::atomic<uint64_t>, 2> constantLayoutCounts{};                   // shaders whose layout was reflected / restored from disk
+		std::array<std::atomic<uint64_t>, 2> constantLayoutMicroseconds{};             // time spent on reflected / restored layouts
+		std::atomic<uint64_t> fallbackDraws = 0;                                        // techniques bound with a fallback permutation
+		std::atomic<uint64_t> fallbackMisses = 0;                                       // techniques pending compilation with no compiled neighbour
 		std::unordered_map<std::string, system_clock::time_point> modifiedShaderMap{};  // hashmap when a shader source file last modified
 		std::mutex modifiedMapMutex;                                                    // guard for modifiedShaderMap
-		std::unordered_map<std::string, std::set<hlslRecord>> hlslToShaderMap{};        // hashmap linking specific hlsl files to shader keys in shaderMap
-		std::mutex hlslMapMutex;                                                        // guard for hlslToShaderMap
+		std::unordered_map<std::string, std::set<hlslRecord>> hlslToShaderMap{};        // hashmap linking hlsl files and their includes to dependent shader keys in shaderMap
+		std::unordered_map<PermutationKey, std::vector<std::string>> shaderDependencies{};  // hashmap linking shader keys to every file they were compiled from
+		std::mutex hlslMapMutex;                                                        // guard for hlslToShaderMap and shaderDependencies
+		std::unordered_map<std::string, std::unique_ptr<ShaderArchive>> diskArchives{};  // packed disk cache per shader file
+		std::mutex diskArchivesMutex;                                                     // guard for diskArchives
+		ArchiveIndex archiveIndex{ "Data/ShaderCache/Index.bin" };                        // source files of every archived permutation
+		std::atomic<bool> archiveIndexComplete = true;                                    // archiveIndex covers everything in the archives
+		WarmList warmList{ "Data/ShaderCache/WarmList.bin" };                             // permutations bound during play
+		static inline thread_local uint32_t warmListPaused = 0;                           // ScopedWarmListPause objects alive on this thread
+		CompileCostHistory compileCosts{ "Data/ShaderCache/CompileCosts.bin" };           // measured compile time per permutation
+		BuildManifest buildManifest{ "Data/ShaderCache/BuildManifest.tsv" };               // resolved permutations for cs-cache-build
+		std::atomic<bool> recordBuildManifest = false;                                    // record compiled permutations into buildManifest
 
 		// efsw file watcher
 		efsw::FileWatcher* fileWatcher = nullptr;
@@ -689,35 +824,29 @@ namespace SIE
 		/**
 		 * @brief Updates the shader cache for a specific file path and determines whether to clear the cache.
 		 *
-		 * This function checks if the given file exists and is a shader file (with the ".hlsl" extension).
-		 * It then updates the cache with the modified time for the shader file and marks shaders for recompilation 
-		 * based on the given path. If a specific shader is not found in the cache, it may trigger a cache clear.
+		 * This function checks if the given file exists and is a shader file (with the ".hlsl" or ".hlsli" extension).
+		 * It then updates the cache with the modified time for the shader file and releases every permutation compiled
+		 * from or including it. If a ".hlsl" shader is not found in the cache, it may trigger a cache clear.
 		 *
 		 * @param filePath The path of the shader file to update.
 		 * @param cache Reference to the shader cache to update.
 		 * @param clearCache A boolean flag indicating whether the entire cache should be cleared.
-		 * @param fileDone A boolean flag that signals whether the update process is done for the current file.
+		 * @param recompile Receives the released permutations, recompiled once the whole batch is processed.
 		 * 
-		 * @note The function only processes files with an ".hlsl" extension and ignores directories.
+		 * @note The function only processes files with an ".hlsl" or ".hlsli" extension and ignores directories.
 		 * It assumes case-insensitive handling for shader types and extensions.
 		 * 
-		 * @return Void. Updates internal state and modifies `clearCache` and `fileDone` by reference.
+		 * @return Void. Updates internal state and modifies `clearCache` and `recompile` by reference.
+		 */
+		void UpdateCache(const std::filesystem::path& filePath, SIE::ShaderCache* cache, bool& clearCache, std::vector<ShaderCompilationTask>& recompile);
+		/**
+		 * @brief Processes debounced batches of changed files until the file watcher is turned off.
 		 */
-		void UpdateCache(const std::filesystem::path& filePath, SIE::ShaderCache* cache, bool& clearCache, bool& retFlag);
 		void processQueue();
 		void handleFileAction(efsw::WatchID, const std::string& dir, const std::string& filename, efsw::Action action, std::string) override;
 
 	private:
-		struct fileAction
-		{
-			efsw::WatchID watchID;
-			std::string dir;
-			std::string filename;
-			efsw::Action action;
-			std::string oldFilename;
-		};
-		std::mutex actionMutex;
-		std::vector<fileAction> queue{};
-		size_t lastQueueSize = queue.size();
+		std::mutex actionMutex;    // guard for changes
+		ChangeCoalescer changes;  // changed files waiting for the debounce window
 	};
 }
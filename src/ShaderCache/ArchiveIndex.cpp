@@ -0,0 +1,224 @@
+#include "ShaderCache/ArchiveIndex.h"
+
+namespace SIE
+{
+	namespace
+	{
+		template <class T>
+		bool Read(std::istream& a_in, T& a_value)
+		{
+			return static_cast<bool>(a_in.read(reinterpret_cast<char*>(&a_value), sizeof(T)));
+		}
+
+		template <class T>
+		void Write(std::ostream& a_out, const T& a_value)
+		{
+			a_out.write(reinterpret_cast<const char*>(&a_value), sizeof(T));
+		}
+	}
+
+	bool ArchiveIndex::Load()
+	{
+		std::lock_guard lock(mutex);
+		std::ifstream in(path, std::ios::binary);
+		if (!in.is_open())
+			return false;
+
+		std::error_code ec;
+		const auto fileSize = std::filesystem::file_size(path, ec);
+		Header header{};
+		// every name takes at least its length, every record at least key, archive, type and file count
+		if (ec || !Read(in, header) || header.magic != Magic || header.version != Version ||
+			static_cast<uint64_t>(header.nameCount) * sizeof(uint32_t) + static_cast<uint64_t>(header.recordCount) * 20 > fileSize - sizeof(Header)) {
+			logger::warn("Ignoring invalid disk cache index {}", path.string());
+			return false;
+		}
+
+		// file name ids are remapped onto the names interned so far
+		std::vector<uint32_t> ids;
+		ids.reserve(header.nameCount);
+		for (uint32_t i = 0; i < header.nameCount; i++) {
+			uint32_t length = 0;
+			if (!Read(in, length) || length > fileSize) {
+				logger::warn("Disk cache index {} is truncated", path.string());
+				return false;
+			}
+			std::string name(length, '\0');
+			if (!in.read(name.data(), length)) {
+				logger::warn("Disk cache index {} is truncated", path.string());
+				return false;
+			}
+			ids.push_back(Intern(name));
+		}
+
+		size_t loaded = 0;
+		std::vector<uint32_t> files;
+		for (uint32_t i = 0; i < header.recordCount; i++) {
+			uint64_t key = 0;
+			uint32_t archive = 0;
+			uint32_t type = 0;
+			uint32_t fileCount = 0;
+			if (!Read(in, key) || !Read(in, archive) || !Read(in, type) || !Read(in, fileCount) || fileCount > header.nameCount) {
+				logger::warn("Disk cache index {} is truncated", path.string());
+				return false;
+			}
+			files.resize(fileCount);
+			if (!in.read(reinterpret_cast<char*>(files.data()), static_cast<std::streamsize>(fileCount * sizeof(uint32_t))) ||
+				archive >= ids.size() || std::ranges::any_of(files, [&](uint32_t a_file) { return a_file >= ids.size(); })) {
+				logger::warn("Disk cache index {} is truncated", path.string());
+				return false;
+			}
+
+			// entries recorded in this session are newer than the file
+			const Id id{ ids[archive], key };
+			if (records.contains(id))
+				continue;
+			Sources record{ type, {} };
+			record.files.reserve(fileCount);
+			for (auto file : files) {
+				record.files.push_back(ids[file]);
+				byFile[ids[file]].insert(id);
+			}
+			if (type != NoType)
+				byType[type].insert(id);
+			records.emplace(id, std::move(record));
+			loaded++;
+		}
+
+		logger::info("Loaded disk cache index of {} permutations", loaded);
+		return true;
+	}
+
+	bool ArchiveIndex::Save()
+	{
+		std::lock_guard lock(mutex);
+		if (!dirty)
+			return true;
+
+		std::error_code ec;
+		std::filesystem::create_directories(path.parent_path(), ec);
+		std::ofstream out(path, std::ios::binary | std::ios::trunc);
+		Write(out, Header{ Magic, Version, static_cast<uint32_t>(names.size()), static_cast<uint32_t>(records.size()) });
+		for (const auto& name : names) {
+			Write(out, static_cast<uint32_t>(name.size()));
+			out.write(name.data(), static_cast<std::streamsize>(name.size()));
+		}
+		for (const auto& [id, record] : records) {
+			Write(out, id.key);
+			Write(out, id.archive);
+			Write(out, record.type);
+			Write(out, static_cast<uint32_t>(record.files.size()));
+			out.write(reinterpret_cast<const char*>(record.files.data()), static_cast<std::streamsize>(record.files.size() * sizeof(uint32_t)));
+		}
+		if (!out) {
+			logger::error("Failed to write disk cache index {}", path.string());
+			return false;
+		}
+
+		dirty = false;
+		logger::debug("Saved disk cache index of {} permutations", records.size());
+		return true;
+	}
+
+	void ArchiveIndex::Record(std::string_view a_archive, uint64_t a_key, uint32_t a_type, std::span<const std::string> a_files)
+	{
+		std::lock_guard lock(mutex);
+		const Id id{ Intern(a_archive), a_key };
+		EraseLocked(id);
+
+		Sources record{ a_type, {} };
+		record.files.reserve(a_files.size());
+		for (const auto& file : a_files) {
+			const auto fileId = Intern(file);
+			record.files.push_back(fileId);
+			byFile[fileId].insert(id);
+		}
+		if (a_type != NoType)
+			byType[a_type].insert(id);
+		records.insert_or_assign(id, std::move(record));
+		dirty = true;
+	}
+
+	std::vector<ArchiveIndex::Entry> ArchiveIndex::TakeFile(std::string_view a_file)
+	{
+		std::lock_guard lock(mutex);
+		auto name = nameIds.find(std::string(a_file));
+		if (name == nameIds.end())
+			return {};
+		auto it = byFile.find(name->second);
+		if (it == byFile.end())
+			return {};
+		return TakeLocked(std::unordered_set<Id, IdHash>(it->second));
+	}
+
+	std::vector<ArchiveIndex::Entry> ArchiveIndex::TakeType(uint32_t a_type)
+	{
+		std::lock_guard lock(mutex);
+		auto it = byType.find(a_type);
+		if (it == byType.end())
+			return {};
+		return TakeLocked(std::unordered_set<Id, IdHash>(it->second));
+	}
+
+	void ArchiveIndex::Erase(std::string_view a_archive, std::span<const uint64_t> a_keys)
+	{
+		std::lock_guard lock(mutex);
+		auto archive = nameIds.find(std::string(a_archive));
+		if (archive == nameIds.end())
+			return;
+		for (auto key : a_keys)
+			EraseLocked({ archive->second, key });
+	}
+
+	void ArchiveIndex::Clear()
+	{
+		std::lock_guard lock(mutex);
+		names.clear();
+		nameIds.clear();
+		records.clear();
+		byFile.clear();
+		byType.clear();
+		dirty = true;
+	}
+
+	size_t ArchiveIndex::GetCount() const
+	{
+		std::lock_guard lock(mutex);
+		return records.size();
+	}
+
+	uint32_t ArchiveIndex::Intern(std::string_view a_name)
+	{
+		auto [it, inserted] = nameIds.try_emplace(std::string(a_name), static_cast<uint32_t>(names.size()));
+		if (inserted)
+			names.emplace_back(a_name);
+		return it->second;
+	}
+
+	void ArchiveIndex::EraseLocked(const Id& a_id)
+	{
+		auto it = records.find(a_id);
+		if (it == records.end())
+			return;
+		for (auto file : it->second.files) {
+			auto dependents = byFile.find(file);
+			if (dependents != byFile.end() && dependents->second.erase(a_id) && dependents->second.empty())
+				byFile.erase(dependents);
+		}
+		if (auto dependents = byType.find(it->second.type); dependents != byType.end() && dependents->second.erase(a_id) && dependents->second.empty())
+			byType.erase(dependents);
+		records.erase(it);
+		dirty = true;
+	}
+
+	std::vector<ArchiveIndex::Entry> ArchiveIndex::TakeLocked(const std::unordered_set<Id, IdHash>& a_ids)
+	{
+		std::vector<Entry> result;
+		result.reserve(a_ids.size());
+		for (const auto& id : a_ids) {
+			result.push_back({ names[id.archive], id.key });
+			EraseLocked(id);
+		}
+		return result;
+	}
+}
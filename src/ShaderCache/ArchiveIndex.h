@@ -0,0 +1,117 @@
+#pragma once
+
+namespace SIE
+{
+	/**
+	 * @brief Source files and shader type of every disk-cached permutation, persisted next to the archives.
+	 *
+	 * Disk cache keys are content hashes, so an edited source never serves a stale blob, but the
+	 * old entries stay in the archives until the whole cache is deleted. The index lets an edit
+	 * erase exactly the archived permutations built from the file, including ones never loaded
+	 * in this session.
+	 *
+	 * Entries are identified by archive name and archive key and indexed by every file they were
+	 * compiled from and by shader type. File names are interned, so a permutation costs a few
+	 * integers per include. The file is `Header | names | records` and is rewritten whole by Save().
+	 *
+	 * The class is plain C++ and has no dependency on the game or D3D.
+	 */
+	class ArchiveIndex
+	{
+	public:
+		static constexpr uint32_t Magic = 0x49415343;  // "CSAI"
+		static constexpr uint32_t Version = 1;
+		static constexpr uint32_t NoType = UINT32_MAX;  // entries that are not a BSShader permutation, e.g. feature shaders
+
+		struct Header
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint32_t nameCount;
+			uint32_t recordCount;
+		};
+		static_assert(sizeof(Header) == 16);
+
+		struct Entry
+		{
+			std::string archive;
+			uint64_t key;
+		};
+
+		explicit ArchiveIndex(std::filesystem::path a_path) :
+			path(std::move(a_path)) {}
+
+		/**
+		 * @brief Merges the file contents into the in-memory index; entries recorded before keep their files.
+		 * @return true if a valid index was read.
+		 */
+		bool Load();
+
+		/**
+		 * @brief Writes the index if it changed since the last Load() or Save().
+		 * @return true if the file is up to date.
+		 */
+		bool Save();
+
+		/**
+		 * @brief Records the files an archived permutation was compiled from, replacing any previous record.
+		 *
+		 * @param a_archive The archive name.
+		 * @param a_key The archive key.
+		 * @param a_type The shader type, or NoType.
+		 * @param a_files Normalized paths of the source file and all of its includes.
+		 */
+		void Record(std::string_view a_archive, uint64_t a_key, uint32_t a_type, std::span<const std::string> a_files);
+
+		/**
+		 * @brief Removes and returns every entry compiled from a file.
+		 */
+		std::vector<Entry> TakeFile(std::string_view a_file);
+
+		/**
+		 * @brief Removes and returns every entry of a shader type.
+		 */
+		std::vector<Entry> TakeType(uint32_t a_type);
+
+		/**
+		 * @brief Forgets entries that are no longer in an archive, e.g. dropped for age.
+		 */
+		void Erase(std::string_view a_archive, std::span<const uint64_t> a_keys);
+
+		void Clear();
+		size_t GetCount() const;
+
+	private:
+		struct Id
+		{
+			uint32_t archive;
+			uint64_t key;
+
+			bool operator==(const Id&) const = default;
+		};
+
+		struct IdHash
+		{
+			size_t operator()(const Id& a_id) const noexcept { return std::hash<uint64_t>{}(a_id.key ^ (static_cast<uint64_t>(a_id.archive) << 56)); }
+		};
+
+		struct Sources
+		{
+			uint32_t type;
+			std::vector<uint32_t> files;
+		};
+
+		uint32_t Intern(std::string_view a_name);
+		void EraseLocked(const Id& a_id);
+		std::vector<Entry> TakeLocked(const std::unordered_set<Id, IdHash>& a_ids);
+
+		std::filesystem::path path;
+		mutable std::mutex mutex;                                             // guard for everything below
+		std::vector<std::string> names;                                       // interned archive and file names
+		std::unordered_map<std::string, uint32_t> nameIds;                    // name to index in names
+		std::unordered_map<Id, Sources, IdHash> records;
+		std::unordered_map<uint32_t, std::unordered_set<Id, IdHash>> byFile;  // file name id to the entries compiled from it
+		std::unordered_map<uint32_t, std::unordered_set<Id, IdHash>> byType;
+		bool dirty = false;
+	};
+}
@@ -0,0 +1,204 @@
+#include "ShaderCache/BuildManifest.h"
+
+namespace SIE
+{
+	namespace
+	{
+		constexpr std::string_view HeaderPrefix = "# cs-cache-build manifest ";
+		constexpr std::string_view SessionPrefix = "# session ";
+
+		std::vector<std::string_view> SplitFields(std::string_view a_line)
+		{
+			std::vector<std::string_view> fields;
+			size_t start = 0;
+			for (size_t tab = a_line.find('\t'); tab != std::string_view::npos; tab = a_line.find('\t', start)) {
+				fields.push_back(a_line.substr(start, tab - start));
+				start = tab + 1;
+			}
+			fields.push_back(a_line.substr(start));
+			return fields;
+		}
+
+		std::optional<uint32_t> ParseNumber(std::string_view a_field, int a_base)
+		{
+			uint32_t value = 0;
+			auto [end, ec] = std::from_chars(a_field.data(), a_field.data() + a_field.size(), value, a_base);
+			if (ec != std::errc{} || end != a_field.data() + a_field.size())
+				return std::nullopt;
+			return value;
+		}
+
+		std::optional<uint32_t> ParseHex(std::string_view a_field)
+		{
+			return ParseNumber(a_field, 16);
+		}
+	}
+
+	std::string BuildManifest::Format(const Permutation& a_permutation)
+	{
+		std::string line = std::format("{}\t{}\t{}\t{:X}\t{:X}", a_permutation.archive, a_permutation.source, a_permutation.profile, a_permutation.flags, a_permutation.stripFlags);
+		for (const auto& [name, definition] : a_permutation.defines) {
+			line += '\t';
+			line += name;
+			if (!definition.empty()) {
+				line += '=';
+				line += definition;
+			}
+		}
+		return line;
+	}
+
+	std::optional<BuildManifest::Permutation> BuildManifest::Parse(std::string_view a_line)
+	{
+		if (!a_line.empty() && a_line.back() == '\r')
+			a_line.remove_suffix(1);
+		const auto fields = SplitFields(a_line);
+		if (fields.size() < 5 || fields[0].empty() || fields[1].empty() || fields[2].empty())
+			return std::nullopt;
+
+		Permutation permutation;
+		permutation.archive = fields[0];
+		permutation.source = fields[1];
+		permutation.profile = fields[2];
+		auto flags = ParseHex(fields[3]);
+		auto stripFlags = ParseHex(fields[4]);
+		if (!flags || !stripFlags)
+			return std::nullopt;
+		permutation.flags = *flags;
+		permutation.stripFlags = *stripFlags;
+
+		for (auto define : std::span{ fields }.subspan(5)) {
+			if (define.empty())
+				return std::nullopt;
+			const auto equals = define.find('=');
+			if (equals == std::string_view::npos)
+				permutation.defines.emplace_back(std::string(define), std::string());
+			else
+				permutation.defines.emplace_back(std::string(define.substr(0, equals)), std::string(define.substr(equals + 1)));
+		}
+		return permutation;
+	}
+
+	bool BuildManifest::Load()
+	{
+		std::lock_guard lock(mutex);
+		lines.clear();
+		session = 1;
+		dirty = false;
+
+		std::ifstream in(path);
+		std::string line;
+		if (!in.is_open() || !std::getline(in, line) || !line.starts_with(HeaderPrefix))
+			return false;
+		const auto version = ParseNumber(std::string_view(line).substr(HeaderPrefix.size()), 10);
+		if (version != 1 && version != Version)
+			return false;
+
+		size_t stored = 0;
+		while (std::getline(in, line)) {
+			if (line.starts_with(SessionPrefix)) {
+				if (auto saved = ParseNumber(std::string_view(line).substr(SessionPrefix.size()), 10))
+					session = *saved + 1;
+				continue;
+			}
+			if (line.empty() || line.starts_with('#'))
+				continue;
+
+			// version 1 lines count as seen in the session before this one
+			std::string_view permutationLine = line;
+			std::optional<uint32_t> lastSeen = 0;
+			if (version == Version) {
+				const auto tab = permutationLine.find('\t');
+				lastSeen = tab == std::string_view::npos ? std::nullopt : ParseNumber(permutationLine.substr(0, tab), 10);
+				permutationLine.remove_prefix(tab == std::string_view::npos ? permutationLine.size() : tab + 1);
+			}
+			auto permutation = Parse(permutationLine);
+			if (!lastSeen || !permutation)
+				continue;
+			stored++;
+			if (session - *lastSeen <= MaxAge)
+				lines.insert_or_assign(Format(*permutation), *lastSeen);
+		}
+		dirty = lines.size() != stored || version != Version;
+		return true;
+	}
+
+	bool BuildManifest::Save()
+	{
+		std::vector<std::pair<std::string, uint32_t>> sorted;
+		uint32_t savedSession;
+		{
+			std::lock_guard lock(mutex);
+			if (!dirty)
+				return true;
+			sorted.assign(lines.begin(), lines.end());
+			savedSession = session;
+			dirty = false;
+		}
+
+		std::error_code ec;
+		std::filesystem::create_directories(path.parent_path(), ec);
+		std::ofstream out(path, std::ios::trunc);
+		out << HeaderPrefix << Version << '\n';
+		out << SessionPrefix << savedSession << '\n';
+		for (const auto& [line, lastSeen] : sorted)
+			out << lastSeen << '\t' << line << '\n';
+		if (!out) {
+			std::lock_guard lock(mutex);
+			dirty = true;
+			return false;
+		}
+		return true;
+	}
+
+	bool BuildManifest::Record(const Permutation& a_permutation)
+	{
+		auto line = Format(a_permutation);
+		std::lock_guard lock(mutex);
+		auto [it, inserted] = lines.try_emplace(std::move(line), session);
+		if (!inserted) {
+			if (it->second == session)
+				return false;
+			it->second = session;
+		}
+		dirty = true;
+		return inserted;
+	}
+
+	size_t BuildManifest::EraseMissingSources()
+	{
+		std::lock_guard lock(mutex);
+		std::unordered_map<std::string, bool> exists;  // many permutations share a source
+		const size_t count = std::erase_if(lines, [&](const auto& a_entry) {
+			auto permutation = Parse(a_entry.first);
+			if (!permutation)
+				return true;
+			auto [it, inserted] = exists.try_emplace(permutation->source, false);
+			if (inserted) {
+				std::error_code ec;
+				it->second = std::filesystem::exists(permutation->source, ec);
+			}
+			return !it->second;
+		});
+		dirty |= count != 0;
+		return count;
+	}
+
+	std::vector<BuildManifest::Permutation> BuildManifest::GetPermutations() const
+	{
+		std::vector<Permutation> result;
+		std::lock_guard lock(mutex);
+		result.reserve(lines.size());
+		for (const auto& [line, lastSeen] : lines) {
+			if (auto permutation = Parse(line))
+				result.push_back(std::move(*permutation));
+		}
+		return result;
+	}
+
+	size_t BuildManifest::GetCount() const
+	{
+		std::lock_guard lock(mutex);
+		return lines.size();
+	}
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+namespace SIE
+{
+	/**
+	 * @brief List of fully resolved shader permutations for the offline cache builder.
+	 *
+	 * Defines depend on game state, so the plugin records every permutation it compiles with
+	 * everything needed to reproduce its disk cache key, and cs-cache-build compiles the list
+	 * outside the game. The file is text, one permutation per line:
+	 * `lastSeen<TAB>archive<TAB>source<TAB>profile<TAB>flags<TAB>stripFlags[<TAB>NAME[=VALUE]]...`
+	 * with flags in hex, after a `# cs-cache-build manifest <version>` header and a
+	 * `# session <n>` line. Version 1 files have no session and no lastSeen field.
+	 *
+	 * As in WarmList, each permutation is stamped with the session it was last recorded in,
+	 * sessions that did not change the list are not counted, and entries not recorded for
+	 * MaxAge sessions are dropped on Load(), so permutations of removed shaders age out.
+	 *
+	 * The class is plain C++ and does no logging so cs-cache-build can share it.
+	 */
+	class BuildManifest
+	{
+	public:
+		static constexpr uint32_t Version = 2;
+		static constexpr uint32_t MaxAge = 16;  // sessions
+
+		struct Permutation
+		{
+			std::string archive;  // disk archive name, `Data/ShaderCache/<archive>.pak`
+			std::string source;   // source path as passed to the compiler, e.g. `Data\Shaders\Lighting.hlsl`
+			std::string profile;
+			uint32_t flags = 0;
+			uint32_t stripFlags = 0;
+			std::vector<std::pair<std::string, std::string>> defines;
+		};
+
+		static std::string Format(const Permutation& a_permutation);
+		static std::optional<Permutation> Parse(std::string_view a_line);
+
+		explicit BuildManifest(std::filesystem::path a_path) :
+			path(std::move(a_path)) {}
+
+		/**
+		 * @brief Replaces the in-memory list with the file contents and starts a new session.
+		 * @return true if a valid manifest was read; malformed lines are skipped.
+		 */
+		bool Load();
+
+		/**
+		 * @brief Writes the manifest if permutations were recorded since the last Load() or Save().
+		 * @return true if the file is up to date.
+		 */
+		bool Save();
+
+		/**
+		 * @brief Records a permutation in the current session.
+		 * @return true if the permutation was not in the manifest yet.
+		 */
+		bool Record(const Permutation& a_permutation);
+
+		/**
+		 * @brief Drops permutations whose source file no longer exists, relative to the working directory.
+		 * @return The number of permutations dropped.
+		 */
+		size_t EraseMissingSources();
+
+		std::vector<Permutation> GetPermutations() const;
+		size_t GetCount() const;
+		const std::filesystem::path& GetPath() const { return path; }
+
+	private:
+		std::filesystem::path path;
+		mutable std::mutex mutex;
+		std::map<std::string, uint32_t> lines;  // formatted permutation to last seen session, sorted for stable output
+		uint32_t session = 1;
+		bool dirty = false;
+	};
+}
@@ -0,0 +1,41 @@
+#include "ShaderCache/ChangeCoalescer.h"
+
+namespace SIE
+{
+	bool ChangeCoalescer::Add(const std::string& a_path, Clock::time_point a_now)
+	{
+		if (paths.empty())
+			firstEvent = a_now;
+		lastEvent = a_now;
+		pendingEvents++;
+		if (!keys.insert(GetKey(a_path)).second)
+			return false;
+		paths.push_back(a_path);
+		return true;
+	}
+
+	std::vector<std::string> ChangeCoalescer::Take(Clock::time_point a_now)
+	{
+		if (paths.empty() || (a_now - lastEvent < settings.quiet && a_now - firstEvent < settings.maxDelay))
+			return {};
+		coalescedEvents += pendingEvents - paths.size();
+		pendingEvents = 0;
+		keys.clear();
+		return std::exchange(paths, {});
+	}
+
+	void ChangeCoalescer::Clear()
+	{
+		paths.clear();
+		keys.clear();
+		pendingEvents = 0;
+	}
+
+	std::string ChangeCoalescer::GetKey(const std::string& a_path)
+	{
+		std::string key = a_path;
+		std::ranges::replace(key, '\\', '/');
+		std::ranges::transform(key, key.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		return key;
+	}
+}
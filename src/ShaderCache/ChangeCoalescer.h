@@ -0,0 +1,73 @@
+#pragma once
+
+namespace SIE
+{
+	/**
+	 * @brief Collects file change events into deduplicated batches.
+	 *
+	 * Editors emit several events per save (truncate, write, rename over the target) and a
+	 * checkout touches many files at once. Events are gathered until no new one arrived for
+	 * the quiet period, or until the oldest pending event is `maxDelay` old so a steady
+	 * stream of events cannot hold changes back forever. Take() then returns every changed
+	 * path once, in the order it first changed.
+	 *
+	 * The class is plain C++ with no dependency on the game or D3D, so recorded event bursts
+	 * can be replayed through Add() and Take() offline. It is not thread safe; UpdateListener
+	 * guards it with its own mutex.
+	 */
+	class ChangeCoalescer
+	{
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		struct Settings
+		{
+			std::chrono::milliseconds quiet{ 300 };      // time without events before a batch is released
+			std::chrono::milliseconds maxDelay{ 2000 };  // longest a change waits while events keep arriving
+		};
+
+		ChangeCoalescer() = default;
+		explicit ChangeCoalescer(const Settings& a_settings) :
+			settings(a_settings) {}
+
+		/**
+		 * @brief Records a change event.
+		 *
+		 * @param a_path The changed file; paths differing only in case or slash direction are the same file.
+		 * @param a_now The time of the event.
+		 * @return true if the file was not already part of the pending batch.
+		 */
+		bool Add(const std::string& a_path, Clock::time_point a_now);
+
+		/**
+		 * @brief Returns the pending batch if it is due and starts a new one.
+		 *
+		 * @param a_now The current time.
+		 * @return The changed paths as first reported, or an empty list if nothing is due.
+		 */
+		std::vector<std::string> Take(Clock::time_point a_now);
+
+		bool Empty() const { return paths.empty(); }
+
+		/**
+		 * @brief Drops the pending batch.
+		 */
+		void Clear();
+
+		/**
+		 * @brief Number of events folded into the batches returned so far.
+		 */
+		uint64_t GetCoalescedEvents() const { return coalescedEvents; }
+
+	private:
+		static std::string GetKey(const std::string& a_path);
+
+		Settings settings;
+		std::vector<std::string> paths;        // pending batch in first-change order
+		std::unordered_set<std::string> keys;  // normalized paths of the pending batch
+		Clock::time_point firstEvent{};
+		Clock::time_point lastEvent{};
+		uint64_t pendingEvents = 0;
+		uint64_t coalescedEvents = 0;
+	};
+}
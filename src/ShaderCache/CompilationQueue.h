@@ -0,0 +1,122 @@
+#pragma once
+
+namespace SIE
+{
+	/**
+	 * @brief Set of pending tasks served by priority class, longest expected task first within a class.
+	 *
+	 * `Priority` is an enum with a trailing `Total` enumerator; lower values are served first.
+	 * Within a class, tasks with a higher cost are served first so long compiles overlap with
+	 * the many short ones instead of running alone at the end; equal costs are served FIFO.
+	 * Pushing a task that is already queued at a lower priority promotes it. The entry left
+	 * behind in the old class goes stale and is dropped when it reaches the front.
+	 *
+	 * The class is plain C++ with no dependency on the game or D3D and is not thread safe;
+	 * CompilationSet guards it with its own mutex.
+	 */
+	template <class Task, class Priority, class Hash = std::hash<Task>>
+	class CompilationQueue
+	{
+	public:
+		static constexpr size_t ClassCount = static_cast<size_t>(Priority::Total);
+
+		enum class PushResult
+		{
+			Added,
+			Promoted,
+			Unchanged,
+		};
+
+		/**
+		 * @param a_task The task to queue.
+		 * @param a_priority The class to queue it in.
+		 * @param a_cost Expected run time in any unit; only the order within a class depends on it.
+		 */
+		PushResult Push(const Task& a_task, Priority a_priority, float a_cost = 0.0f)
+		{
+			auto [it, inserted] = priorities.try_emplace(a_task, a_priority);
+			if (!inserted) {
+				if (a_priority >= it->second)
+					return PushResult::Unchanged;
+				it->second = a_priority;
+			}
+			queues[static_cast<size_t>(a_priority)].insert({ a_task, a_cost, sequence++ });
+			return inserted ? PushResult::Added : PushResult::Promoted;
+		}
+
+		/**
+		 * @brief Removes and returns the most expensive task of the highest non-empty priority class.
+		 */
+		std::optional<std::pair<Task, Priority>> Pop()
+		{
+			auto priority = Peek();
+			if (!priority.has_value())
+				return std::nullopt;
+
+			auto& queue = queues[static_cast<size_t>(*priority)];
+			std::pair<Task, Priority> result{ queue.begin()->task, *priority };
+			queue.erase(queue.begin());
+			priorities.erase(result.first);
+			return result;
+		}
+
+		/**
+		 * @brief Returns the priority class Pop() would serve next, dropping stale entries on the way.
+		 */
+		std::optional<Priority> Peek()
+		{
+			for (size_t i = 0; i < ClassCount; i++) {
+				auto& queue = queues[i];
+				while (!queue.empty()) {
+					auto it = priorities.find(queue.begin()->task);
+					if (it != priorities.end() && static_cast<size_t>(it->second) == i)
+						return static_cast<Priority>(i);
+					queue.erase(queue.begin());  // promoted to a higher class or already served
+				}
+			}
+			return std::nullopt;
+		}
+
+		std::optional<Priority> GetPriority(const Task& a_task) const
+		{
+			auto it = priorities.find(a_task);
+			if (it == priorities.end())
+				return std::nullopt;
+			return it->second;
+		}
+
+		bool Contains(const Task& a_task) const { return priorities.contains(a_task); }
+		bool Empty() const { return priorities.empty(); }
+		size_t Size() const { return priorities.size(); }
+
+		void Clear()
+		{
+			for (auto& queue : queues)
+				queue.clear();
+			priorities.clear();
+		}
+
+	private:
+		struct Entry
+		{
+			Task task;
+			float cost;
+			uint64_t sequence;  // push order, breaks cost ties FIFO
+		};
+
+		// serving order; a set rather than a heap since tasks may hold references and cannot be reassigned
+		struct Earlier
+		{
+			bool operator()(const Entry& a, const Entry& b) const
+			{
+				if (a.cost != b.cost)
+					return a.cost > b.cost;
+				return a.sequence < b.sequence;
+			}
+		};
+
+		std::array<std::set<Entry, Earlier>, ClassCount> queues;
+		std::unordered_map<Task, Priority, Hash> priorities;  // queued tasks and their current class
+		uint64_t sequence = 0;
+	};
+}
@@ -0,0 +1,122 @@
+#include "ShaderCache/CompileCostHistory.h"
+
+namespace SIE
+{
+	bool CompileCostHistory::Load()
+	{
+		std::unique_lock lock(mutex);
+		entries.clear();
+		groups.clear();
+		total = {};
+		dirty = false;
+
+		std::ifstream in(path, std::ios::binary);
+		if (!in.is_open())
+			return false;
+
+		std::error_code ec;
+		const auto fileSize = std::filesystem::file_size(path, ec);
+		Header header{};
+		if (ec || !in.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != Magic || header.version != Version ||
+			header.count > (fileSize - sizeof(Header)) / sizeof(Entry)) {
+			logger::warn("Ignoring invalid compile cost history {}", path.string());
+			return false;
+		}
+
+		std::vector<Entry> stored(header.count);
+		if (!in.read(reinterpret_cast<char*>(stored.data()), static_cast<std::streamsize>(stored.size() * sizeof(Entry)))) {
+			logger::warn("Compile cost history {} is truncated", path.string());
+			return false;
+		}
+
+		for (const auto& entry : stored) {
+			if (!(entry.milliseconds >= 0.0f) || !entry.samples || entries.contains(entry.key))
+				continue;
+			entries.emplace(entry.key, entry);
+			Apply(entry.key, nullptr, entry);
+		}
+		logger::info("Loaded compile times of {} permutations", entries.size());
+		return true;
+	}
+
+	bool CompileCostHistory::Save()
+	{
+		std::vector<Entry> sorted;
+		{
+			std::unique_lock lock(mutex);
+			if (!dirty)
+				return true;
+			sorted.reserve(entries.size());
+			for (const auto& [key, entry] : entries)
+				sorted.push_back(entry);
+			dirty = false;
+		}
+		std::ranges::sort(sorted, {}, &Entry::key);
+
+		const Header header{ Magic, Version, sorted.size() };
+		std::error_code ec;
+		std::filesystem::create_directories(path.parent_path(), ec);
+		std::ofstream out(path, std::ios::binary | std::ios::trunc);
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		out.write(reinterpret_cast<const char*>(sorted.data()), static_cast<std::streamsize>(sorted.size() * sizeof(Entry)));
+		if (!out) {
+			logger::error("Failed to write compile cost history {}", path.string());
+			std::unique_lock lock(mutex);
+			dirty = true;
+			return false;
+		}
+
+		logger::debug("Saved compile times of {} permutations", sorted.size());
+		return true;
+	}
+
+	void CompileCostHistory::Record(uint64_t a_key, float a_milliseconds)
+	{
+		if (!(a_milliseconds >= 0.0f))
+			return;
+
+		std::unique_lock lock(mutex);
+		auto [it, inserted] = entries.try_emplace(a_key, Entry{ a_key, a_milliseconds, 1 });
+		if (inserted) {
+			Apply(a_key, nullptr, it->second);
+		} else {
+			const Entry previous = it->second;
+			auto& entry = it->second;
+			const auto weight = static_cast<float>(std::min(entry.samples, MaxSamples - 1));
+			entry.milliseconds = (entry.milliseconds * weight + a_milliseconds) / (weight + 1.0f);
+			entry.samples = std::min(entry.samples + 1, MaxSamples);
+			Apply(a_key, &previous, entry);
+		}
+		dirty = true;
+	}
+
+	float CompileCostHistory::Estimate(uint64_t a_key) const
+	{
+		std::shared_lock lock(mutex);
+		if (auto it = entries.find(a_key); it != entries.end())
+			return it->second.milliseconds;
+		if (auto it = groups.find(GetGroup(a_key)); it != groups.end() && it->second.count)
+			return static_cast<float>(it->second.milliseconds / static_cast<double>(it->second.count));
+		if (total.count)
+			return static_cast<float>(total.milliseconds / static_cast<double>(total.count));
+		return DefaultMs;
+	}
+
+	size_t CompileCostHistory::GetCount() const
+	{
+		std::shared_lock lock(mutex);
+		return entries.size();
+	}
+
+	void CompileCostHistory::Apply(uint64_t a_key, const Entry* a_previous, const Entry& a_entry)
+	{
+		auto& group = groups[GetGroup(a_key)];
+		for (auto* sum : { &group, &total }) {
+			if (a_previous)
+				sum->milliseconds -= a_previous->milliseconds;
+			else
+				sum->count++;
+			sum->milliseconds += a_entry.milliseconds;
+		}
+	}
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+namespace SIE
+{
+	/**
+	 * @brief Measured compile time of shader permutations, persisted between sessions.
+	 *
+	 * Keys are packed with WarmList::Pack, so a permutation keeps its history across feature
+	 * sets and cache versions. Each entry is a running mean over the last few compiles. The file
+	 * is `Header | Entry array` and is rewritten whole by Save().
+	 *
+	 * Estimate() falls back from the permutation's own history to the mean of its shader type
+	 * and class, then to the mean of everything recorded, so a permutation never compiled on
+	 * this machine is still ranked against its siblings.
+	 *
+	 * The class is plain C++ and has no dependency on the game or D3D.
+	 */
+	class CompileCostHistory
+	{
+	public:
+		static constexpr uint32_t Magic = 0x43435343;  // "CSCC"
+		static constexpr uint32_t Version = 1;
+
+		static constexpr uint32_t MaxSamples = 4;   // weight of the stored mean against a new sample
+		static constexpr float DefaultMs = 250.0f;  // estimate before anything was recorded
+
+		struct Header
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint64_t count;
+		};
+		static_assert(sizeof(Header) == 16);
+
+		struct Entry
+		{
+			uint64_t key;
+			float milliseconds;
+			uint32_t samples;
+		};
+		static_assert(sizeof(Entry) == 16);
+
+		explicit CompileCostHistory(std::filesystem::path a_path) :
+			path(std::move(a_path)) {}
+
+		/**
+		 * @brief Replaces the in-memory history with the file contents.
+		 * @return true if a valid history was read.
+		 */
+		bool Load();
+
+		/**
+		 * @brief Writes the history if compiles were recorded since the last Load() or Save().
+		 * @return true if the file is up to date.
+		 */
+		bool Save();
+
+		/**
+		 * @brief Records the measured compile time of a permutation.
+		 */
+		void Record(uint64_t a_key, float a_milliseconds);
+
+		/**
+		 * @brief Returns the expected compile time of a permutation in milliseconds.
+		 */
+		float Estimate(uint64_t a_key) const;
+
+		size_t GetCount() const;
+
+	private:
+		struct Group
+		{
+			double milliseconds = 0.0;  // sum of the entries' means
+			uint64_t count = 0;
+		};
+
+		static uint64_t GetGroup(uint64_t a_key) { return a_key >> 32; }  // shader type and class
+		void Apply(uint64_t a_key, const Entry* a_previous, const Entry& a_entry);
+
+		std::filesystem::path path;
+		mutable std::shared_mutex mutex;  // guard for everything below
+		std::unordered_map<uint64_t, Entry> entries;
+		std::unordered_map<uint64_t, Group> groups;
+		Group total;
+		bool dirty = false;
+	};
+}
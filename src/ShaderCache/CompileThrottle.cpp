@@ -0,0 +1,72 @@
+#include "ShaderCache/CompileThrottle.h"
+
+namespace SIE
+{
+	bool CompileThrottle::OnFrame(float a_frameMs, bool a_idle)
+	{
+		std::lock_guard lock(mutex);
+		const int32_t previous = limit.load(std::memory_order_relaxed);
+
+		if (a_idle) {
+			// loading screen frame times say nothing about gameplay, so restart the average afterwards
+			idle.store(true, std::memory_order_relaxed);
+			hasAverage = false;
+			limit.store(std::max(settings.idleWorkers, 1), std::memory_order_relaxed);
+			return limit.load(std::memory_order_relaxed) > previous;
+		}
+		if (idle.exchange(false, std::memory_order_relaxed)) {
+			framesSinceChange = 0;
+			framesUnderBudget = 0;
+		}
+
+		if (a_frameMs > 0.0f && a_frameMs <= MaxSampleMs) {
+			float average = hasAverage ? averageFrameMs.load(std::memory_order_relaxed) : a_frameMs;
+			average += Smoothing * (a_frameMs - average);
+			averageFrameMs.store(average, std::memory_order_relaxed);
+			hasAverage = true;
+			framesSinceChange++;
+
+			// jitter around a budget that matches the frame cap must not take workers away
+			if (average > settings.frameBudgetMs * BackoffRatio) {
+				framesUnderBudget = 0;
+				if (framesSinceChange >= BackoffFrames && gameplayLimit > settings.minWorkers) {
+					gameplayLimit--;
+					framesSinceChange = 0;
+				}
+			} else if (average < settings.frameBudgetMs * HeadroomRatio) {
+				if (++framesUnderBudget >= RampFrames && gameplayLimit < settings.maxWorkers) {
+					gameplayLimit++;
+					framesUnderBudget = 0;
+					framesSinceChange = 0;
+				}
+			} else {
+				framesUnderBudget = 0;
+			}
+		}
+
+		limit.store(gameplayLimit, std::memory_order_relaxed);
+		return gameplayLimit > previous;
+	}
+
+	void CompileThrottle::SetSettings(const Settings& a_settings)
+	{
+		std::lock_guard lock(mutex);
+		settings = a_settings;
+		settings.minWorkers = std::max(settings.minWorkers, 1);
+		settings.maxWorkers = std::max(settings.maxWorkers, settings.minWorkers);
+		// a fresh controller starts at the ceiling, as the fixed thread count did
+		gameplayLimit = gameplayLimit ? Clamp(gameplayLimit) : settings.maxWorkers;
+		limit.store(idle.load(std::memory_order_relaxed) ? std::max(settings.idleWorkers, 1) : gameplayLimit, std::memory_order_relaxed);
+	}
+
+	CompileThrottle::Settings CompileThrottle::GetSettings() const
+	{
+		std::lock_guard lock(mutex);
+		return settings;
+	}
+
+	int32_t CompileThrottle::Clamp(int32_t a_workers) const
+	{
+		return std::clamp(a_workers, settings.minWorkers, settings.maxWorkers);
+	}
+}
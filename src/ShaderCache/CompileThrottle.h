@@ -0,0 +1,68 @@
+#pragma once
+
+namespace SIE
+{
+	/**
+	 * @brief Chooses how many background compile workers may run, from recent CPU frame times.
+	 *
+	 * Fed one sample per presented frame: the CPU work time of the frame, measured up to the
+	 * Present call. The time spent blocked in Present is left out, so with vsync or a frame cap
+	 * the samples show the real headroom instead of sitting at the refresh interval. While the
+	 * game is idle (loading screens, paused menus) the idle worker count is allowed at once.
+	 * During gameplay the limit backs off by one worker once the smoothed work time exceeds the
+	 * budget by more than the jitter tolerance, and climbs back by one only after it has stayed
+	 * comfortably under the budget for a while, so a single compile finishing never causes the
+	 * limit to oscillate.
+	 *
+	 * The class is plain C++ with no dependency on the game or D3D, so recorded frame-time
+	 * traces can be replayed through OnFrame() offline. GetLimit() may be read from any thread.
+	 */
+	class CompileThrottle
+	{
+	public:
+		struct Settings
+		{
+			float frameBudgetMs = 16.7f;  // smoothed gameplay CPU frame time to stay under
+			int32_t minWorkers = 1;       // gameplay floor, so compilation always makes progress
+			int32_t maxWorkers = 1;       // gameplay ceiling
+			int32_t idleWorkers = 1;      // used while loading or in a paused menu
+		};
+
+		static constexpr float Smoothing = 0.1f;       // weight of the newest frame in the average
+		static constexpr float HeadroomRatio = 0.85f;  // frame time must stay below this share of the budget to add a worker
+		static constexpr float BackoffRatio = 1.05f;   // frame time must exceed this share of the budget to remove one
+		static constexpr uint32_t BackoffFrames = 10;  // frames between two reductions
+		static constexpr uint32_t RampFrames = 90;     // frames under budget before adding a worker
+		static constexpr float MaxSampleMs = 250.0f;   // longer frames are hitches or alt-tabs and are ignored
+
+		/**
+		 * @brief Records a presented frame and updates the worker limit.
+		 *
+		 * @param a_frameMs CPU time of the frame, from the end of the previous Present to this one.
+		 * @param a_idle Whether the player is in a loading screen or a paused menu.
+		 * @return true if the limit grew, so waiting workers should be woken.
+		 */
+		bool OnFrame(float a_frameMs, bool a_idle);
+
+		void SetSettings(const Settings& a_settings);
+		Settings GetSettings() const;
+
+		int32_t GetLimit() const { return limit.load(std::memory_order_relaxed); }
+		float GetAverageFrameMs() const { return averageFrameMs.load(std::memory_order_relaxed); }
+		bool IsIdle() const { return idle.load(std::memory_order_relaxed); }
+
+	private:
+		int32_t Clamp(int32_t a_workers) const;
+
+		mutable std::mutex mutex;  // guard for settings and the frame history below
+		Settings settings;
+		int32_t gameplayLimit = 0;  // last gameplay limit, restored when leaving an idle screen
+		uint32_t framesSinceChange = 0;
+		uint32_t framesUnderBudget = 0;
+		bool hasAverage = false;
+
+		std::atomic<int32_t> limit = 1;
+		std::atomic<float> averageFrameMs = 0.0f;
+		std::atomic<bool> idle = false;
+	};
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+// bump only when cache key derivation or archive layout changes; shader and define changes are covered by the content-addressed keys
+static constexpr uint32_t SHADER_CACHE_FORMAT = 1;
+
+namespace SIE::ContentKey
+{
+	/**
+	 * @brief Key derivation shared by the plugin and the offline cache builder.
+	 *
+	 * Both sides must produce identical keys for the same permutation, so everything that goes
+	 * into a disk cache key lives here and depends only on the standard library and
+	 * unordered_dense.
+	 */
+	inline uint64_t HashCombine(uint64_t a_seed, std::string_view a_data)
+	{
+		const uint64_t hash = ankerl::unordered_dense::hash<std::string_view>{}(a_data);
+		return a_seed ^ (hash + 0x9e3779b97f4a7c15 + (a_seed << 6) + (a_seed >> 2));
+	}
+
+	/**
+	 * @brief Joins defines the way the compiler front end sees them: `NAME[=VALUE] ` per define.
+	 */
+	inline std::string MergeDefines(std::span<const std::pair<std::string, std::string>> a_defines)
+	{
+		std::string result;
+		for (const auto& [name, definition] : a_defines) {
+			result += name;
+			if (!definition.empty()) {
+				result += "=";
+				result += definition;
+			}
+			result += ' ';
+		}
+		return result;
+	}
+
+	/**
+	 * @param a_preprocessed Preprocessor output of the shader source with all includes expanded.
+	 * @param a_mergedDefines Defines as returned by MergeDefines().
+	 * @return A key that is never 0, so 0 can mean "no key".
+	 */
+	inline uint64_t Get(std::string_view a_preprocessed, std::string_view a_mergedDefines, std::string_view a_profile, uint32_t a_flags, uint32_t a_stripFlags)
+	{
+		uint64_t key = HashCombine(SHADER_CACHE_FORMAT, a_preprocessed);
+		key = HashCombine(key, a_mergedDefines);
+		key = HashCombine(key, a_profile);
+		key = HashCombine(key, std::format("{:X}:{:X}", a_flags, a_stripFlags));
+		return key ? key : 1;
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+namespace SIE
+{
+	/**
+	 * @brief How one shader type maps a requested descriptor pair to the permutation that is looked up.
+	 *
+	 * Many permutations requested by the game are compiled as one, e.g. lighting flags that are
+	 * computed in the shader instead, and some passes add flags of their own. Expressing this as
+	 * data keeps the per-draw cost to a table lookup and a few mask operations.
+	 *
+	 * The class is plain C++ and has no dependency on the game or D3D. Rules are constexpr, so
+	 * mappings can be checked with static_assert where the table is defined.
+	 */
+	struct DescriptorRemap
+	{
+		struct Technique
+		{
+			uint32_t shift = 0;
+			uint32_t mask = 0;   // technique bits after shifting
+			uint64_t reset = 0;  // techniques looked up as technique 0, one bit per technique
+		};
+
+		struct Context
+		{
+			bool deferred;      // the current pass writes the deferred targets
+			bool improvedSnow;  // bEnableImprovedSnow is set and this is not VR
+		};
+
+		uint32_t vertexClear = 0;    // flags removed from the vertex descriptor
+		uint32_t pixelClear = 0;     // flags removed from the pixel descriptor
+		uint32_t pixelMoveFrom = 0;  // pixel flag replaced by pixelMoveTo when set
+		uint32_t pixelMoveTo = 0;
+		uint32_t snow = 0;      // pixel flag removed unless improved snow is enabled
+		uint32_t deferred = 0;  // pixel flag added in deferred passes
+		Technique vertexTechnique;
+		Technique pixelTechnique;
+
+		constexpr void Apply(uint32_t& a_vertexDescriptor, uint32_t& a_pixelDescriptor, Context a_context) const
+		{
+			a_vertexDescriptor &= ~vertexClear;
+			a_pixelDescriptor &= ~pixelClear;
+			if (a_pixelDescriptor & pixelMoveFrom)
+				a_pixelDescriptor = (a_pixelDescriptor & ~pixelMoveFrom) | pixelMoveTo;
+			if (!a_context.improvedSnow)
+				a_pixelDescriptor &= ~snow;
+			if (a_context.deferred)
+				a_pixelDescriptor |= deferred;
+			a_vertexDescriptor = ResetTechnique(vertexTechnique, a_vertexDescriptor);
+			a_pixelDescriptor = ResetTechnique(pixelTechnique, a_pixelDescriptor);
+		}
+
+		static constexpr uint32_t ResetTechnique(const Technique& a_technique, uint32_t a_descriptor)
+		{
+			const uint32_t technique = (a_descriptor >> a_technique.shift) & a_technique.mask;
+			return (a_technique.reset >> technique) & 1 ? a_descriptor & ~(a_technique.mask << a_technique.shift) : a_descriptor;
+		}
+	};
+}
@@ -0,0 +1,227 @@
+#pragma once
+
+#include "ShaderCache/DescriptorRemap.h"
+#include "ShaderCache/ShaderFlags.h"
+#include "ShaderCache/ShaderLookup.h"
+
+namespace SIE
+{
+	/**
+	 * @brief Scheduling class of a compilation task; lower values are compiled first.
+	 */
+	enum class CompilationPriority
+	{
+		OnDemand,    // requested by a draw that is currently falling back to vanilla
+		Predicted,   // permutations the game ships for a loaded shader, likely to be drawn soon
+		Background,  // speculative prewarm, e.g. generated feature permutations
+		Total,
+	};
+
+	/**
+	 * @brief The parts of selecting a shader for a technique that need neither the game nor D3D.
+	 *
+	 * State and ShaderCache call these from the draw hooks, and tests/DrawPathBenchmark.cpp
+	 * times them on recorded technique streams, so the benchmark runs the code the game runs.
+	 */
+	namespace DrawPath
+	{
+		namespace detail
+		{
+			constexpr uint32_t Flags(auto... a_flags)
+			{
+				return (0u | ... | static_cast<uint32_t>(a_flags));
+			}
+
+			constexpr uint64_t Techniques(auto... a_techniques)
+			{
+				return (0ull | ... | (1ull << static_cast<uint32_t>(a_techniques)));
+			}
+		}
+
+		/**
+		 * @brief The descriptor remapping of every shader type, indexed by ShaderType.
+		 */
+		inline constexpr auto Remaps = []() {
+			using detail::Flags;
+			using detail::Techniques;
+			using Lighting = LightingShaderFlags;
+			using LightingTechnique = LightingShaderTechniques;
+			using Water = WaterShaderFlags;
+			using Effect = EffectShaderFlags;
+
+			// utility and image space shaders are looked up unchanged
+			std::array<DescriptorRemap, static_cast<size_t>(ShaderType::Total)> remaps{};
+
+			auto& lighting = remaps[static_cast<size_t>(ShaderType::Lighting)];
+			lighting.vertexClear = Flags(Lighting::AdditionalAlphaMask, Lighting::AmbientSpecular, Lighting::DoAlphaTest, Lighting::ShadowDir,
+				Lighting::DefShadow, Lighting::CharacterLight, Lighting::RimLighting, Lighting::SoftLighting, Lighting::BackLighting,
+				Lighting::Specular, Lighting::AnisoLighting, Lighting::BaseObjectIsSnow, Lighting::Snow, Lighting::TruePbr);
+			lighting.pixelClear = Flags(Lighting::AmbientSpecular, Lighting::ShadowDir, Lighting::DefShadow, Lighting::CharacterLight, Lighting::BaseObjectIsSnow);
+			lighting.pixelMoveFrom = Flags(Lighting::AdditionalAlphaMask);
+			lighting.pixelMoveTo = Flags(Lighting::DoAlphaTest);
+			lighting.snow = Flags(Lighting::Snow);
+			lighting.deferred = Flags(Lighting::Deferred);
+			lighting.vertexTechnique = { 24, 0x3F, Techniques(LightingTechnique::Glowmap, LightingTechnique::Parallax, LightingTechnique::Facegen, LightingTechnique::FacegenRGBTint, LightingTechnique::LODObjects, LightingTechnique::LODObjectHD, LightingTechnique::MultiIndexSparkle, LightingTechnique::Hair) };
+			lighting.pixelTechnique = { 24, 0x3F, Techniques(LightingTechnique::Glowmap) };
+
+			auto& water = remaps[static_cast<size_t>(ShaderType::Water)];
+			water.vertexClear = water.pixelClear = Flags(Water::Reflections, Water::Cubemap, Water::Interior);
+
+			auto& effect = remaps[static_cast<size_t>(ShaderType::Effect)];
+			effect.vertexClear = effect.pixelClear = Flags(Effect::GrayscaleToColor, Effect::GrayscaleToAlpha, Effect::IgnoreTexAlpha);
+			effect.deferred = Flags(Effect::Deferred);
+
+			remaps[static_cast<size_t>(ShaderType::DistantTree)].deferred = Flags(DistantTreeShaderFlags::Deferred);
+			remaps[static_cast<size_t>(ShaderType::Sky)].deferred = 256;
+			remaps[static_cast<size_t>(ShaderType::Grass)].vertexTechnique = { 0, 0xF, Techniques(GrassShaderTechniques::TruePbr) };
+
+			return remaps;
+		}();
+
+		/**
+		 * @brief Maps the descriptors a technique requests to the permutations that are looked up.
+		 */
+		constexpr std::pair<uint32_t, uint32_t> Remap(ShaderType a_type, uint32_t a_vertexDescriptor, uint32_t a_pixelDescriptor, DescriptorRemap::Context a_context)
+		{
+			Remaps[static_cast<size_t>(a_type)].Apply(a_vertexDescriptor, a_pixelDescriptor, a_context);
+			return { a_vertexDescriptor, a_pixelDescriptor };
+		}
+
+		// an additional alpha mask is looked up as alpha test, and parallax shares the vertex shader of technique 0
+		static_assert(Remap(ShaderType::Lighting, (3u << 24) | detail::Flags(LightingShaderFlags::Specular), detail::Flags(LightingShaderFlags::AdditionalAlphaMask), { false, true }) ==
+					  std::pair{ 0u, detail::Flags(LightingShaderFlags::DoAlphaTest) });
+		static_assert(Remap(ShaderType::Lighting, 0, detail::Flags(LightingShaderFlags::Snow), { true, false }) ==
+					  std::pair{ 0u, detail::Flags(LightingShaderFlags::Deferred) });
+		static_assert(Remap(ShaderType::Grass, 0x10 | 9, 0, { true, true }) == std::pair{ 0x10u, 0u });
+		static_assert(Remap(ShaderType::Utility, ~0u, ~0u, { true, false }) == std::pair{ ~0u, ~0u });
+
+		/**
+		 * Lookup slot marks that track a permutation's compilation, so the draw path can tell
+		 * queued and failed permutations apart without taking the compilation set's mutex.
+		 * A queued or compiling permutation stores 1 + the most urgent priority it was requested at.
+		 */
+		constexpr uint8_t NotPendingMark = 0;
+		constexpr uint8_t FailedMark = 0xFF;
+		constexpr uint8_t QueuedMark(CompilationPriority a_priority) { return static_cast<uint8_t>(1 + static_cast<int>(a_priority)); }
+		constexpr bool IsQueued(uint8_t a_mark) { return a_mark != NotPendingMark && a_mark != FailedMark; }
+		/**
+		 * @brief Whether a missing permutation still has to go through CompilationSet::Add.
+		 * @return false if it failed or is already queued at this priority or a more urgent one.
+		 */
+		constexpr bool NeedsQueue(uint8_t a_mark, CompilationPriority a_priority) { return a_mark == NotPendingMark || (a_mark != FailedMark && QueuedMark(a_priority) < a_mark); }
+
+		template <class T>
+		struct LookupResult
+		{
+			T* shader = nullptr;
+			bool record = false;  // record the permutation in the warm list
+			bool queue = false;   // missing and not queued at this priority yet
+		};
+
+		/**
+		 * @brief The lookup half of ShaderCache::Get*Shader, which never locks.
+		 * @param a_recordWarm Whether this lookup may record the permutation in the warm list.
+		 * A hit records only on the entry's first hit, a miss always does.
+		 */
+		template <class T>
+		LookupResult<T> Find(const ShaderLookup<T>& a_lookup, uint32_t a_descriptor, CompilationPriority a_priority, bool a_recordWarm)
+		{
+			bool firstHit = false;
+			if (T* shader = a_lookup.Find(a_descriptor, a_recordWarm ? &firstHit : nullptr))
+				return { shader, firstHit, false };
+			return { nullptr, a_recordWarm, NeedsQueue(a_lookup.GetMark(a_descriptor), a_priority) };
+		}
+
+		/**
+		 * Optional descriptor flags that may be dropped to find a stand-in while the exact
+		 * permutation compiles. Pixel flags only change the pixel shader; shared flags change
+		 * the vertex-to-pixel interface, so they are dropped from both stages together.
+		 */
+		struct FallbackFlags
+		{
+			uint32_t pixel = 0;
+			uint32_t shared = 0;
+		};
+
+		constexpr FallbackFlags GetFallbackFlags(ShaderType a_type)
+		{
+			switch (a_type) {
+			case ShaderType::Lighting:
+				return { detail::Flags(LightingShaderFlags::Snow, LightingShaderFlags::AnisoLighting), detail::Flags(LightingShaderFlags::ProjectedUV) };
+			case ShaderType::Effect:
+				return { 0, detail::Flags(EffectShaderFlags::ProjectedUv) };
+			default:
+				return {};
+			}
+		}
+
+		enum class Fallback
+		{
+			NotNeeded,    // both stages are compiled, or a missing one is not queued
+			Substituted,  // the descriptors were replaced by compiled ones
+			NotFound,     // no compiled stand-in yet
+		};
+
+		/**
+		 * @brief The search of ShaderCache::ResolveFallback, dropping as few optional flags as possible.
+		 * @param a_queue Called with (vertexMissing, pixelMissing) before the marks are read, to queue the exact permutations.
+		 */
+		template <class V, class P, class F>
+		Fallback FindFallback(const ShaderLookup<V>& a_vertexLookup, const ShaderLookup<P>& a_pixelLookup, FallbackFlags a_flags,
+			uint32_t& a_vertexDescriptor, uint32_t& a_pixelDescriptor, bool a_skipPixelShader, F&& a_queue)
+		{
+			const bool vertexReady = a_vertexLookup.Find(a_vertexDescriptor) != nullptr;
+			const bool pixelReady = a_skipPixelShader || a_pixelLookup.Find(a_pixelDescriptor) != nullptr;
+			if (vertexReady && pixelReady)
+				return Fallback::NotNeeded;
+
+			a_queue(!vertexReady, !pixelReady);
+			// failed, blocked or unsupported permutations keep their vanilla behaviour
+			if ((!vertexReady && !IsQueued(a_vertexLookup.GetMark(a_vertexDescriptor))) ||
+				(!pixelReady && !IsQueued(a_pixelLookup.GetMark(a_pixelDescriptor))))
+				return Fallback::NotNeeded;
+
+			// each type has at most a handful of optional flags
+			const uint32_t optional = (a_vertexDescriptor & a_flags.shared) | (a_pixelDescriptor & (a_flags.pixel | a_flags.shared));
+			for (int dropped = 1; dropped <= std::popcount(optional); dropped++) {
+				for (uint32_t drop = optional; drop != 0; drop = (drop - 1) & optional) {
+					if (std::popcount(drop) != dropped)
+						continue;
+					const uint32_t vertexCandidate = a_vertexDescriptor & ~(drop & a_flags.shared);
+					const uint32_t pixelCandidate = a_pixelDescriptor & ~drop;
+					if (a_vertexLookup.Find(vertexCandidate) && (a_skipPixelShader || a_pixelLookup.Find(pixelCandidate))) {
+						a_vertexDescriptor = vertexCandidate;
+						a_pixelDescriptor = pixelCandidate;
+						return Fallback::Substituted;
+					}
+				}
+			}
+			return Fallback::NotFound;
+		}
+
+		/**
+		 * @brief The descriptors State::Draw last uploaded to the permutation constant buffer.
+		 */
+		struct PermutationState
+		{
+			uint32_t vertexDescriptor = 0;
+			uint32_t pixelDescriptor = 0;
+			uint32_t extraDescriptor = 0;
+			bool forceUpdate = true;  // set at the start of each frame
+
+			/**
+			 * @return true if the buffer has to be uploaded. Only pixel and extra descriptor changes trigger one.
+			 */
+			constexpr bool Update(uint32_t a_vertexDescriptor, uint32_t a_pixelDescriptor, uint32_t a_extraDescriptor)
+			{
+				if (!forceUpdate && a_pixelDescriptor == pixelDescriptor && a_extraDescriptor == extraDescriptor)
+					return false;
+				vertexDescriptor = a_vertexDescriptor;
+				pixelDescriptor = a_pixelDescriptor;
+				extraDescriptor = a_extraDescriptor;
+				forceUpdate = false;
+				return true;
+			}
+		};
+	}
+}
@@ -0,0 +1,61 @@
+#include "ShaderCache/IncludeCache.h"
+
+namespace SIE
+{
+	std::string IncludeCache::GetKey(const std::filesystem::path& a_path)
+	{
+		std::error_code ec;
+		auto absolute = std::filesystem::absolute(a_path, ec);
+		auto key = (ec ? a_path : absolute).lexically_normal().generic_string();
+		std::ranges::transform(key, key.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		return key;
+	}
+
+	IncludeCache::Contents IncludeCache::Get(const std::filesystem::path& a_path)
+	{
+		std::error_code ec;
+		const auto writeTime = std::filesystem::last_write_time(a_path, ec);
+		if (ec)
+			return nullptr;
+
+		const auto key = GetKey(a_path);
+		{
+			std::shared_lock lock(mutex);
+			auto it = entries.find(key);
+			if (it != entries.end() && it->second.writeTime == writeTime) {
+				hits++;
+				bytesServed += it->second.contents->size();
+				return it->second.contents;
+			}
+		}
+
+		std::ifstream file(a_path, std::ios::binary);
+		if (!file.is_open())
+			return nullptr;
+		auto contents = std::make_shared<const std::string>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		misses++;
+		bytesRead += contents->size();
+
+		std::unique_lock lock(mutex);
+		entries.insert_or_assign(key, Entry{ contents, writeTime });
+		return contents;
+	}
+
+	void IncludeCache::Invalidate(const std::filesystem::path& a_path)
+	{
+		std::unique_lock lock(mutex);
+		entries.erase(GetKey(a_path));
+	}
+
+	void IncludeCache::Clear()
+	{
+		std::unique_lock lock(mutex);
+		entries.clear();
+	}
+
+	IncludeCache::Stats IncludeCache::GetStats() const
+	{
+		std::shared_lock lock(mutex);
+		return { hits, misses, bytesServed, bytesRead, entries.size() };
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+namespace SIE
+{
+	/**
+	 * @brief Process-wide cache of shader source files opened through `#include`.
+	 *
+	 * Entries are keyed by normalized absolute path and validated against the file's last write
+	 * time on every lookup, so a stale entry is never served even without the file watcher.
+	 * Invalidate() drops an entry early when the watcher reports a change. Contents are handed
+	 * out as shared pointers and stay valid while the compiler holds them.
+	 *
+	 * The class is plain C++ with no dependency on the game or D3D and is thread safe.
+	 */
+	class IncludeCache
+	{
+	public:
+		using Contents = std::shared_ptr<const std::string>;
+
+		struct Stats
+		{
+			uint64_t hits;         // opens served from memory
+			uint64_t misses;       // opens that read the file
+			uint64_t bytesServed;  // bytes served from memory instead of disk
+			uint64_t bytesRead;
+			size_t files;
+		};
+
+		/**
+		 * @return The file contents, or nullptr if the file does not exist or cannot be read.
+		 */
+		Contents Get(const std::filesystem::path& a_path);
+
+		void Invalidate(const std::filesystem::path& a_path);
+		void Clear();
+		Stats GetStats() const;
+
+	private:
+		struct Entry
+		{
+			Contents contents;
+			std::filesystem::file_time_type writeTime;
+		};
+
+		static std::string GetKey(const std::filesystem::path& a_path);
+
+		mutable std::shared_mutex mutex;
+		std::unordered_map<std::string, Entry> entries;
+		std::atomic<uint64_t> hits = 0;
+		std::atomic<uint64_t> misses = 0;
+		std::atomic<uint64_t> bytesServed = 0;
+		std::atomic<uint64_t> bytesRead = 0;
+	};
+}
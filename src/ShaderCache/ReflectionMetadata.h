@@ -0,0 +1,67 @@
+#pragma once
+
+namespace SIE
+{
+	/**
+	 * @brief Constant buffer layout derived from reflecting a shader blob.
+	 *
+	 * Holds what `ReflectConstantBuffers` produces (buffer sizes, constant offsets and the vertex
+	 * input description) in a flat record that is stored in the disk archive next to the blob,
+	 * so a warm start can rebuild a shader without calling D3DReflect.
+	 *
+	 * The record is `Header | int8_t offsets[tableSize]`. The class is plain C++ and has no
+	 * dependency on the game or D3D.
+	 */
+	template <size_t TableSize>
+	struct ReflectionMetadata
+	{
+		// bump whenever the variable tables used by ReflectConstantBuffers change meaning
+		static constexpr uint32_t Version = 1;
+
+		struct Header
+		{
+			uint32_t version;
+			uint32_t tableSize;
+			uint32_t bufferSizes[3];
+			uint32_t reserved;
+			uint64_t vertexDesc;
+		};
+		static_assert(sizeof(Header) == 32);
+
+		std::array<size_t, 3> bufferSizes{};
+		std::array<int8_t, TableSize> constantOffsets{};
+		uint64_t vertexDesc = 0;
+
+		std::vector<uint8_t> Serialize() const
+		{
+			const Header header{
+				.version = Version,
+				.tableSize = static_cast<uint32_t>(TableSize),
+				.bufferSizes = { static_cast<uint32_t>(bufferSizes[0]), static_cast<uint32_t>(bufferSizes[1]), static_cast<uint32_t>(bufferSizes[2]) },
+				.reserved = 0,
+				.vertexDesc = vertexDesc
+			};
+			std::vector<uint8_t> data(sizeof(Header) + TableSize);
+			std::memcpy(data.data(), &header, sizeof(Header));
+			std::memcpy(data.data() + sizeof(Header), constantOffsets.data(), TableSize);
+			return data;
+		}
+
+		/**
+		 * @return false if a_data is not a record of this version and table size.
+		 */
+		bool Deserialize(std::span<const uint8_t> a_data)
+		{
+			Header header;
+			if (a_data.size() != sizeof(Header) + TableSize)
+				return false;
+			std::memcpy(&header, a_data.data(), sizeof(Header));
+			if (header.version != Version || header.tableSize != TableSize)
+				return false;
+			bufferSizes = { header.bufferSizes[0], header.bufferSizes[1], header.bufferSizes[2] };
+			vertexDesc = header.vertexDesc;
+			std::memcpy(constantOffsets.data(), a_data.data() + sizeof(Header), TableSize);
+			return true;
+		}
+	};
+}
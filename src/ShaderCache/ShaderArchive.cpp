@@ -0,0 +1,398 @@
+#include "ShaderCache/ShaderArchive.h"
+
+namespace SIE
+{
+	namespace
+	{
+		std::chrono::system_clock::time_point FromTicks(int64_t a_ticks)
+		{
+			return std::chrono::system_clock::time_point(std::chrono::system_clock::duration(a_ticks));
+		}
+	}
+
+	struct ShaderArchive::Mapping
+	{
+		HANDLE section = nullptr;
+		const uint8_t* view = nullptr;
+		uint64_t size = 0;
+		std::unique_ptr<std::atomic<bool>[]> used;  // per table entry, set by Find()
+		std::filesystem::path retiredPath;          // set once the file was moved aside while blobs used it
+
+		~Mapping()
+		{
+			if (view)
+				UnmapViewOfFile(view);
+			if (section)
+				CloseHandle(section);
+			if (!retiredPath.empty()) {
+				std::error_code ec;
+				std::filesystem::remove(retiredPath, ec);
+			}
+		}
+
+		const Header& GetHeader() const { return *reinterpret_cast<const Header*>(view); }
+	};
+
+	ShaderArchive::ShaderArchive(std::filesystem::path a_path) :
+		path(std::move(a_path))
+	{
+		journalPath = path;
+		journalPath += L".log";
+	}
+
+	ShaderArchive::~ShaderArchive()
+	{
+		Close();
+	}
+
+	bool ShaderArchive::Open()
+	{
+		std::unique_lock lock(mutex);
+		journal.close();
+		pending.clear();
+		erased.clear();
+		RemoveRetired();
+
+		if (!MapLocked()) {
+			logger::warn("Discarding invalid shader archive {}", path.string());
+			mapping.reset();
+			std::error_code ec;
+			std::filesystem::remove(path, ec);
+		}
+
+		session = mapping ? mapping->GetHeader().session + 1 : 1;
+		LoadJournalLocked();
+		if (!pending.empty() || !erased.empty())
+			CompactLocked();
+
+		logger::debug("Opened shader archive {} with {} entries", path.string(), GetTable().size() + pending.size());
+		return true;
+	}
+
+	void ShaderArchive::Close()
+	{
+		std::unique_lock lock(mutex);
+		journal.close();
+		mapping.reset();
+		pending.clear();
+		erased.clear();
+		expired.clear();
+	}
+
+	bool ShaderArchive::Compact()
+	{
+		std::unique_lock lock(mutex);
+		return CompactLocked();
+	}
+
+	bool ShaderArchive::Delete()
+	{
+		std::unique_lock lock(mutex);
+		journal.close();
+		bool deleted = !mapping || mapping.use_count() == 1 || RetireLocked();
+		mapping.reset();
+		pending.clear();
+		erased.clear();
+		expired.clear();
+
+		std::error_code ec;
+		std::filesystem::remove(path, ec);
+		deleted = deleted && !ec;
+		std::filesystem::remove(journalPath, ec);
+		return deleted && !ec;
+	}
+
+	ShaderArchive::Blob ShaderArchive::Find(uint64_t a_key) const
+	{
+		std::shared_lock lock(mutex);
+		if (erased.contains(a_key))
+			return {};
+
+		if (auto it = pending.find(a_key); it != pending.end()) {
+			const auto& [data, writeTime] = it->second;
+			return { std::span<const uint8_t>(*data), FromTicks(writeTime), data };
+		}
+
+		auto table = GetTable();
+		auto it = std::ranges::lower_bound(table, a_key, {}, &Entry::key);
+		if (it == table.end() || it->key != a_key)
+			return {};
+
+		const uint64_t offset = mapping->GetHeader().dataOffset + it->offset;
+		if (offset + it->size > mapping->size) {
+			logger::warn("Shader archive {} entry {:X} is out of bounds", path.string(), a_key);
+			return {};
+		}
+		mapping->used[it - table.begin()].store(true, std::memory_order_relaxed);
+		return { std::span<const uint8_t>(mapping->view + offset, it->size), FromTicks(it->writeTime), mapping };
+	}
+
+	bool ShaderArchive::Append(uint64_t a_key, std::span<const uint8_t> a_data)
+	{
+		if (a_data.empty())
+			return false;
+
+		const int64_t now = std::chrono::system_clock::now().time_since_epoch().count();
+		auto storage = std::make_shared<std::vector<uint8_t>>(a_data.begin(), a_data.end());
+
+		std::unique_lock lock(mutex);
+		pending.insert_or_assign(a_key, PendingBlob{ storage, now });
+		erased.erase(a_key);
+		return WriteJournalRecordLocked({ a_key, static_cast<uint32_t>(a_data.size()), kNone, now }, a_data);
+	}
+
+	bool ShaderArchive::Erase(uint64_t a_key)
+	{
+		std::unique_lock lock(mutex);
+		auto table = GetTable();
+		const bool inTable = std::ranges::binary_search(table, a_key, {}, &Entry::key);
+		const bool wasPending = pending.erase(a_key) > 0;
+		if (!inTable && !wasPending)
+			return false;
+
+		erased.insert(a_key);
+		const int64_t now = std::chrono::system_clock::now().time_since_epoch().count();
+		return WriteJournalRecordLocked({ a_key, 0, kErased, now }, {});
+	}
+
+	std::vector<uint64_t> ShaderArchive::TakeExpired()
+	{
+		std::unique_lock lock(mutex);
+		return std::exchange(expired, {});
+	}
+
+	size_t ShaderArchive::GetEntryCount() const
+	{
+		std::shared_lock lock(mutex);
+		return GetTable().size();
+	}
+
+	size_t ShaderArchive::GetPendingCount() const
+	{
+		std::shared_lock lock(mutex);
+		return pending.size();
+	}
+
+	uint32_t ShaderArchive::GetSession() const
+	{
+		std::shared_lock lock(mutex);
+		return session;
+	}
+
+	bool ShaderArchive::MapLocked()
+	{
+		mapping.reset();
+
+		std::error_code ec;
+		if (!std::filesystem::exists(path, ec))
+			return true;
+
+		HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+			OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			logger::warn("Failed to open shader archive {}: {}", path.string(), GetLastError());
+			return false;
+		}
+
+		LARGE_INTEGER fileSize{};
+		if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart < static_cast<LONGLONG>(sizeof(Header))) {
+			CloseHandle(file);
+			return false;
+		}
+
+		auto newMapping = std::make_shared<Mapping>();
+		newMapping->size = static_cast<uint64_t>(fileSize.QuadPart);
+		newMapping->section = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		CloseHandle(file);  // the section keeps its own reference
+		if (!newMapping->section) {
+			logger::warn("Failed to map shader archive {}: {}", path.string(), GetLastError());
+			return false;
+		}
+
+		newMapping->view = static_cast<const uint8_t*>(MapViewOfFile(newMapping->section, FILE_MAP_READ, 0, 0, 0));
+		if (!newMapping->view) {
+			logger::warn("Failed to map view of shader archive {}: {}", path.string(), GetLastError());
+			return false;
+		}
+
+		const auto& header = newMapping->GetHeader();
+		const uint64_t tableEnd = header.tableOffset + header.entryCount * sizeof(Entry);
+		if (header.magic != Magic || (header.version != 1 && header.version != Version) ||
+			header.tableOffset < sizeof(Header) || tableEnd > newMapping->size ||
+			header.dataOffset < tableEnd || header.dataOffset > newMapping->size) {
+			return false;
+		}
+
+		newMapping->used = std::make_unique<std::atomic<bool>[]>(header.entryCount);
+		mapping = std::move(newMapping);
+		return true;
+	}
+
+	void ShaderArchive::LoadJournalLocked()
+	{
+		std::ifstream in(journalPath, std::ios::binary);
+		if (!in.is_open())
+			return;
+
+		std::error_code ec;
+		const uint64_t fileSize = std::filesystem::file_size(journalPath, ec);
+		if (ec)
+			return;
+
+		JournalRecord record{};
+		uint64_t position = 0;
+		while (in.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+			position += sizeof(record);
+			if (record.flags & kErased) {
+				pending.erase(record.key);
+				erased.insert(record.key);
+				continue;
+			}
+
+			// a torn or corrupt record must not allocate more than the journal can hold
+			if (record.size > fileSize - position) {
+				logger::warn("Shader archive journal {} is truncated; ignoring partial entry {:X}", journalPath.string(), record.key);
+				break;
+			}
+			position += record.size;
+
+			auto storage = std::make_shared<std::vector<uint8_t>>(record.size);
+			if (!in.read(reinterpret_cast<char*>(storage->data()), record.size)) {
+				logger::warn("Shader archive journal {} is truncated; ignoring partial entry {:X}", journalPath.string(), record.key);
+				break;
+			}
+			pending.insert_or_assign(record.key, PendingBlob{ std::move(storage), record.writeTime });
+			erased.erase(record.key);
+		}
+	}
+
+	bool ShaderArchive::CompactLocked()
+	{
+		if (pending.empty() && erased.empty() && !HasStaleUsesLocked())
+			return true;
+
+		std::vector<Source> sources;
+		sources.reserve(GetTable().size() + pending.size());
+		std::vector<uint64_t> dropped;
+		if (mapping) {
+			const uint64_t dataOffset = mapping->GetHeader().dataOffset;
+			const auto table = GetTable();
+			for (size_t i = 0; i < table.size(); i++) {
+				const auto& entry = table[i];
+				if (erased.contains(entry.key) || pending.contains(entry.key))
+					continue;
+				if (dataOffset + entry.offset + entry.size > mapping->size)
+					continue;
+				const uint32_t lastUsed = mapping->used[i].load(std::memory_order_relaxed) ? session : entry.lastUsed;
+				if (session - lastUsed > MaxAge) {
+					dropped.push_back(entry.key);
+					continue;
+				}
+				sources.push_back({ entry.key, { mapping->view + dataOffset + entry.offset, entry.size }, entry.writeTime, lastUsed });
+			}
+		}
+		for (const auto& [key, blob] : pending)
+			sources.push_back({ key, *blob.data, blob.writeTime, session });
+
+		auto tempPath = path;
+		tempPath += L".tmp";
+		const auto blobCount = Write(tempPath, sources, session);
+		if (!blobCount.has_value()) {
+			logger::error("Failed to write shader archive {}", tempPath.string());
+			return false;
+		}
+
+		journal.close();
+		std::error_code ec;
+		if (mapping && mapping.use_count() > 1 && !RetireLocked()) {
+			std::filesystem::remove(tempPath, ec);
+			return false;
+		}
+		mapping.reset();
+		std::filesystem::rename(tempPath, path, ec);
+		if (ec) {
+			logger::error("Failed to replace shader archive {}: {}", path.string(), ec.message());
+			std::filesystem::remove(tempPath, ec);
+			MapLocked();
+			return false;
+		}
+		std::filesystem::remove(journalPath, ec);
+
+		logger::debug("Compacted shader archive {} to {} entries sharing {} blobs ({} merged, {} erased, {} expired)", path.string(), sources.size(), *blobCount, pending.size(), erased.size(), dropped.size());
+		expired.insert(expired.end(), dropped.begin(), dropped.end());
+		pending.clear();
+		erased.clear();
+		return MapLocked();
+	}
+
+	bool ShaderArchive::WriteJournalRecordLocked(const JournalRecord& a_record, std::span<const uint8_t> a_data)
+	{
+		if (!journal.is_open()) {
+			std::error_code ec;
+			std::filesystem::create_directories(journalPath.parent_path(), ec);
+			journal.open(journalPath, std::ios::binary | std::ios::app);
+			if (!journal.is_open()) {
+				logger::error("Failed to open shader archive journal {}", journalPath.string());
+				return false;
+			}
+		}
+
+		journal.write(reinterpret_cast<const char*>(&a_record), sizeof(a_record));
+		if (!a_data.empty())
+			journal.write(reinterpret_cast<const char*>(a_data.data()), static_cast<std::streamsize>(a_data.size()));
+		journal.flush();
+		if (!journal) {
+			logger::error("Failed to append to shader archive journal {}", journalPath.string());
+			journal.close();
+			return false;
+		}
+		return true;
+	}
+
+	bool ShaderArchive::HasStaleUsesLocked() const
+	{
+		const auto table = GetTable();
+		for (size_t i = 0; i < table.size(); i++) {
+			if (session - table[i].lastUsed >= RefreshAge && mapping->used[i].load(std::memory_order_relaxed))
+				return true;
+		}
+		return false;
+	}
+
+	bool ShaderArchive::RetireLocked()
+	{
+		// a mapped file cannot be replaced or deleted, but it can be renamed
+		auto retiredPath = path;
+		retiredPath += std::format(".{}.old", retiredCount++);
+		std::error_code ec;
+		std::filesystem::rename(path, retiredPath, ec);
+		if (ec) {
+			logger::warn("Failed to move aside shader archive {} still in use: {}", path.string(), ec.message());
+			return false;
+		}
+		mapping->retiredPath = std::move(retiredPath);
+		return true;
+	}
+
+	void ShaderArchive::RemoveRetired() const
+	{
+		// files moved aside by a session that ended before releasing them
+		const auto prefix = path.filename().string() + ".";
+		std::error_code ec;
+		for (const auto& entry : std::filesystem::directory_iterator(path.parent_path(), ec)) {
+			const auto name = entry.path().filename().string();
+			if (name.starts_with(prefix) && name.ends_with(".old")) {
+				std::error_code removeError;
+				std::filesystem::remove(entry.path(), removeError);
+			}
+		}
+	}
+
+	std::span<const ShaderArchive::Entry> ShaderArchive::GetTable() const
+	{
+		if (!mapping)
+			return {};
+		const auto& header = mapping->GetHeader();
+		return { reinterpret_cast<const Entry*>(mapping->view + header.tableOffset), static_cast<size_t>(header.entryCount) };
+	}
+}
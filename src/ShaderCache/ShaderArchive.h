@@ -0,0 +1,171 @@
+#pragma once
+
+namespace SIE
+{
+	/**
+	 * @brief Packed, memory-mapped container for compiled shader blobs.
+	 *
+	 * One archive holds every cached permutation of a single shader file, replacing
+	 * the old one-file-per-permutation layout. The on-disk format is
+	 * `Header | sorted Entry table | blob region`, mapped read-only once at open
+	 * so lookups are a binary search and blobs are served without copying. A Blob
+	 * keeps its mapping alive, so it can be held for the whole session: Compact() and
+	 * Delete() move a file that is still mapped aside to `<archive>.<n>.old`, which is
+	 * deleted once its last Blob is released.
+	 *
+	 * Newly compiled blobs are appended to a sidecar journal (`<archive>.log`) and
+	 * served from memory until the next Compact(), which merges the journal into
+	 * a fresh archive. Compaction happens automatically on Open(). Entries whose
+	 * blobs are byte-identical share a single copy in the blob region.
+	 *
+	 * Each entry is stamped with the session it was last found or written in. As in
+	 * WarmList, only sessions that rewrite the archive are counted; a rewrite drops
+	 * entries not used for MaxAge sessions, so blobs and reflection records of
+	 * superseded content keys do not accumulate. Uses of entries older than RefreshAge
+	 * make Compact() rewrite the archive even without new blobs, so their stamps persist.
+	 *
+	 * The class is plain C++ on top of Win32 file mapping and has no dependency
+	 * on the game or D3D.
+	 */
+	class ShaderArchive
+	{
+	public:
+		static constexpr uint32_t Magic = 0x4B505343;  // "CSPK"
+		static constexpr uint32_t Version = 2;
+		static constexpr uint32_t MaxAge = 16;     // sessions
+		static constexpr uint32_t RefreshAge = 8;  // sessions
+
+		struct Header
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint32_t entryCount;
+			uint32_t session;  // the session that wrote the archive; the upper half of version 1's 64-bit entry count, so 0
+			uint64_t tableOffset;
+			uint64_t dataOffset;
+		};
+		static_assert(sizeof(Header) == 32);
+
+		struct Entry
+		{
+			uint64_t key;
+			uint64_t offset;  // relative to Header::dataOffset
+			uint32_t size;
+			uint32_t lastUsed;  // session the entry was last found or written in; 0 in version 1 archives
+			int64_t writeTime;  // system_clock ticks
+		};
+		static_assert(sizeof(Entry) == 32);
+
+		struct Blob
+		{
+			std::span<const uint8_t> data;
+			std::chrono::system_clock::time_point writeTime;
+			std::shared_ptr<const void> owner;  // keeps the mapping or journal storage alive while data is in use
+
+			explicit operator bool() const { return !data.empty(); }
+		};
+
+		struct Source
+		{
+			uint64_t key;
+			std::span<const uint8_t> data;
+			int64_t writeTime;  // system_clock ticks
+			uint32_t lastUsed = 0;
+		};
+
+		/**
+		 * @brief Writes a complete archive holding a_sources, sharing storage between identical blobs.
+		 *
+		 * Used by Compact() and by the offline cache builder; lives in ShaderArchiveWriter.cpp,
+		 * which only depends on the standard library and unordered_dense.
+		 * @param a_sources Entries with unique keys; reordered by key.
+		 * @param a_session The session stored in the header; entries age relative to it.
+		 * @return The number of distinct blobs written, or nullopt if the file could not be written.
+		 */
+		static std::optional<size_t> Write(const std::filesystem::path& a_path, std::span<Source> a_sources, uint32_t a_session = 0);
+
+		explicit ShaderArchive(std::filesystem::path a_path);
+		~ShaderArchive();
+
+		ShaderArchive(const ShaderArchive&) = delete;
+		ShaderArchive& operator=(const ShaderArchive&) = delete;
+
+		/**
+		 * @brief Maps the archive and replays its journal, compacting if the journal had entries.
+		 * @return true if the archive is usable (a missing file is a valid empty archive).
+		 */
+		bool Open();
+		void Close();
+
+		/**
+		 * @brief Rewrites the archive with all journal entries merged in and erased and expired entries dropped.
+		 *
+		 * @return true if the archive was rewritten or nothing needed compacting.
+		 */
+		bool Compact();
+
+		/**
+		 * @brief Closes the archive and deletes its files.
+		 * @return false if a file could not be deleted or moved aside.
+		 */
+		bool Delete();
+
+		Blob Find(uint64_t a_key) const;
+		bool Append(uint64_t a_key, std::span<const uint8_t> a_data);
+		bool Erase(uint64_t a_key);
+
+		/**
+		 * @brief Returns the keys dropped for age since the last call, so indexes of the archive can forget them.
+		 */
+		std::vector<uint64_t> TakeExpired();
+
+		size_t GetEntryCount() const;
+		size_t GetPendingCount() const;
+		uint32_t GetSession() const;
+		const std::filesystem::path& GetPath() const { return path; }
+
+	private:
+		struct Mapping;
+		struct PendingBlob
+		{
+			std::shared_ptr<std::vector<uint8_t>> data;
+			int64_t writeTime;
+		};
+
+		enum JournalFlags : uint32_t
+		{
+			kNone = 0,
+			kErased = 1 << 0,
+		};
+
+		struct JournalRecord
+		{
+			uint64_t key;
+			uint32_t size;
+			uint32_t flags;
+			int64_t writeTime;
+		};
+		static_assert(sizeof(JournalRecord) == 24);
+
+		bool MapLocked();
+		void LoadJournalLocked();
+		bool CompactLocked();
+		bool HasStaleUsesLocked() const;
+		bool RetireLocked();
+		void RemoveRetired() const;
+		bool WriteJournalRecordLocked(const JournalRecord& a_record, std::span<const uint8_t> a_data);
+		std::span<const Entry> GetTable() const;
+
+		std::filesystem::path path;
+		std::filesystem::path journalPath;
+
+		mutable std::shared_mutex mutex;
+		std::shared_ptr<Mapping> mapping;
+		std::unordered_map<uint64_t, PendingBlob> pending;
+		std::unordered_set<uint64_t> erased;
+		std::vector<uint64_t> expired;
+		std::ofstream journal;
+		uint32_t session = 1;
+		uint32_t retiredCount = 0;  // files moved aside in this session
+	};
+}
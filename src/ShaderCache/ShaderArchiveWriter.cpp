@@ -0,0 +1,74 @@
+#include "ShaderCache/ShaderArchive.h"
+
+namespace SIE
+{
+	namespace
+	{
+		constexpr uint64_t BlobAlignment = 16;
+
+		constexpr uint64_t AlignUp(uint64_t a_value, uint64_t a_alignment)
+		{
+			return (a_value + a_alignment - 1) & ~(a_alignment - 1);
+		}
+
+		void WritePadding(std::ofstream& a_stream, uint64_t a_count)
+		{
+			static constexpr std::array<char, BlobAlignment> zeros{};
+			a_stream.write(zeros.data(), static_cast<std::streamsize>(a_count));
+		}
+	}
+
+	std::optional<size_t> ShaderArchive::Write(const std::filesystem::path& a_path, std::span<Source> a_sources, uint32_t a_session)
+	{
+		std::ranges::sort(a_sources, {}, &Source::key);
+
+		Header header{
+			.magic = Magic,
+			.version = Version,
+			.entryCount = static_cast<uint32_t>(a_sources.size()),
+			.session = a_session,
+			.tableOffset = sizeof(Header),
+			.dataOffset = AlignUp(sizeof(Header) + a_sources.size() * sizeof(Entry), BlobAlignment)
+		};
+
+		// permutations that compile to identical bytecode share one blob in the data region
+		std::vector<Entry> table;
+		table.reserve(a_sources.size());
+		std::vector<std::span<const uint8_t>> blobs;
+		std::unordered_multimap<uint64_t, size_t> blobsByHash;
+		std::vector<uint64_t> blobOffsets;
+		uint64_t offset = 0;
+		for (const auto& source : a_sources) {
+			const uint64_t hash = ankerl::unordered_dense::hash<std::string_view>{}({ reinterpret_cast<const char*>(source.data.data()), source.data.size() });
+			auto [first, last] = blobsByHash.equal_range(hash);
+			auto match = std::find_if(first, last, [&](const auto& candidate) { return std::ranges::equal(blobs[candidate.second], source.data); });
+			uint64_t blobOffset = offset;
+			if (match != last) {
+				blobOffset = blobOffsets[match->second];
+			} else {
+				blobsByHash.emplace(hash, blobs.size());
+				blobs.push_back(source.data);
+				blobOffsets.push_back(offset);
+				offset = AlignUp(offset + source.data.size(), BlobAlignment);
+			}
+			table.push_back({ source.key, blobOffset, static_cast<uint32_t>(source.data.size()), source.lastUsed, source.writeTime });
+		}
+
+		std::error_code ec;
+		std::filesystem::create_directories(a_path.parent_path(), ec);
+		std::ofstream out(a_path, std::ios::binary | std::ios::trunc);
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		out.write(reinterpret_cast<const char*>(table.data()), static_cast<std::streamsize>(table.size() * sizeof(Entry)));
+		WritePadding(out, header.dataOffset - (sizeof(Header) + table.size() * sizeof(Entry)));
+		for (const auto& blob : blobs) {
+			out.write(reinterpret_cast<const char*>(blob.data()), static_cast<std::streamsize>(blob.size()));
+			WritePadding(out, AlignUp(blob.size(), BlobAlignment) - blob.size());
+		}
+		if (!out) {
+			out.close();
+			std::filesystem::remove(a_path, ec);
+			return std::nullopt;
+		}
+		return blobs.size();
+	}
+}
@@ -0,0 +1,278 @@
+#pragma once
+
+namespace SIE
+{
+	/**
+	 * @brief Descriptor-to-shader map whose lookups never block on writers.
+	 *
+	 * Ownership lives in an ordinary map guarded by a writer mutex. Lookups go through a
+	 * separate open-addressing index whose slots are atomics: writers publish a value before
+	 * its key, so a reader that sees a key also sees its value. Erased entries keep their key
+	 * with a null value until the index is rebuilt on growth.
+	 *
+	 * Indices replaced by growth or Clear() are retired rather than freed, and only released at
+	 * the Clear() after next, giving in-flight readers a generous grace period. As before,
+	 * shaders returned by Find() stay valid until they are erased or cleared.
+	 *
+	 * Each slot also has a "seen" flag, so callers can act once on the first hit of an entry,
+	 * e.g. to record its use, without taking a lock on later hits.
+	 *
+	 * Writers can also store a small caller-defined mark for a descriptor, with or without a
+	 * shader, e.g. whether its compilation is queued. Marks are readable without the lock and
+	 * reset when a shader is stored or erased.
+	 *
+	 * The class is plain C++ and has no dependency on the game or D3D.
+	 */
+	template <class T>
+	class ShaderLookup
+	{
+	public:
+		ShaderLookup() :
+			index(AllocateIndex(InitialCapacity)) {}
+
+		~ShaderLookup() { delete index.load(); }
+
+		ShaderLookup(const ShaderLookup&) = delete;
+		ShaderLookup& operator=(const ShaderLookup&) = delete;
+
+		/**
+		 * @brief Lock-free lookup, safe to call concurrently with any writer.
+		 * @param a_firstHit If not null, set to true for the first hit on the entry and false otherwise.
+		 * Lookups that pass null do not count as hits.
+		 */
+		T* Find(uint32_t a_descriptor, bool* a_firstHit = nullptr) const
+		{
+			const Slot* slot = FindSlot(index.load(std::memory_order_acquire), a_descriptor);
+			T* shader = slot ? slot->value.load(std::memory_order_acquire) : nullptr;
+			if (a_firstHit)
+				*a_firstHit = shader && !slot->seen.load(std::memory_order_relaxed) && !slot->seen.exchange(true, std::memory_order_relaxed);
+			return shader;
+		}
+
+		/**
+		 * @brief Lock-free read of the mark set by SetMark(), 0 if none.
+		 */
+		uint8_t GetMark(uint32_t a_descriptor) const
+		{
+			const Slot* slot = FindSlot(index.load(std::memory_order_acquire), a_descriptor);
+			return slot ? slot->mark.load(std::memory_order_acquire) : 0;
+		}
+
+		/**
+		 * @brief Sets the mark of a descriptor, which need not have a shader. 0 removes it.
+		 */
+		void SetMark(uint32_t a_descriptor, uint8_t a_mark)
+		{
+			std::lock_guard lock(mutex);
+			if (a_mark)
+				marks[a_descriptor] = a_mark;
+			else
+				marks.erase(a_descriptor);
+			if (Slot* slot = SlotLocked(a_descriptor, a_mark != 0))
+				slot->mark.store(a_mark, std::memory_order_release);
+		}
+
+		/**
+		 * @brief Removes every mark, keeping the shaders.
+		 */
+		void ClearMarks()
+		{
+			std::lock_guard lock(mutex);
+			for (const auto& [descriptor, mark] : marks) {
+				if (Slot* slot = SlotLocked(descriptor, false))
+					slot->mark.store(0, std::memory_order_release);
+			}
+			marks.clear();
+		}
+
+		/**
+		 * @brief Adds a shader, calling a_release on the shader it replaces.
+		 * @return The added shader.
+		 */
+		template <class F>
+		T* InsertOrAssign(uint32_t a_descriptor, std::unique_ptr<T> a_shader, F&& a_release)
+		{
+			std::lock_guard lock(mutex);
+			T* shader = a_shader.get();
+			auto [it, inserted] = owned.try_emplace(a_descriptor, std::move(a_shader));  // only moves if inserted
+			std::unique_ptr<T> replaced;
+			if (!inserted)
+				replaced = std::exchange(it->second, std::move(a_shader));
+			marks.erase(a_descriptor);
+			// publish the new shader before the old one is released
+			Slot* slot = SlotLocked(a_descriptor, true);
+			// a replaced shader is a new entry and gets its own first hit
+			slot->seen.store(false, std::memory_order_relaxed);
+			slot->value.store(shader, std::memory_order_release);
+			slot->mark.store(0, std::memory_order_release);
+			if (replaced)
+				a_release(*replaced);
+			return shader;
+		}
+
+		/**
+		 * @brief Removes a shader, calling a_release on it first.
+		 * @return true if the descriptor was present.
+		 */
+		template <class F>
+		bool Erase(uint32_t a_descriptor, F&& a_release)
+		{
+			std::lock_guard lock(mutex);
+			auto it = owned.find(a_descriptor);
+			if (it == owned.end())
+				return false;
+			marks.erase(a_descriptor);
+			if (Slot* slot = SlotLocked(a_descriptor, false)) {
+				slot->value.store(nullptr, std::memory_order_release);
+				slot->mark.store(0, std::memory_order_release);
+			}
+			if (it->second)
+				a_release(*it->second);
+			owned.erase(it);
+			return true;
+		}
+
+		/**
+		 * @brief Removes every shader, calling a_release on each first.
+		 */
+		template <class F>
+		void Clear(F&& a_release)
+		{
+			std::lock_guard lock(mutex);
+			// everything retired before the previous Clear() has had a full cache generation to drain;
+			// the current index is retired after the shift, so it survives the next Clear() as well
+			expired = std::move(retired);
+			retired.clear();
+			RetireLocked(AllocateIndex(InitialCapacity));
+			for (auto& [descriptor, shader] : owned) {
+				if (shader)
+					a_release(*shader);
+			}
+			owned.clear();
+			marks.clear();
+		}
+
+		size_t Size() const
+		{
+			std::lock_guard lock(mutex);
+			return owned.size();
+		}
+
+	private:
+		static constexpr size_t InitialCapacity = 64;
+		static constexpr uint64_t EmptyKey = 0;
+
+		struct Slot
+		{
+			std::atomic<uint64_t> key{ EmptyKey };
+			std::atomic<T*> value{ nullptr };
+			std::atomic<uint8_t> mark{ 0 };           // caller-defined, see SetMark()
+			mutable std::atomic<bool> seen{ false };  // the entry had its first hit
+		};
+
+		struct Index
+		{
+			explicit Index(size_t a_capacity) :
+				slots(std::make_unique<Slot[]>(a_capacity)), mask(a_capacity - 1) {}
+
+			std::unique_ptr<Slot[]> slots;
+			size_t mask;
+			size_t used = 0;  // slots with a key, including erased and mark-only ones
+		};
+
+		static constexpr uint64_t ToKey(uint32_t a_descriptor) { return static_cast<uint64_t>(a_descriptor) + 1; }
+		static constexpr size_t Hash(uint32_t a_descriptor) { return static_cast<size_t>((a_descriptor * 0x9E3779B97F4A7C15ull) >> 32); }
+
+		static Index* AllocateIndex(size_t a_capacity) { return new Index(a_capacity); }
+
+		static const Slot* FindSlot(const Index* a_index, uint32_t a_descriptor)
+		{
+			const uint64_t key = ToKey(a_descriptor);
+			for (size_t i = Hash(a_descriptor) & a_index->mask;; i = (i + 1) & a_index->mask) {
+				const uint64_t slotKey = a_index->slots[i].key.load(std::memory_order_acquire);
+				if (slotKey == key)
+					return &a_index->slots[i];
+				if (slotKey == EmptyKey)
+					return nullptr;
+			}
+		}
+
+		void RetireLocked(Index* a_replacement)
+		{
+			retired.emplace_back(index.exchange(a_replacement, std::memory_order_acq_rel));
+		}
+
+		/**
+		 * @brief Finds the slot of a descriptor in the current index, optionally adding it.
+		 * New slots are filled from `owned` and `marks` before their key is published.
+		 */
+		Slot* SlotLocked(uint32_t a_descriptor, bool a_create)
+		{
+			Index* current = index.load(std::memory_order_relaxed);
+			const uint64_t key = ToKey(a_descriptor);
+			size_t i = Hash(a_descriptor) & current->mask;
+			for (;; i = (i + 1) & current->mask) {
+				const uint64_t slotKey = current->slots[i].key.load(std::memory_order_relaxed);
+				if (slotKey == key)
+					return &current->slots[i];
+				if (slotKey == EmptyKey)
+					break;
+			}
+			if (!a_create)
+				return nullptr;
+
+			// keep the load factor under 3/4 so probes stay short and always terminate
+			if ((current->used + 1) * 4 > (current->mask + 1) * 3) {
+				GrowLocked();
+				return SlotLocked(a_descriptor, false);  // the rebuilt index contains every owned shader and mark
+			}
+			FillLocked(current->slots[i], a_descriptor);
+			current->slots[i].key.store(key, std::memory_order_release);
+			current->used++;
+			return &current->slots[i];
+		}
+
+		void FillLocked(Slot& a_slot, uint32_t a_descriptor) const
+		{
+			if (auto it = owned.find(a_descriptor); it != owned.end())
+				a_slot.value.store(it->second.get(), std::memory_order_relaxed);
+			if (auto it = marks.find(a_descriptor); it != marks.end())
+				a_slot.mark.store(it->second, std::memory_order_relaxed);
+		}
+
+		void GrowLocked()
+		{
+			size_t capacity = InitialCapacity;
+			while ((owned.size() + marks.size()) * 2 > capacity)
+				capacity *= 2;
+
+			const Index* current = index.load(std::memory_order_relaxed);
+			auto* replacement = AllocateIndex(capacity);
+			const auto add = [&](uint32_t a_descriptor) {
+				size_t i = Hash(a_descriptor) & replacement->mask;
+				while (replacement->slots[i].key.load(std::memory_order_relaxed) != EmptyKey)
+					i = (i + 1) & replacement->mask;
+				// carry the flag over, a hit racing with the rebuild may at worst count as first twice
+				if (auto* previous = FindSlot(current, a_descriptor))
+					replacement->slots[i].seen.store(previous->seen.load(std::memory_order_relaxed), std::memory_order_relaxed);
+				FillLocked(replacement->slots[i], a_descriptor);
+				replacement->slots[i].key.store(ToKey(a_descriptor), std::memory_order_relaxed);
+				replacement->used++;
+			};
+			for (const auto& [descriptor, shader] : owned)
+				add(descriptor);
+			for (const auto& [descriptor, mark] : marks) {
+				if (!owned.contains(descriptor))
+					add(descriptor);
+			}
+			RetireLocked(replacement);  // the exchange publishes the filled index with release semantics
+		}
+
+		mutable std::mutex mutex;  // serializes writers; readers never take it
+		std::atomic<Index*> index;
+		std::unordered_map<uint32_t, std::unique_ptr<T>> owned;
+		std::unordered_map<uint32_t, uint8_t> marks;  // kept so growth can rebuild slots without a shader
+		std::vector<std::unique_ptr<Index>> retired;
+		std::vector<std::unique_ptr<Index>> expired;
+	};
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+namespace SIE
+{
+	/**
+	 * @brief Shares one device shader object between permutations with identical bytecode.
+	 *
+	 * Objects are keyed by the size of their final (stripped) bytecode and the 128-bit checksum
+	 * the compiler stores in the DXBC container header, which D3DStripShader recomputes, so the
+	 * pool keeps no copy of the bytecode. Bytecode without a DXBC header is never shared.
+	 * Acquire() hands out the existing object for known bytecode and only calls the factory for
+	 * new bytecode. The pool counts users itself instead of adding COM references, so the
+	 * object's own reference is released once its last user calls Release().
+	 *
+	 * `Object` only needs a `Release()` method. The class is plain C++ with no dependency on the
+	 * game or D3D and is thread safe.
+	 */
+	template <class Object>
+	class ShaderObjectPool
+	{
+	public:
+		struct Digest
+		{
+			std::array<uint64_t, 2> checksum;
+			uint64_t size;
+
+			bool operator==(const Digest&) const = default;
+		};
+
+		/**
+		 * @return The checksum and size of DXBC bytecode, or nullopt for anything else.
+		 */
+		static std::optional<Digest> GetDigest(std::span<const uint8_t> a_bytecode)
+		{
+			// "DXBC", then the checksum of everything after it
+			if (a_bytecode.size() < 20 || std::memcmp(a_bytecode.data(), "DXBC", 4))
+				return std::nullopt;
+			Digest digest{ {}, a_bytecode.size() };
+			std::memcpy(digest.checksum.data(), a_bytecode.data() + 4, sizeof(digest.checksum));
+			return digest;
+		}
+
+		/**
+		 * @brief Returns the object for a_bytecode, creating it with a_create if none is alive.
+		 * @param a_create Callable returning a new `Object*`, or nullptr on failure.
+		 * @return The shared object, or nullptr if creation failed.
+		 */
+		template <class F>
+		Object* Acquire(std::span<const uint8_t> a_bytecode, F&& a_create)
+		{
+			const auto digest = GetDigest(a_bytecode);
+			std::lock_guard lock(mutex);
+			requests++;
+			if (digest) {
+				if (auto it = byDigest.find(*digest); it != byDigest.end()) {
+					it->second.users++;
+					return it->second.object;
+				}
+			}
+			Object* object = a_create();
+			if (!object)
+				return nullptr;
+			if (digest) {
+				byDigest.emplace(*digest, Entry{ object, 1 });
+				byObject.emplace(object, *digest);
+			}
+			created++;
+			return object;
+		}
+
+		/**
+		 * @brief Drops one user of a_object, releasing it when no users remain.
+		 *
+		 * Objects not handed out by this pool are released directly.
+		 */
+		void Release(Object* a_object)
+		{
+			if (!a_object)
+				return;
+			std::lock_guard lock(mutex);
+			auto it = byObject.find(a_object);
+			if (it == byObject.end()) {
+				a_object->Release();
+				return;
+			}
+			auto entry = byDigest.find(it->second);
+			if (--entry->second.users == 0) {
+				a_object->Release();
+				byDigest.erase(entry);
+				byObject.erase(it);
+			}
+		}
+
+		/**
+		 * @brief Number of Acquire() calls and how many of them created a new object.
+		 */
+		std::pair<uint64_t, uint64_t> GetCounts() const
+		{
+			std::lock_guard lock(mutex);
+			return { requests, created };
+		}
+
+		size_t Size() const
+		{
+			std::lock_guard lock(mutex);
+			return byObject.size();
+		}
+
+	private:
+		struct Entry
+		{
+			Object* object;
+			size_t users;
+		};
+
+		struct DigestHash
+		{
+			size_t operator()(const Digest& a_digest) const noexcept { return static_cast<size_t>(a_digest.checksum[0] ^ (a_digest.size * 0x9E3779B97F4A7C15ull)); }
+		};
+
+		mutable std::mutex mutex;
+		std::unordered_map<Digest, Entry, DigestHash> byDigest;
+		std::unordered_map<Object*, Digest> byObject;  // shared objects only
+		uint64_t requests = 0;
+		uint64_t created = 0;
+	};
+}
@@ -0,0 +1,123 @@
+#include "ShaderCache/WarmList.h"
+
+namespace SIE
+{
+	bool WarmList::Load()
+	{
+		std::unique_lock lock(mutex);
+		keys.clear();
+		session = 1;
+		dirty = false;
+
+		std::ifstream in(path, std::ios::binary);
+		if (!in.is_open())
+			return false;
+
+		std::error_code ec;
+		const auto fileSize = std::filesystem::file_size(path, ec);
+		Header header{};
+		if (ec || !in.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != Magic || header.version != Version ||
+			header.count > (fileSize - sizeof(Header)) / sizeof(Entry)) {
+			logger::warn("Ignoring invalid shader warm list {}", path.string());
+			return false;
+		}
+
+		std::vector<Entry> stored(header.count);
+		if (!in.read(reinterpret_cast<char*>(stored.data()), static_cast<std::streamsize>(stored.size() * sizeof(Entry)))) {
+			logger::warn("Shader warm list {} is truncated", path.string());
+			return false;
+		}
+
+		session = header.session + 1;
+		for (const auto& entry : stored) {
+			if (session - entry.lastSeen <= MaxAge)
+				keys.insert_or_assign(entry.key, entry.lastSeen);
+		}
+		dirty = keys.size() != stored.size();
+		logger::info("Loaded {} permutations from shader warm list, {} expired", keys.size(), stored.size() - keys.size());
+		return true;
+	}
+
+	bool WarmList::Save()
+	{
+		std::vector<Entry> entries;
+		uint32_t savedSession;
+		{
+			std::unique_lock lock(mutex);
+			if (!dirty)
+				return true;
+			entries.reserve(keys.size());
+			for (const auto& [key, lastSeen] : keys)
+				entries.push_back({ key, lastSeen, 0 });
+			if (entries.size() > MaxCount) {
+				std::ranges::nth_element(entries, entries.begin() + MaxCount, std::ranges::greater{}, &Entry::lastSeen);
+				for (auto it = entries.begin() + MaxCount; it != entries.end(); ++it)
+					keys.erase(it->key);
+				entries.resize(MaxCount);
+			}
+			savedSession = session;
+			dirty = false;
+		}
+		std::ranges::sort(entries, {}, &Entry::key);
+
+		const Header header{ Magic, Version, entries.size(), savedSession, 0 };
+		std::error_code ec;
+		std::filesystem::create_directories(path.parent_path(), ec);
+		std::ofstream out(path, std::ios::binary | std::ios::trunc);
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		out.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(Entry)));
+		if (!out) {
+			logger::error("Failed to write shader warm list {}", path.string());
+			std::unique_lock lock(mutex);
+			dirty = true;
+			return false;
+		}
+
+		logger::debug("Saved {} permutations to shader warm list", entries.size());
+		return true;
+	}
+
+	bool WarmList::Record(uint64_t a_key)
+	{
+		{
+			std::shared_lock lock(mutex);
+			if (auto it = keys.find(a_key); it != keys.end() && it->second == session)
+				return false;
+		}
+		std::unique_lock lock(mutex);
+		auto [it, inserted] = keys.try_emplace(a_key, session);
+		if (!inserted) {
+			if (it->second == session)
+				return false;
+			it->second = session;
+		}
+		dirty = true;
+		return inserted;
+	}
+
+	std::vector<WarmList::Permutation> WarmList::GetPermutations(uint32_t a_type) const
+	{
+		std::vector<Permutation> result;
+		{
+			std::shared_lock lock(mutex);
+			for (const auto& [key, lastSeen] : keys) {
+				if (Unpack(key).type == a_type)
+					result.push_back(Unpack(key));
+			}
+		}
+		std::ranges::sort(result, {}, [](const Permutation& a_permutation) { return Pack(a_permutation.type, a_permutation.shaderClass, a_permutation.descriptor); });
+		return result;
+	}
+
+	size_t WarmList::GetCount() const
+	{
+		std::shared_lock lock(mutex);
+		return keys.size();
+	}
+
+	uint32_t WarmList::GetSession() const
+	{
+		std::shared_lock lock(mutex);
+		return session;
+	}
+}
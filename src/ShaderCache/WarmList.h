@@ -0,0 +1,97 @@
+#pragma once
+
+namespace SIE
+{
+	/**
+	 * @brief Set of shader permutations drawn during play, persisted between sessions.
+	 *
+	 * Each permutation is a packed 64-bit (shader type, shader class, descriptor) key
+	 * stamped with the session it was last recorded in. The file is
+	 * `Header | entry array sorted by key` and is rewritten whole by Save().
+	 *
+	 * Sessions in which the list did not change are not counted. Entries not recorded for
+	 * MaxAge sessions are dropped on Load(), and Save() keeps at most MaxCount of the most
+	 * recently recorded entries, so areas the player no longer visits age out.
+	 *
+	 * The class is plain C++ and has no dependency on the game or D3D.
+	 */
+	class WarmList
+	{
+	public:
+		static constexpr uint32_t Magic = 0x4C575343;  // "CSWL"
+		static constexpr uint32_t Version = 2;
+		static constexpr uint32_t MaxAge = 16;          // sessions
+		static constexpr size_t MaxCount = 1 << 16;
+
+		struct Header
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint64_t count;
+			uint32_t session;  // the session that wrote the file
+			uint32_t reserved;
+		};
+		static_assert(sizeof(Header) == 24);
+
+		struct Entry
+		{
+			uint64_t key;
+			uint32_t lastSeen;  // session the key was last recorded in
+			uint32_t reserved;
+		};
+		static_assert(sizeof(Entry) == 16);
+
+		struct Permutation
+		{
+			uint32_t type;
+			uint32_t shaderClass;
+			uint32_t descriptor;
+		};
+
+		static constexpr uint64_t Pack(uint32_t a_type, uint32_t a_shaderClass, uint32_t a_descriptor)
+		{
+			return (static_cast<uint64_t>(a_type & 0xFFFF) << 48) | (static_cast<uint64_t>(a_shaderClass & 0xFFFF) << 32) | a_descriptor;
+		}
+
+		static constexpr Permutation Unpack(uint64_t a_key)
+		{
+			return { static_cast<uint32_t>(a_key >> 48), static_cast<uint32_t>((a_key >> 32) & 0xFFFF), static_cast<uint32_t>(a_key) };
+		}
+
+		explicit WarmList(std::filesystem::path a_path) :
+			path(std::move(a_path)) {}
+
+		/**
+		 * @brief Replaces the in-memory list with the file contents and starts a new session.
+		 * @return true if a valid list was read.
+		 */
+		bool Load();
+
+		/**
+		 * @brief Writes the list if permutations were recorded since the last Load() or Save().
+		 * @return true if the file is up to date.
+		 */
+		bool Save();
+
+		/**
+		 * @brief Records a drawn permutation in the current session.
+		 * @return true if the permutation was not in the list yet.
+		 */
+		bool Record(uint64_t a_key);
+
+		/**
+		 * @brief Returns the listed permutations of one shader type, in key order.
+		 */
+		std::vector<Permutation> GetPermutations(uint32_t a_type) const;
+
+		size_t GetCount() const;
+		uint32_t GetSession() const;
+
+	private:
+		std::filesystem::path path;
+		mutable std::shared_mutex mutex;
+		std::unordered_map<uint64_t, uint32_t> keys;  // key to last seen session
+		uint32_t session = 1;
+		bool dirty = false;
+	};
+}
@@ -47,29 +47,29 @@ void State::Draw()
 		if (deferred->inDecals)
 			currentExtraDescriptor |= (uint32_t)ExtraShaderDescriptors::IsDecal;
 
-		if (forceUpdatePermutationBuffer || currentPixelDescriptor != lastPixelDescriptor || currentExtraDescriptor != lastExtraDescriptor) {
+		if (permutationState.Update(currentVertexDescriptor, currentPixelDescriptor, currentExtraDescriptor)) {
 			PermutationCB data{};
 			data.VertexShaderDescriptor = currentVertexDescriptor;
 			data.PixelShaderDescriptor = currentPixelDescriptor;
 			data.ExtraShaderDescriptor = currentExtraDescriptor;
 
 			permutationCB->Update(data);
-
-			lastVertexDescriptor = currentVertexDescriptor;
-			lastPixelDescriptor = currentPixelDescriptor;
-			lastExtraDescriptor = currentExtraDescriptor;
-
-			forceUpdatePermutationBuffer = false;
+			permutationCB->PSSet(4);
 		}
 
 		currentExtraDescriptor = 0;
 
 		if (frameChecker.IsNewFrame()) {
-			ID3D11Buffer* buffers[3] = { permutationCB->CB(), sharedDataCB->CB(), featureDataCB->CB() };
-			context->PSSetConstantBuffers(4, 3, buffers);
-			context->CSSetConstantBuffers(5, 2, buffers + 1);
+			// slot 4 may hold a ring range, which PSSet() binds with its offset
+			permutationCB->PSSet(4);
+			ID3D11Buffer* buffers[2] = { sharedDataCB->CB(), featureDataCB->CB() };
+			context->PSSetConstantBuffers(5, 2, buffers);
+			context->CSSetConstantBuffers(5, 2, buffers);
 		}
 
+		// any upload since the last draw may have wrapped the ring and discarded the bound ranges
+		constantRing->RestoreStale();
+
 		if (currentShader && updateShader) {
 			auto type = currentShader->shaderType.get();
 			if (type == RE::BSShader::Type::Utility) {
@@ -102,26 +102,33 @@ void State::Reset()
 			feature->Reset();
 	if (!globals::game::ui->GameIsPaused())
 		timer += RE::GetSecondsSinceLastFrame();
+	drawProfiler.EndFrame();
 	lastModifiedPixelDescriptor = 0;
 	lastModifiedVertexDescriptor = 0;
-	lastPixelDescriptor = 0;
-	lastVertexDescriptor = 0;
+	permutationState = {};
 	initialized = false;
-	forceUpdatePermutationBuffer = true;
 	frameCount++;
 }
 
 void State::Setup()
 {
-	globals::truePBR->SetupResources();
-	SetupResources();
-	for (auto* feature : Feature::GetFeatureList())
-		if (feature->loaded)
-			feature->SetupResources();
-	globals::deferred->SetupResources();
-	globals::streamline->SetupResources();
+	using Affinity = Util::TaskGraph::Affinity;
+	Util::TaskGraph setup;
+	setup.Add("TruePBR", []() { globals::truePBR->SetupResources(); });
+	setup.Add("State", [this]() { SetupResources(); }, Affinity::Owner, { "TruePBR" });
+	std::vector<std::string> setupBeforeDeferred{ "State" };
+	for (auto* feature : Feature::GetFeatureList()) {
+		if (feature->loaded) {
+			setup.Add(feature->GetShortName(), [feature]() { feature->SetupResources(); },
+				feature->SupportsParallelSetup() ? Affinity::Worker : Affinity::Owner, { "State" });
+			setupBeforeDeferred.push_back(feature->GetShortName());
+		}
+	}
+	setup.Add("Deferred", []() { globals::deferred->SetupResources(); }, Affinity::Owner, std::move(setupBeforeDeferred));
+	setup.Add("Streamline", []() { globals::streamline->SetupResources(); }, Affinity::Owner, { "Deferred" });
 	if (!upscalerLoaded)
-		globals::upscaling->CreateUpscalingResources();
+		setup.Add("Upscaling", []() { globals::upscaling->CreateUpscalingResources(); }, Affinity::Owner, { "Streamline" });
+	setup.Run("SetupResources");
 	if (initialized)
 		return;
 	initialized = true;
@@ -215,6 +222,10 @@ void State::Load(ConfigMode a_configMode, bool a_allowReload)
 				shaderCache->compilationThreadCount = std::clamp(advanced["Compiler Threads"].get<int32_t>(), 1, static_cast<int32_t>(std::thread::hardware_concurrency()));
 			if (advanced["Background Compiler Threads"].is_number_integer())
 				shaderCache->backgroundCompilationThreadCount = std::clamp(advanced["Background Compiler Threads"].get<int32_t>(), 1, static_cast<int32_t>(std::thread::hardware_concurrency()));
+			if (advanced["Adaptive Background Compilation"].is_boolean())
+				shaderCache->adaptiveBackgroundCompilation = advanced["Adaptive Background Compilation"];
+			if (advanced["Background Frame Budget"].is_number())
+				shaderCache->backgroundFrameBudgetMs = std::clamp(advanced["Background Frame Budget"].get<float>(), 4.0f, 100.0f);
 			if (advanced["Use FileWatcher"].is_boolean())
 				shaderCache->SetFileWatcher(advanced["Use FileWatcher"]);
 			if (advanced["Frame Annotations"].is_boolean())
@@ -362,6 +373,8 @@ void State::Save(ConfigMode a_configMode)
 	advanced["Shader Defines"] = shaderDefinesString;
 	advanced["Compiler Threads"] = shaderCache->compilationThreadCount;
 	advanced["Background Compiler Threads"] = shaderCache->backgroundCompilationThreadCount;
+	advanced["Adaptive Background Compilation"] = shaderCache->adaptiveBackgroundCompilation;
+	advanced["Background Frame Budget"] = shaderCache->backgroundFrameBudgetMs;
 	advanced["Use FileWatcher"] = shaderCache->UseFileWatcher();
 	advanced["Frame Annotations"] = frameAnnotations;
 	settings["Advanced"] = advanced;
@@ -445,6 +458,7 @@ spdlog::level::level_enum State::GetLogLevel()
 
 void State::SetDefines(std::string a_defines)
 {
+	auto previousDefinesString = shaderDefinesString;
 	shaderDefines.clear();
 	shaderDefinesString = "";
 	std::string name = "";
@@ -468,6 +482,9 @@ void State::SetDefines(std::string a_defines)
 	}
 	shaderDefinesString = shaderDefinesString.substr(0, shaderDefinesString.size() - 1);
 	logger::debug("Shader Defines set to {}", shaderDefinesString);
+	// completed shaders are keyed without their defines, so older compiles must not be found anymore
+	if (shaderDefinesString != previousDefinesString && globals::shaderCache)
+		globals::shaderCache->BumpFeatureEpoch();
 }
 
 std::vector<std::pair<std::string, std::string>>* State::GetDefines()
@@ -504,12 +521,11 @@ void State::SetupResources()
 {
 	auto renderer = globals::game::renderer;
 
-	permutationCB = new ConstantBuffer(ConstantBufferDesc<PermutationCB>());
+	constantRing = new ConstantUploadRing(ConstantRingSize);
+	permutationCB = new ConstantBuffer(ConstantBufferDesc<PermutationCB>(), constantRing);
 	sharedDataCB = new ConstantBuffer(ConstantBufferDesc<SharedDataCB>());
 
-	auto [data, size] = GetFeatureBufferData(false);
-	featureDataCB = new ConstantBuffer(ConstantBufferDesc((uint32_t)size));
-	delete[] data;
+	featureDataCB = new ConstantBuffer(ConstantBufferDesc((uint32_t)FeatureBuffer::GetSize()));
 
 	// Grab main texture to get resolution
 	// VR cannot use viewport->screenWidth/Height as it's the desktop preview window's resolution and not HMD
@@ -524,113 +540,40 @@ void State::SetupResources()
 	tracyCtx = TracyD3D11Context(globals::d3d::device, globals::d3d::context);
 }
 
-void State::ModifyShaderLookup(const RE::BSShader& a_shader, uint& a_vertexDescriptor, uint& a_pixelDescriptor, bool a_forceDeferred)
+Util::DrawPathProfiler::Result State::ReplayDrawStream(uint32_t a_repeats)
 {
-	auto deferred = globals::deferred;
+	auto shaderCache = globals::shaderCache;
+	// replayed lookups are not real draws, so misses must not end up in the warm list
+	SIE::ShaderCache::ScopedWarmListPause pause;
+	return drawProfiler.Replay(a_repeats, [&](const Util::DrawPathProfiler::Technique& a_technique) {
+		auto& shader = *a_technique.shader;
+		uint vertexDescriptor = a_technique.vertexDescriptor;
+		uint pixelDescriptor = a_technique.pixelDescriptor;
+		ModifyShaderLookup(shader, vertexDescriptor, pixelDescriptor, a_technique.deferred);
+		shaderCache->ResolveFallback(shader, vertexDescriptor, pixelDescriptor, false);
+		if (shader.shaderType.get() != RE::BSShader::Type::Effect) {
+			shaderCache->GetVertexShader(shader, vertexDescriptor);
+			shaderCache->GetPixelShader(shader, pixelDescriptor);
+		}
+	});
+}
 
-	if (a_shader.shaderType.get() != RE::BSShader::Type::Utility && a_shader.shaderType.get() != RE::BSShader::Type::ImageSpace) {
-		switch (a_shader.shaderType.get()) {
-		case RE::BSShader::Type::Lighting:
-			{
-				a_vertexDescriptor &= ~((uint32_t)SIE::ShaderCache::LightingShaderFlags::AdditionalAlphaMask |
-										(uint32_t)SIE::ShaderCache::LightingShaderFlags::AmbientSpecular |
-										(uint32_t)SIE::ShaderCache::LightingShaderFlags::DoAlphaTest |
-										(uint32_t)SIE::ShaderCache::LightingShaderFlags::ShadowDir |
-										(uint32_t)SIE::ShaderCache::LightingShaderFlags::DefShadow |
-										(uint32_t)SIE::ShaderCache::LightingShaderFlags::CharacterLight |
-										(uint32_t)SIE::ShaderCache::LightingShaderFlags::RimLighting |
-										(uint32_t)SIE::ShaderCache::LightingShaderFlags::SoftLighting |
-										(uint32_t)SIE::ShaderCache::LightingShaderFlags::BackLighting |
-										(uint32_t)SIE::ShaderCache::LightingShaderFlags::Specular |
-										(uint32_t)SIE::ShaderCache::LightingShaderFlags::AnisoLighting |
-										(uint32_t)SIE::ShaderCache::LightingShaderFlags::BaseObjectIsSnow |
-										(uint32_t)SIE::ShaderCache::LightingShaderFlags::Snow |
-										(uint32_t)SIE::ShaderCache::LightingShaderFlags::TruePbr);
-
-				a_pixelDescriptor &= ~((uint32_t)SIE::ShaderCache::LightingShaderFlags::AmbientSpecular |
-									   (uint32_t)SIE::ShaderCache::LightingShaderFlags::ShadowDir |
-									   (uint32_t)SIE::ShaderCache::LightingShaderFlags::DefShadow |
-									   (uint32_t)SIE::ShaderCache::LightingShaderFlags::CharacterLight |
-									   (uint32_t)SIE::ShaderCache::LightingShaderFlags::BaseObjectIsSnow);
-				if (a_pixelDescriptor & (uint32_t)SIE::ShaderCache::LightingShaderFlags::AdditionalAlphaMask) {
-					a_pixelDescriptor |= (uint32_t)SIE::ShaderCache::LightingShaderFlags::DoAlphaTest;
-					a_pixelDescriptor &= ~(uint32_t)SIE::ShaderCache::LightingShaderFlags::AdditionalAlphaMask;
-				}
+void State::ModifyShaderLookup(const RE::BSShader& a_shader, uint& a_vertexDescriptor, uint& a_pixelDescriptor, bool a_forceDeferred)
+{
+	// the setting only changes from the console, so it is read once per frame
+	if (improvedSnowFrame != frameCount) {
+		static auto enableImprovedSnow = RE::GetINISetting("bEnableImprovedSnow:Display");
+		improvedSnow = !REL::Module::IsVR() && enableImprovedSnow->GetBool();
+		improvedSnowFrame = frameCount;
+	}
 
-				static auto enableImprovedSnow = RE::GetINISetting("bEnableImprovedSnow:Display");
-				static bool vr = REL::Module::IsVR();
-
-				if (vr || !enableImprovedSnow->GetBool())
-					a_pixelDescriptor &= ~((uint32_t)SIE::ShaderCache::LightingShaderFlags::Snow);
-
-				if (deferred->deferredPass || a_forceDeferred)
-					a_pixelDescriptor |= (uint32_t)SIE::ShaderCache::LightingShaderFlags::Deferred;
-
-				{
-					uint32_t technique = 0x3F & (a_vertexDescriptor >> 24);
-					if (technique == (uint32_t)SIE::ShaderCache::LightingShaderTechniques::Glowmap ||
-						technique == (uint32_t)SIE::ShaderCache::LightingShaderTechniques::Parallax ||
-						technique == (uint32_t)SIE::ShaderCache::LightingShaderTechniques::Facegen ||
-						technique == (uint32_t)SIE::ShaderCache::LightingShaderTechniques::FacegenRGBTint ||
-						technique == (uint32_t)SIE::ShaderCache::LightingShaderTechniques::LODObjects ||
-						technique == (uint32_t)SIE::ShaderCache::LightingShaderTechniques::LODObjectHD ||
-						technique == (uint32_t)SIE::ShaderCache::LightingShaderTechniques::MultiIndexSparkle ||
-						technique == (uint32_t)SIE::ShaderCache::LightingShaderTechniques::Hair)
-						a_vertexDescriptor &= ~(0x3F << 24);
-				}
+	const SIE::DescriptorRemap::Context context{ globals::deferred->deferredPass || a_forceDeferred, improvedSnow };
+	std::tie(a_vertexDescriptor, a_pixelDescriptor) = SIE::DrawPath::Remap(static_cast<SIE::ShaderType>(a_shader.shaderType.get()), a_vertexDescriptor, a_pixelDescriptor, context);
+}
 
-				{
-					uint32_t technique = 0x3F & (a_pixelDescriptor >> 24);
-					if (technique == (uint32_t)SIE::ShaderCache::LightingShaderTechniques::Glowmap)
-						a_pixelDescriptor &= ~(0x3F << 24);
-				}
-			}
-			break;
-		case RE::BSShader::Type::Water:
-			{
-				auto flags = ~((uint32_t)SIE::ShaderCache::WaterShaderFlags::Reflections |
-							   (uint32_t)SIE::ShaderCache::WaterShaderFlags::Cubemap |
-							   (uint32_t)SIE::ShaderCache::WaterShaderFlags::Interior);
-				a_vertexDescriptor &= flags;
-				a_pixelDescriptor &= flags;
-			}
-			break;
-		case RE::BSShader::Type::Effect:
-			{
-				auto flags = ~((uint32_t)SIE::ShaderCache::EffectShaderFlags::GrayscaleToColor |
-							   (uint32_t)SIE::ShaderCache::EffectShaderFlags::GrayscaleToAlpha |
-							   (uint32_t)SIE::ShaderCache::EffectShaderFlags::IgnoreTexAlpha);
-				a_vertexDescriptor &= flags;
-				a_pixelDescriptor &= flags;
-
-				if (deferred->deferredPass || a_forceDeferred)
-					a_pixelDescriptor |= (uint32_t)SIE::ShaderCache::EffectShaderFlags::Deferred;
-			}
-			break;
-		case RE::BSShader::Type::DistantTree:
-			{
-				if (deferred->deferredPass || a_forceDeferred)
-					a_pixelDescriptor |= (uint32_t)SIE::ShaderCache::DistantTreeShaderFlags::Deferred;
-			}
-			break;
-		case RE::BSShader::Type::Sky:
-			{
-				if (deferred->deferredPass || a_forceDeferred)
-					a_pixelDescriptor |= 256;
-			}
-			break;
-		case RE::BSShader::Type::Grass:
-			{
-				auto technique = a_vertexDescriptor & 0xF;
-				auto flags = a_vertexDescriptor & ~0xF;
-				if (technique == static_cast<uint32_t>(SIE::ShaderCache::GrassShaderTechniques::TruePbr)) {
-					technique = 0;
-				}
-				a_vertexDescriptor = flags | technique;
-			}
-			break;
-		}
-	}
+bool State::SaveDrawStream(const std::filesystem::path& a_path) const
+{
+	return drawProfiler.Export(SIE::DrawPath::Remaps, improvedSnow).Save(a_path);
 }
 
 void State::BeginPerfEvent(std::string_view title)
@@ -710,13 +653,9 @@ void State::UpdateSharedData(bool a_inWorld)
 		sharedDataCB->Update(data);
 	}
 
-	{
-		auto [data, size] = GetFeatureBufferData(a_inWorld);
-
-		featureDataCB->Update(data, size);
-
-		delete[] data;
-	}
+	// the buffer keeps its contents between frames, so it is only rewritten when a feature changed
+	if (auto data = FeatureBuffer::Pack(a_inWorld))
+		featureDataCB->Update(data, FeatureBuffer::GetSize());
 
 	const auto& depth = globals::game::renderer->GetDepthStencilData().depthStencils[RE::RENDER_TARGETS_DEPTHSTENCIL::kPOST_ZPREPASS_COPY];
 	auto terrainBlending = globals::features::terrainBlending;
@@ -9,6 +9,8 @@ using json = nlohmann::json;
 
 #include <FeatureBuffer.h>
 
+#include "ShaderCache/DrawPath.h"
+
 class State
 {
 public:
@@ -106,16 +108,32 @@ public:
 	void SetAdapterDescription(const std::wstring& description);
 
 	bool frameAnnotations = false;
+	Util::DrawPathProfiler drawProfiler;
+
+	/**
+	 * @brief Replays the recorded technique stream through the shader lookups of the draw hooks.
+	 *
+	 * Runs ModifyShaderLookup, ResolveFallback and the shader cache lookups for every recorded
+	 * technique with the deferred state it was recorded in. No D3D calls are issued, so State::Draw
+	 * is not part of the replay; its live cost is included in the profiler's frame results instead.
+	 * Lookups made by the replay are not recorded in the shader warm list.
+	 * @param a_repeats How often the whole stream is replayed.
+	 */
+	Util::DrawPathProfiler::Result ReplayDrawStream(uint32_t a_repeats);
+
+	/**
+	 * @brief Saves the recorded technique stream with the current descriptor remaps for the headless DrawPathBenchmark.
+	 */
+	bool SaveDrawStream(const std::filesystem::path& a_path) const;
 
-	uint lastVertexDescriptor = 0;
-	uint lastPixelDescriptor = 0;
 	uint modifiedVertexDescriptor = 0;
 	uint modifiedPixelDescriptor = 0;
 	uint lastModifiedVertexDescriptor = 0;
 	uint lastModifiedPixelDescriptor = 0;
+	bool improvedSnow = false;  // bEnableImprovedSnow, refreshed once per frame
+	uint improvedSnowFrame = UINT32_MAX;
 	uint currentExtraDescriptor = 0;
-	uint lastExtraDescriptor = 0;
-	bool forceUpdatePermutationBuffer = true;
+	SIE::DrawPath::PermutationState permutationState;  // descriptors last uploaded to permutationCB
 
 	enum class ExtraShaderDescriptors : uint32_t
 	{
@@ -136,6 +154,8 @@ public:
 		uint pad0[1];
 	};
 
+	static constexpr UINT ConstantRingSize = 4 << 20;
+	ConstantUploadRing* constantRing = nullptr;  // shared by constant buffers updated per draw
 	ConstantBuffer* permutationCB = nullptr;
 
 	struct alignas(16) SharedDataCB
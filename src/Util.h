@@ -1,9 +1,15 @@
 #pragma once
 
+#include "Utils/AsyncFileWriter.h"
+#include "Utils/ComputeState.h"
 #include "Utils/D3D.h"
+#include "Utils/DrawPathProfiler.h"
+#include "Utils/DrawStream.h"
 #include "Utils/Format.h"
 #include "Utils/Game.h"
 #include "Utils/GameSetting.h"
+#include "Utils/RingAllocator.h"
 #include "Utils/Serialize.h"
+#include "Utils/TaskGraph.h"
 #include "Utils/UI.h"
 #include "Utils/WinApi.h"
@@ -0,0 +1,69 @@
+#include "AsyncFileWriter.h"
+
+namespace Util
+{
+	void AsyncFileWriter::Write(std::filesystem::path a_path, std::vector<uint8_t> a_data)
+	{
+		std::unique_lock lock(mutex);
+		// a single file larger than the capacity is still accepted once the queue is empty
+		condition.wait(lock, [&]() { return !queuedBytes || queuedBytes + a_data.size() <= capacity; });
+		queuedBytes += a_data.size();
+		jobs.push_back({ std::move(a_path), std::move(a_data) });
+		if (!running) {
+			running = true;
+			std::thread(&AsyncFileWriter::Run, this).detach();
+		}
+	}
+
+	void AsyncFileWriter::Flush()
+	{
+		std::unique_lock lock(mutex);
+		condition.wait(lock, [&]() { return !running; });
+	}
+
+	AsyncFileWriter::Stats AsyncFileWriter::GetStats() const
+	{
+		std::lock_guard lock(mutex);
+		return stats;
+	}
+
+	void AsyncFileWriter::Run()
+	{
+		SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+		std::unique_lock lock(mutex);
+		while (!jobs.empty()) {
+			auto batch = std::exchange(jobs, {});
+			stats.batches++;
+			lock.unlock();
+
+			uint64_t bytes = 0;
+			uint64_t failures = 0;
+			for (auto& job : batch) {
+				bytes += job.data.size();
+				const auto directory = job.path.parent_path();
+				if (!directory.empty() && createdDirectories.insert(directory.string()).second) {
+					std::error_code ec;
+					std::filesystem::create_directories(directory, ec);
+					if (ec)
+						logger::error("Failed to create folder {}: {}", directory.string(), ec.message());
+				}
+
+				std::ofstream file(job.path, std::ios::binary | std::ios::trunc);
+				file.write(reinterpret_cast<const char*>(job.data.data()), static_cast<std::streamsize>(job.data.size()));
+				if (!file) {
+					logger::error("Failed to write {}", job.path.string());
+					failures++;
+				}
+			}
+
+			lock.lock();
+			queuedBytes -= bytes;
+			stats.files += batch.size() - failures;
+			stats.bytes += bytes;
+			stats.failures += failures;
+			condition.notify_all();
+		}
+		running = false;
+		condition.notify_all();
+	}
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+namespace Util
+{
+	/**
+	 * @brief Writes files on a background thread so the caller never waits on the disk.
+	 *
+	 * Queued files are written in batches by a worker that only runs while there is work.
+	 * Each directory is created once. Memory is bounded: Write() blocks while the queued
+	 * data exceeds the capacity, so a slow disk throttles the producer instead of
+	 * growing the queue.
+	 *
+	 * The worker is detached and exits when the queue is empty, so a writer must outlive
+	 * it; call Flush() before destroying one.
+	 */
+	class AsyncFileWriter
+	{
+	public:
+		struct Stats
+		{
+			uint64_t files;
+			uint64_t bytes;
+			uint64_t failures;
+			uint64_t batches;
+		};
+
+		/**
+		 * @param a_capacity Bytes that may be queued before Write() blocks.
+		 */
+		explicit AsyncFileWriter(size_t a_capacity) :
+			capacity(a_capacity) {}
+
+		/**
+		 * @brief Queues a file to be written, replacing an existing file.
+		 *
+		 * @param a_path The file to write; missing parent directories are created.
+		 * @param a_data The contents, owned by the writer from now on.
+		 */
+		void Write(std::filesystem::path a_path, std::vector<uint8_t> a_data);
+
+		/**
+		 * @brief Blocks until every queued file has been written.
+		 */
+		void Flush();
+
+		Stats GetStats() const;
+
+	private:
+		struct Job
+		{
+			std::filesystem::path path;
+			std::vector<uint8_t> data;
+		};
+
+		void Run();
+
+		const size_t capacity;
+		std::unordered_set<std::string> createdDirectories;  // only touched by the worker
+		mutable std::mutex mutex;                            // guard for everything below
+		std::condition_variable condition;
+		std::deque<Job> jobs;
+		size_t queuedBytes = 0;
+		bool running = false;  // a worker is draining jobs
+		Stats stats{};
+	};
+}
@@ -0,0 +1,231 @@
+#pragma once
+
+namespace Util
+{
+	/**
+	 * @brief Shadow state for compute bindings issued by the plugin, filtering redundant calls.
+	 *
+	 * Bindings that already match are skipped and changed slots are issued as one contiguous
+	 * range. Instead of clearing every slot between the dispatches of a pass, only slots that
+	 * would create a read/write hazard are nulled: a UAV slot whose resource is about to be read
+	 * through an SRV, and an SRV slot whose resource is about to be written through a UAV.
+	 *
+	 * Callers still null their SRVs, UAVs, constant buffers, samplers and the shader through
+	 * this object at the end of a pass, so the game never inherits our bindings; only slots
+	 * that are already null are skipped. End() nulls any UAV left bound as a safety net.
+	 *
+	 * Slots start out unknown because the game binds compute state as well, so the first
+	 * binding of each slot is always issued. Call Invalidate() after anything binds compute
+	 * state behind the object's back.
+	 *
+	 * `Api` provides the context and view types and `GetResource(view)`, which only needs to
+	 * return a pointer identifying the resource. The class has no dependency on D3D itself, so
+	 * a mock API can record the issued calls and the filtering can be replayed offline.
+	 */
+	template <class Api>
+	class BasicComputeState
+	{
+	public:
+		using Context = typename Api::Context;
+		using SRV = typename Api::SRV;
+		using UAV = typename Api::UAV;
+		using Buffer = typename Api::Buffer;
+		using Sampler = typename Api::Sampler;
+		using Shader = typename Api::Shader;
+
+		static constexpr uint32_t SRVSlots = 32;  // higher slots are passed through untracked
+		static constexpr uint32_t UAVSlots = 8;
+		static constexpr uint32_t CBSlots = 14;
+		static constexpr uint32_t SamplerSlots = 16;
+
+		struct Stats
+		{
+			uint64_t calls;    // binding calls made by the plugin
+			uint64_t issued;   // binding calls forwarded to the context, hazard nulls included
+			uint64_t elided;   // calls skipped because every slot already matched
+			uint64_t hazards;  // slots nulled to resolve a read/write hazard
+		};
+
+		explicit BasicComputeState(Context* a_context) :
+			context(a_context) {}
+
+		~BasicComputeState() { End(); }
+
+		BasicComputeState(const BasicComputeState&) = delete;
+		BasicComputeState& operator=(const BasicComputeState&) = delete;
+
+		void SetShaderResources(uint32_t a_start, uint32_t a_count, SRV* const* a_views)
+		{
+			uint32_t first, end;
+			if (!Apply(srvs, a_start, a_count, a_views, first, end))
+				return;
+			uint32_t hazardFirst, hazardEnd;
+			if (NullHazards(srvs, first, end, uavs, hazardFirst, hazardEnd))
+				context->CSSetUnorderedAccessViews(hazardFirst, hazardEnd - hazardFirst, uavs.views.data() + hazardFirst, nullptr);
+			context->CSSetShaderResources(first, end - first, a_views + (first - a_start));
+		}
+
+		void SetUnorderedAccessViews(uint32_t a_start, uint32_t a_count, UAV* const* a_views, const uint32_t* a_initialCounts = nullptr)
+		{
+			uint32_t first, end;
+			// initial counts reset append buffers, so such a call is never redundant
+			if (!Apply(uavs, a_start, a_count, a_views, first, end, a_initialCounts != nullptr))
+				return;
+			uint32_t hazardFirst, hazardEnd;
+			if (NullHazards(uavs, first, end, srvs, hazardFirst, hazardEnd))
+				context->CSSetShaderResources(hazardFirst, hazardEnd - hazardFirst, srvs.views.data() + hazardFirst);
+			context->CSSetUnorderedAccessViews(first, end - first, a_views + (first - a_start), a_initialCounts ? a_initialCounts + (first - a_start) : nullptr);
+		}
+
+		void SetConstantBuffers(uint32_t a_start, uint32_t a_count, Buffer* const* a_buffers)
+		{
+			uint32_t first, end;
+			if (Apply(buffers, a_start, a_count, a_buffers, first, end))
+				context->CSSetConstantBuffers(first, end - first, a_buffers + (first - a_start));
+		}
+
+		void SetSamplers(uint32_t a_start, uint32_t a_count, Sampler* const* a_samplers)
+		{
+			uint32_t first, end;
+			if (Apply(samplers, a_start, a_count, a_samplers, first, end))
+				context->CSSetSamplers(first, end - first, a_samplers + (first - a_start));
+		}
+
+		void SetShader(Shader* a_shader)
+		{
+			totals.calls++;
+			if (shaderKnown && shader == a_shader) {
+				totals.elided++;
+				return;
+			}
+			shader = a_shader;
+			shaderKnown = true;
+			totals.issued++;
+			context->CSSetShader(a_shader, nullptr, 0);
+		}
+
+		/**
+		 * @brief Forgets the shadow state, e.g. after code that binds through the context directly.
+		 */
+		void Invalidate()
+		{
+			srvs.known.reset();
+			uavs.known.reset();
+			buffers.known.reset();
+			samplers.known.reset();
+			shaderKnown = false;
+		}
+
+		/**
+		 * @brief Nulls the UAVs bound through this object.
+		 */
+		void End()
+		{
+			uint32_t first = UAVSlots, end = 0;
+			for (uint32_t slot = 0; slot < UAVSlots; slot++) {
+				if (uavs.known[slot] && uavs.views[slot]) {
+					first = std::min(first, slot);
+					end = slot + 1;
+				}
+			}
+			if (!end)
+				return;
+			std::array<UAV*, UAVSlots> null{};
+			SetUnorderedAccessViews(first, end - first, null.data());
+		}
+
+		/**
+		 * @brief Counters summed over every object of this type.
+		 */
+		static Stats GetStats() { return totals; }
+
+	private:
+		template <class T, uint32_t N>
+		struct Slots
+		{
+			std::array<T*, N> views{};
+			std::array<void*, N> resources{};  // only kept for SRVs and UAVs
+			std::bitset<N> known;
+		};
+
+		/**
+		 * @brief Updates the shadow slots and finds the range that must be issued.
+		 * @return false if the call can be skipped.
+		 */
+		template <class T, uint32_t N>
+		bool Apply(Slots<T, N>& a_slots, uint32_t a_start, uint32_t a_count, T* const* a_views, uint32_t& a_first, uint32_t& a_end, bool a_force = false)
+		{
+			totals.calls++;
+			a_first = UINT32_MAX;
+			a_end = 0;
+			for (uint32_t i = 0; i < a_count; i++) {
+				const uint32_t slot = a_start + i;
+				if (slot < N) {
+					if (!a_force && a_slots.known[slot] && a_slots.views[slot] == a_views[i])
+						continue;
+					a_slots.views[slot] = a_views[i];
+					a_slots.known.set(slot);
+					if constexpr (std::is_same_v<T, SRV> || std::is_same_v<T, UAV>)
+						a_slots.resources[slot] = a_views[i] ? Api::GetResource(a_views[i]) : nullptr;
+				}
+				a_first = std::min(a_first, slot);
+				a_end = slot + 1;
+			}
+			if (!a_end) {
+				totals.elided++;
+				return false;
+			}
+			totals.issued++;
+			return true;
+		}
+
+		/**
+		 * @brief Nulls the known slots of the other view kind that refer to a resource bound in [a_first, a_end).
+		 *
+		 * The shadow slots are updated; the caller rebinds the returned range from them in one call.
+		 * @return true if any slot was nulled.
+		 */
+		template <class T, uint32_t N, class U, uint32_t M>
+		bool NullHazards(const Slots<T, N>& a_bound, uint32_t a_first, uint32_t a_end, Slots<U, M>& a_other, uint32_t& a_hazardFirst, uint32_t& a_hazardEnd)
+		{
+			a_hazardFirst = M;
+			a_hazardEnd = 0;
+			for (uint32_t slot = a_first; slot < std::min(a_end, N); slot++) {
+				auto resource = a_bound.resources[slot];
+				if (!resource)
+					continue;
+				for (uint32_t other = 0; other < M; other++) {
+					if (a_other.known[other] && a_other.views[other] && a_other.resources[other] == resource) {
+						a_other.views[other] = nullptr;
+						a_other.resources[other] = nullptr;
+						a_hazardFirst = std::min(a_hazardFirst, other);
+						a_hazardEnd = std::max(a_hazardEnd, other + 1);
+						totals.hazards++;
+					}
+				}
+			}
+			if (!a_hazardEnd)
+				return false;
+			// slots in between that are unknown would be overwritten with stale values
+			for (uint32_t other = a_hazardFirst; other < a_hazardEnd; other++) {
+				if (!a_other.known[other]) {
+					a_other.views[other] = nullptr;
+					a_other.resources[other] = nullptr;
+					a_other.known.set(other);
+				}
+			}
+			totals.issued++;
+			return true;
+		}
+
+		Context* context;
+		Slots<SRV, SRVSlots> srvs;
+		Slots<UAV, UAVSlots> uavs;
+		Slots<Buffer, CBSlots> buffers;
+		Slots<Sampler, SamplerSlots> samplers;
+		Shader* shader = nullptr;
+		bool shaderKnown = false;
+
+		static inline Stats totals{};
+	};
+}
@@ -1,5 +1,6 @@
 #include "D3D.h"
 
+#include "ShaderCache.h"
 #include "State.h"
 #include "Utils/Format.h"
 
@@ -87,47 +88,10 @@ namespace Util
 		Resource->SetPrivateData(WKPDID_D3DDebugObjectNameT, len, buffer);
 	}
 
-	struct CustomInclude : public ID3DInclude
-	{
-		HRESULT Open([[maybe_unused]] D3D_INCLUDE_TYPE IncludeType, LPCSTR pFileName, [[maybe_unused]] LPCVOID pParentData, LPCVOID* ppData, UINT* pBytes) override
-		{
-			std::filesystem::path filePath = pFileName;
-			filePath = L"Data\\Shaders" / filePath;
-
-			std::ifstream file(filePath, std::ios::binary);
-			if (!file.is_open()) {
-				*ppData = NULL;
-				*pBytes = 0;
-				return E_FAIL;
-			}
-
-			// Get filesize
-			file.seekg(0, std::ios::end);
-			UINT size = static_cast<UINT>(file.tellg());
-			file.seekg(0, std::ios::beg);
-
-			// Create buffer and read file
-			char* data = new char[size];
-			file.read(data, size);
-			*ppData = data;
-			*pBytes = size;
-			return S_OK;
-		}
-
-		HRESULT Close(LPCVOID pData) override
-		{
-			if (pData)
-				delete[] pData;
-			return S_OK;
-		}
-	};
-
 	ID3D11DeviceChild* CompileShader(const wchar_t* FilePath, const std::vector<std::pair<const char*, const char*>>& Defines, const char* ProgramType, const char* Program)
 	{
 		auto device = globals::d3d::device;
 
-		CustomInclude include;
-
 		// Build defines (aka convert vector->D3DCONSTANT array)
 		std::vector<D3D_SHADER_MACRO> macros;
 		std::string str = Util::WStringToString(FilePath);
@@ -176,20 +140,21 @@ namespace Util
 		// Compiler setup
 		uint32_t flags = !globals::state->IsDeveloperMode() ? (D3DCOMPILE_ENABLE_STRICTNESS | D3DCOMPILE_OPTIMIZATION_LEVEL3) : D3DCOMPILE_DEBUG;
 
-		ID3DBlob* shaderBlob;
-		ID3DBlob* shaderErrors;
-
 		if (!std::filesystem::exists(FilePath)) {
 			logger::error("Failed to compile shader; {} does not exist", str);
 			return nullptr;
 		}
+
 		logger::debug("Compiling {} with {}", str, DefinesToString(macros));
-		if (FAILED(D3DCompileFromFile(FilePath, macros.data(), &include, Program, ProgramType, flags, 0, &shaderBlob, &shaderErrors))) {
-			logger::warn("Shader compilation failed:\n\n{}", shaderErrors ? static_cast<char*>(shaderErrors->GetBufferPointer()) : "Unknown error");
-			return nullptr;
+		// compiled (or loaded from the disk cache, or taken from a startup prefetch) by the shader cache
+		SIE::BuildManifest::Permutation permutation{ "Features", str, ProgramType, flags };
+		for (const auto& macro : macros) {
+			if (macro.Name)
+				permutation.defines.emplace_back(macro.Name, macro.Definition ? macro.Definition : "");
 		}
-		if (shaderErrors)
-			logger::debug("Shader logs:\n{}", static_cast<char*>(shaderErrors->GetBufferPointer()));
+		const auto shaderBlob = globals::shaderCache->GetUtilityShader(permutation, Program);
+		if (!shaderBlob)
+			return nullptr;
 		if (!_stricmp(ProgramType, "ps_5_0")) {
 			ID3D11PixelShader* regShader;
 			device->CreatePixelShader(shaderBlob->GetBufferPointer(), shaderBlob->GetBufferSize(), nullptr, &regShader);
@@ -218,4 +183,14 @@ namespace Util
 
 		return nullptr;
 	}
+
+	void* D3D11ComputeApi::GetResource(ID3D11View* a_view)
+	{
+		// only the identity is needed, so the reference is dropped right away
+		ID3D11Resource* resource = nullptr;
+		a_view->GetResource(&resource);
+		if (resource)
+			resource->Release();
+		return resource;
+	}
 }  // namespace Util
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "ComputeState.h"
+
 namespace Util
 {
 	ID3D11ShaderResourceView* GetSRVFromRTV(ID3D11RenderTargetView* a_rtv);
@@ -9,4 +11,21 @@ namespace Util
 	void SetResourceName(ID3D11DeviceChild* Resource, const char* Format, ...);
 
 	ID3D11DeviceChild* CompileShader(const wchar_t* FilePath, const std::vector<std::pair<const char*, const char*>>& Defines, const char* ProgramType, const char* Program = "main");
+
+	struct D3D11ComputeApi
+	{
+		using Context = ID3D11DeviceContext;
+		using SRV = ID3D11ShaderResourceView;
+		using UAV = ID3D11UnorderedAccessView;
+		using Buffer = ID3D11Buffer;
+		using Sampler = ID3D11SamplerState;
+		using Shader = ID3D11ComputeShader;
+
+		static void* GetResource(ID3D11View* a_view);
+	};
+
+	/**
+	 * @brief Filters redundant compute bindings issued by features on the immediate context.
+	 */
+	using ComputeState = BasicComputeState<D3D11ComputeApi>;
 }  // namespace Util
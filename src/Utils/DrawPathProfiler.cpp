@@ -0,0 +1,32 @@
+#include "DrawPathProfiler.h"
+
+namespace Util
+{
+	void DrawPathProfiler::EndFrame()
+	{
+		lastFrame = std::exchange(frame, {});
+		switch (recording) {
+		case Recording::Armed:
+			stream.clear();
+			recording = Recording::Active;
+			break;
+		case Recording::Active:
+			recording = Recording::Idle;
+			logger::info("Recorded {} techniques for draw path replays", stream.size());
+			break;
+		default:
+			break;
+		}
+	}
+
+	DrawStream DrawPathProfiler::Export(std::span<const SIE::DescriptorRemap> a_remaps, bool a_improvedSnow) const
+	{
+		DrawStream result;
+		result.remaps.assign(a_remaps.begin(), a_remaps.end());
+		result.improvedSnow = a_improvedSnow;
+		result.techniques.reserve(stream.size());
+		for (const auto& technique : stream)
+			result.techniques.push_back({ static_cast<uint32_t>(technique.shader->shaderType.get()), technique.vertexDescriptor, technique.pixelDescriptor, technique.deferred });
+		return result;
+	}
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "DrawStream.h"
+
+namespace Util
+{
+	/**
+	 * @brief Measures the CPU cost of the per-draw hook path and replays recorded technique streams through it.
+	 *
+	 * While enabled, the hooks time their own work, excluding the game functions they wrap, and
+	 * the cost of the last complete frame is kept. The technique stream of a frame can be recorded
+	 * and replayed through the shader lookup path as often as needed, so a change to that path can
+	 * be compared on the same stream. Replays only run the lookups and issue no D3D calls.
+	 * A recording can be exported as a DrawStream to replay it in the headless benchmark.
+	 *
+	 * Not thread safe; it is only used from the render thread.
+	 */
+	class DrawPathProfiler
+	{
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		static constexpr size_t MaxRecordedTechniques = 1 << 16;
+
+		struct Technique
+		{
+			RE::BSShader* shader;
+			uint32_t vertexDescriptor;
+			uint32_t pixelDescriptor;
+			bool deferred;  // set up during a deferred pass
+		};
+
+		struct Result
+		{
+			uint64_t draws;
+			uint64_t techniques;
+			std::chrono::nanoseconds time;
+
+			double GetNsPerDraw() const { return draws ? static_cast<double>(time.count()) / static_cast<double>(draws) : 0.0; }
+		};
+
+		/**
+		 * @brief Returns the start of a timed section, or an empty time point while disabled.
+		 */
+		Clock::time_point Start() const { return enabled ? Clock::now() : Clock::time_point{}; }
+
+		void StopTechnique(Clock::time_point a_start)
+		{
+			if (a_start != Clock::time_point{})
+				frame.time += Clock::now() - a_start;
+		}
+
+		void StopDraw(Clock::time_point a_start)
+		{
+			if (a_start != Clock::time_point{}) {
+				frame.time += Clock::now() - a_start;
+				frame.draws++;
+			}
+		}
+
+		void AddTechnique(RE::BSShader* a_shader, uint32_t a_vertexDescriptor, uint32_t a_pixelDescriptor, bool a_deferred)
+		{
+			if (enabled)
+				frame.techniques++;
+			if (recording == Recording::Active && stream.size() < MaxRecordedTechniques)
+				stream.push_back({ a_shader, a_vertexDescriptor, a_pixelDescriptor, a_deferred });
+		}
+
+		/**
+		 * @brief Keeps the finished frame's cost and advances a pending recording.
+		 */
+		void EndFrame();
+
+		/**
+		 * @brief Records the technique stream of the next complete frame, replacing the previous one.
+		 */
+		void RecordNextFrame() { recording = Recording::Armed; }
+
+		bool IsRecording() const { return recording != Recording::Idle; }
+		const std::vector<Technique>& GetStream() const { return stream; }
+		Result GetLastFrame() const { return lastFrame; }
+
+		/**
+		 * @brief Runs the recorded stream through a lookup function and times it.
+		 *
+		 * @param a_repeats How often the whole stream is replayed.
+		 * @param a_lookup Called for every recorded technique.
+		 * @return The total time, with every replayed technique counted as a draw.
+		 */
+		template <class F>
+		Result Replay(uint32_t a_repeats, F&& a_lookup) const
+		{
+			const auto time = ReplayStream(std::span(stream), a_repeats, std::forward<F>(a_lookup));
+			const uint64_t count = static_cast<uint64_t>(a_repeats) * stream.size();
+			return { count, count, time };
+		}
+
+		/**
+		 * @brief Converts the recorded stream to its portable form.
+		 *
+		 * @param a_remaps The descriptor remap table in use, indexed by shader type.
+		 * @param a_improvedSnow The improved snow setting the remaps were applied with.
+		 */
+		DrawStream Export(std::span<const SIE::DescriptorRemap> a_remaps, bool a_improvedSnow) const;
+
+		bool enabled = false;
+
+	private:
+		enum class Recording
+		{
+			Idle,
+			Armed,  // waiting for the next frame to start
+			Active
+		};
+
+		Result frame{};
+		Result lastFrame{};
+		std::vector<Technique> stream;
+		Recording recording = Recording::Idle;
+	};
+}
@@ -0,0 +1,65 @@
+#include "Utils/DrawStream.h"
+
+namespace Util
+{
+	bool DrawStream::Save(const std::filesystem::path& a_path) const
+	{
+		const Header header{ Magic, Version, static_cast<uint32_t>(remaps.size()), improvedSnow, techniques.size() };
+		std::error_code ec;
+		std::filesystem::create_directories(a_path.parent_path(), ec);
+		std::ofstream out(a_path, std::ios::binary | std::ios::trunc);
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		out.write(reinterpret_cast<const char*>(remaps.data()), static_cast<std::streamsize>(remaps.size() * sizeof(SIE::DescriptorRemap)));
+		out.write(reinterpret_cast<const char*>(techniques.data()), static_cast<std::streamsize>(techniques.size() * sizeof(Technique)));
+		if (!out) {
+			logger::error("Failed to write draw stream {}", a_path.string());
+			return false;
+		}
+
+		logger::info("Saved {} techniques to draw stream {}", techniques.size(), a_path.string());
+		return true;
+	}
+
+	bool DrawStream::Load(const std::filesystem::path& a_path)
+	{
+		remaps.clear();
+		techniques.clear();
+		improvedSnow = false;
+
+		std::ifstream in(a_path, std::ios::binary);
+		if (!in.is_open())
+			return false;
+
+		std::error_code ec;
+		const auto fileSize = std::filesystem::file_size(a_path, ec);
+		Header header{};
+		if (ec || !in.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != Magic || header.version != Version ||
+			header.remapCount > (fileSize - sizeof(Header)) / sizeof(SIE::DescriptorRemap) ||
+			header.techniqueCount != (fileSize - sizeof(Header) - header.remapCount * sizeof(SIE::DescriptorRemap)) / sizeof(Technique)) {
+			logger::warn("Ignoring invalid draw stream {}", a_path.string());
+			return false;
+		}
+
+		remaps.resize(header.remapCount);
+		techniques.resize(header.techniqueCount);
+		in.read(reinterpret_cast<char*>(remaps.data()), static_cast<std::streamsize>(remaps.size() * sizeof(SIE::DescriptorRemap)));
+		in.read(reinterpret_cast<char*>(techniques.data()), static_cast<std::streamsize>(techniques.size() * sizeof(Technique)));
+		if (!in) {
+			logger::warn("Draw stream {} is truncated", a_path.string());
+			remaps.clear();
+			techniques.clear();
+			return false;
+		}
+
+		// a technique of an unknown type would index past the table
+		if (std::ranges::any_of(techniques, [&](const Technique& a_technique) { return a_technique.type >= remaps.size(); })) {
+			logger::warn("Ignoring draw stream {} with unknown shader types", a_path.string());
+			remaps.clear();
+			techniques.clear();
+			return false;
+		}
+
+		improvedSnow = header.improvedSnow != 0;
+		return true;
+	}
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "ShaderCache/DescriptorRemap.h"
+
+namespace Util
+{
+	/**
+	 * @brief A recorded technique stream that can be saved and replayed outside the game.
+	 *
+	 * Shader pointers are not portable, so each technique is stored as its shader type and
+	 * descriptors together with the deferred state of its pass. The improved snow setting and
+	 * the descriptor remap table in use are saved with it, so a headless replay can tell when
+	 * SIE::DrawPath::Remaps has changed since the stream was recorded.
+	 *
+	 * The class is plain C++ and has no dependency on the game or D3D.
+	 */
+	struct DrawStream
+	{
+		static constexpr uint32_t Magic = 0x53445343;  // "CSDS"
+		static constexpr uint32_t Version = 1;
+
+		struct Header
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint32_t remapCount;
+			uint32_t improvedSnow;
+			uint64_t techniqueCount;
+		};
+		static_assert(sizeof(Header) == 24);
+
+		struct Technique
+		{
+			uint32_t type;  // RE::BSShader::Type
+			uint32_t vertexDescriptor;
+			uint32_t pixelDescriptor;
+			uint32_t deferred;  // set up during a deferred pass
+
+			bool operator==(const Technique&) const = default;
+		};
+		static_assert(sizeof(Technique) == 16);
+
+		static_assert(std::is_trivially_copyable_v<SIE::DescriptorRemap> && sizeof(SIE::DescriptorRemap) == 56);
+
+		std::vector<SIE::DescriptorRemap> remaps;  // indexed by shader type
+		bool improvedSnow = false;
+		std::vector<Technique> techniques;
+
+		bool Save(const std::filesystem::path& a_path) const;
+		bool Load(const std::filesystem::path& a_path);
+	};
+
+	/**
+	 * @brief Runs a technique stream through a lookup function and times it.
+	 *
+	 * @param a_repeats How often the whole stream is replayed.
+	 * @param a_lookup Called for every technique.
+	 * @return The total time.
+	 */
+	template <class T, class F>
+	std::chrono::nanoseconds ReplayStream(std::span<const T> a_stream, uint32_t a_repeats, F&& a_lookup)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		for (uint32_t i = 0; i < a_repeats; i++) {
+			for (const auto& technique : a_stream)
+				a_lookup(technique);
+		}
+		return std::chrono::steady_clock::now() - start;
+	}
+}
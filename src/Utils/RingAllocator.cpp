@@ -0,0 +1,24 @@
+#include "RingAllocator.h"
+
+namespace Util
+{
+	std::optional<RingAllocator::Allocation> RingAllocator::Allocate(size_t a_size)
+	{
+		const size_t size = (std::max<size_t>(a_size, 1) + alignment - 1) & ~(alignment - 1);
+		if (size > capacity)
+			return std::nullopt;
+
+		bool wrapped = false;
+		if (size > capacity - head) {
+			head = 0;
+			wrapped = true;
+			stats.wraps++;
+		}
+
+		Allocation allocation{ head, size, wrapped };
+		head += size;
+		stats.allocations++;
+		stats.bytes += size;
+		return allocation;
+	}
+}
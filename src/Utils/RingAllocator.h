@@ -0,0 +1,59 @@
+#pragma once
+
+namespace Util
+{
+	/**
+	 * @brief Hands out aligned ranges of a fixed-size ring buffer.
+	 *
+	 * Ranges are appended until one no longer fits, then the ring wraps to offset 0. The
+	 * owner must make sure the GPU no longer reads the old contents when that happens, e.g. by
+	 * mapping the buffer with WRITE_DISCARD for a wrapped allocation and NO_OVERWRITE otherwise.
+	 * The first allocation always wraps, so a fresh buffer is discarded before it is used.
+	 *
+	 * The class is plain C++ and has no dependency on the game or D3D.
+	 */
+	class RingAllocator
+	{
+	public:
+		struct Allocation
+		{
+			size_t offset;
+			size_t size;   // requested size rounded up to the alignment
+			bool wrapped;  // the ring started over, earlier ranges may be overwritten
+		};
+
+		struct Stats
+		{
+			uint64_t allocations;
+			uint64_t wraps;
+			uint64_t bytes;
+		};
+
+		/**
+		 * @param a_capacity Size of the ring in bytes, a multiple of the alignment.
+		 * @param a_alignment Offset and size granularity of every range, a power of two.
+		 */
+		RingAllocator(size_t a_capacity, size_t a_alignment) :
+			capacity(a_capacity), alignment(a_alignment), head(a_capacity) {}
+
+		/**
+		 * @brief Reserves a range.
+		 * @return The range, or std::nullopt if the size exceeds the capacity.
+		 */
+		std::optional<Allocation> Allocate(size_t a_size);
+
+		/**
+		 * @brief Makes the next allocation wrap, e.g. after the buffer was recreated.
+		 */
+		void Reset() { head = capacity; }
+
+		size_t GetCapacity() const { return capacity; }
+		Stats GetStats() const { return stats; }
+
+	private:
+		const size_t capacity;
+		const size_t alignment;
+		size_t head;  // offset of the next free byte
+		Stats stats{};
+	};
+}
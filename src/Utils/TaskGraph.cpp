@@ -0,0 +1,113 @@
+#include "TaskGraph.h"
+
+#include <BS_thread_pool.hpp>
+
+namespace Util
+{
+	void TaskGraph::Add(std::string a_name, std::function<void()> a_task, Affinity a_affinity, std::vector<std::string> a_dependencies)
+	{
+		tasks.push_back({ std::move(a_name), std::move(a_task), a_affinity, std::move(a_dependencies), {} });
+	}
+
+	void TaskGraph::Run(std::string_view a_label)
+	{
+		std::unordered_map<std::string_view, size_t> indices;
+		for (size_t i = 0; i < tasks.size(); i++)
+			indices.emplace(tasks[i].name, i);
+		for (size_t i = 0; i < tasks.size(); i++) {
+			for (const auto& dependency : tasks[i].dependencies) {
+				auto it = indices.find(dependency);
+				if (it == indices.end()) {
+					logger::warn("{}: {} depends on unknown task {}", a_label, tasks[i].name, dependency);
+					continue;
+				}
+				tasks[it->second].dependents.push_back(i);
+				tasks[i].remaining++;
+			}
+		}
+
+		std::mutex mutex;  // guard for everything below and the tasks' remaining counts
+		std::condition_variable condition;
+		std::deque<size_t> ownerReady;
+		std::vector<uint8_t> skipped(tasks.size(), false);  // not vector<bool>, workers read their own entry unlocked
+		size_t scheduled = 0;
+		size_t finished = 0;
+		double workMs = 0.0;
+		std::exception_ptr failure;
+
+		const auto workerTasks = static_cast<size_t>(std::ranges::count(tasks, Affinity::Worker, &Task::affinity));
+		std::optional<BS::thread_pool> pool;
+		if (workerTasks)
+			pool.emplace(static_cast<BS::concurrency_t>(std::min<size_t>(workerTasks, std::max(std::thread::hardware_concurrency(), 1u))));
+
+		std::function<void(size_t)> schedule;
+		const auto execute = [&](size_t a_index) {
+			auto& task = tasks[a_index];
+			const auto start = std::chrono::steady_clock::now();
+			std::exception_ptr error;
+			if (!skipped[a_index]) {
+				try {
+					task.work();
+				} catch (...) {
+					error = std::current_exception();
+				}
+			}
+			const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			if (skipped[a_index])
+				logger::warn("{}: skipped {} after a dependency failed", a_label, task.name);
+			else if (error)
+				logger::error("{}: {} failed after {:.1f} ms", a_label, task.name, ms);
+			else
+				logger::info("{}: {} took {:.1f} ms{}", a_label, task.name, ms, task.affinity == Affinity::Worker ? " (worker)" : "");
+
+			std::lock_guard lock(mutex);
+			workMs += ms;
+			finished++;
+			if (error && !failure)
+				failure = error;
+			for (auto dependent : task.dependents) {
+				if (error || skipped[a_index])
+					skipped[dependent] = true;
+				if (--tasks[dependent].remaining == 0)
+					schedule(dependent);
+			}
+			condition.notify_all();
+		};
+		schedule = [&](size_t a_index) {
+			scheduled++;
+			if (tasks[a_index].affinity == Affinity::Worker)
+				pool->push_task(execute, a_index);
+			else
+				ownerReady.push_back(a_index);
+		};
+
+		const auto start = std::chrono::steady_clock::now();
+		{
+			std::lock_guard lock(mutex);
+			for (size_t i = 0; i < tasks.size(); i++) {
+				if (tasks[i].remaining == 0)
+					schedule(i);
+			}
+		}
+		while (true) {
+			std::unique_lock lock(mutex);
+			condition.wait(lock, [&]() { return !ownerReady.empty() || finished == scheduled; });
+			if (ownerReady.empty()) {
+				if (finished < tasks.size())
+					logger::error("{}: {} tasks are part of a dependency cycle and were not run", a_label, tasks.size() - finished);
+				break;
+			}
+			const size_t index = ownerReady.front();
+			ownerReady.pop_front();
+			lock.unlock();
+			execute(index);
+		}
+		if (pool)
+			pool->wait_for_tasks();
+
+		logger::info("{}: {} tasks took {:.1f} ms ({:.1f} ms of work)", a_label, finished, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(), workMs);
+		tasks.clear();
+		if (failure)
+			std::rethrow_exception(failure);
+	}
+}  // namespace Util
@@ -0,0 +1,52 @@
+#pragma once
+
+namespace Util
+{
+	/**
+	 * @brief Runs named startup tasks in dependency order, independent worker tasks concurrently.
+	 *
+	 * Owner tasks run on the thread calling Run(), which keeps D3D immediate-context work, hook
+	 * installation and event registration where they were. Worker tasks may only use the device,
+	 * the file system and their own state. Every task's duration is logged.
+	 */
+	class TaskGraph
+	{
+	public:
+		enum class Affinity
+		{
+			Owner,  // the thread calling Run()
+			Worker
+		};
+
+		/**
+		 * @param a_name Unique task name, used for dependencies and timing logs.
+		 * @param a_task The work to run.
+		 * @param a_affinity Where the task may run.
+		 * @param a_dependencies Names of tasks that must finish first; unknown names are logged and ignored.
+		 */
+		void Add(std::string a_name, std::function<void()> a_task, Affinity a_affinity = Affinity::Owner, std::vector<std::string> a_dependencies = {});
+
+		/**
+		 * @brief Runs every task and clears the graph.
+		 *
+		 * The first exception thrown by a task is rethrown here once running tasks have finished;
+		 * tasks depending on a failed task are skipped.
+		 *
+		 * @param a_label Prefix for the timing log lines.
+		 */
+		void Run(std::string_view a_label);
+
+	private:
+		struct Task
+		{
+			std::string name;
+			std::function<void()> work;
+			Affinity affinity;
+			std::vector<std::string> dependencies;
+			std::vector<size_t> dependents;
+			size_t remaining = 0;  // unfinished dependencies
+		};
+
+		std::vector<Task> tasks;
+	};
+}  // namespace Util
@@ -91,15 +91,20 @@ void MessageHandler(SKSE::MessagingInterface::Message* message)
 				auto shaderCache = globals::shaderCache;
 
 				shaderCache->ValidateDiskCache();
+				shaderCache->LoadWarmList();
+				shaderCache->PrefetchUtilityShaders();
 
 				if (shaderCache->UseFileWatcher())
 					shaderCache->StartFileWatcher();
 
+				// hooks and event sinks are installed here, so everything stays on this thread; the graph logs timings
+				Util::TaskGraph postPostLoad;
 				for (auto* feature : Feature::GetFeatureList()) {
 					if (feature->loaded) {
-						feature->PostPostLoad();
+						postPostLoad.Add(feature->GetShortName(), [feature]() { feature->PostPostLoad(); });
 					}
 				}
+				postPostLoad.Run("PostPostLoad");
 			}
 
 			break;
@@ -120,6 +125,9 @@ void MessageHandler(SKSE::MessagingInterface::Message* message)
 				while (shaderCache->IsCompiling() && !shaderCache->backgroundCompilation) {
 					std::this_thread::sleep_for(100ms);
 				}
+				// background compiles save when the compilation set drains instead
+				if (!shaderCache->IsCompiling())
+					shaderCache->SaveWarmList();
 
 				if (shaderCache->IsDiskCache()) {
 					shaderCache->WriteDiskCacheInfo();
@@ -131,15 +139,23 @@ void MessageHandler(SKSE::MessagingInterface::Message* message)
 				}
 
 				globals::truePBR->DataLoaded();
+				Util::TaskGraph dataLoaded;
 				for (auto* feature : Feature::GetFeatureList()) {
 					if (feature->loaded) {
-						feature->DataLoaded();
+						dataLoaded.Add(feature->GetShortName(), [feature]() { feature->DataLoaded(); });
 					}
 				}
+				dataLoaded.Run("DataLoaded");
 			}
 
 			break;
 		}
+	case SKSE::MessagingInterface::kSaveGame:
+		{
+			if (errors.empty())
+				globals::shaderCache->SaveWarmList();
+			break;
+		}
 	}
 }
 
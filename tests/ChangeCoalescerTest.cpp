@@ -0,0 +1,103 @@
+#include "Check.h"
+
+#include "ShaderCache/ChangeCoalescer.h"
+
+using SIE::ChangeCoalescer;
+
+namespace
+{
+	using Strings = std::vector<std::string>;
+
+	const ChangeCoalescer::Clock::time_point Start{ std::chrono::hours(1) };
+
+	void TestEditorSave()
+	{
+		ChangeCoalescer changes;
+		// truncate, write, then a rename of the temporary file over the target
+		CHECK(changes.Add("Data\\Shaders\\Lighting.hlsl", Start));
+		CHECK(!changes.Add("Data\\Shaders\\Lighting.hlsl", Start + 2ms));
+		CHECK(changes.Add("Data\\Shaders\\Lighting.hlsl.tmp", Start + 5ms));
+		CHECK(!changes.Add("data/shaders/LIGHTING.hlsl", Start + 6ms));
+		CHECK(!changes.Empty());
+
+		CHECK(changes.Take(Start + 6ms).empty());
+		CHECK(changes.Take(Start + 305ms).empty());
+		const auto batch = changes.Take(Start + 306ms);
+		CHECK((batch == Strings{ "Data\\Shaders\\Lighting.hlsl", "Data\\Shaders\\Lighting.hlsl.tmp" }));
+		CHECK(changes.GetCoalescedEvents() == 2);
+		CHECK(changes.Empty());
+		CHECK(changes.Take(Start + 10s).empty());
+	}
+
+	void TestCheckout()
+	{
+		ChangeCoalescer changes;
+		Strings created;
+		for (int i = 0; i < 50; i++) {
+			created.push_back("Data\\Shaders\\Common\\File" + std::to_string(i) + ".hlsli");
+			changes.Add(created.back(), Start + std::chrono::milliseconds(i));
+			changes.Add(created.back(), Start + std::chrono::milliseconds(i));  // created, then modified
+		}
+		CHECK(changes.Take(Start + 300ms).empty());
+		CHECK(changes.Take(Start + 349ms) == created);
+		CHECK(changes.GetCoalescedEvents() == 50);
+	}
+
+	void TestMaxDelay()
+	{
+		ChangeCoalescer changes;
+		// a build writing a file every 100 ms never leaves a quiet period
+		auto now = Start;
+		Strings batch;
+		for (int i = 0; batch.empty() && i < 100; i++, now += 100ms) {
+			changes.Add("Data\\Shaders\\Output" + std::to_string(i % 4) + ".hlsl", now);
+			batch = changes.Take(now);
+		}
+		CHECK(now - 100ms == Start + 2000ms);
+		CHECK(batch.size() == 4);
+
+		// the next batch starts at its own first event
+		changes.Add("Data\\Shaders\\Output0.hlsl", now);
+		CHECK(changes.Take(now + 299ms).empty());
+		CHECK(changes.Take(now + 300ms).size() == 1);
+	}
+
+	void TestSettings()
+	{
+		ChangeCoalescer changes({ .quiet = 50ms, .maxDelay = 120ms });
+		changes.Add("a.hlsl", Start);
+		changes.Add("b.hlsl", Start + 40ms);
+		CHECK(changes.Take(Start + 89ms).empty());
+		CHECK(changes.Take(Start + 90ms).size() == 2);
+
+		changes.Add("a.hlsl", Start + 200ms);
+		changes.Add("b.hlsl", Start + 280ms);
+		CHECK(changes.Take(Start + 319ms).empty());
+		CHECK(changes.Take(Start + 320ms).size() == 2);
+	}
+
+	void TestClear()
+	{
+		ChangeCoalescer changes;
+		changes.Add("a.hlsl", Start);
+		changes.Add("a.hlsl", Start);
+		changes.Clear();
+		CHECK(changes.Empty());
+		CHECK(changes.Take(Start + 10s).empty());
+		CHECK(changes.GetCoalescedEvents() == 0);
+
+		// cleared files are reported again
+		CHECK(changes.Add("a.hlsl", Start + 20s));
+		CHECK((changes.Take(Start + 21s) == Strings{ "a.hlsl" }));
+	}
+}
+
+int main()
+{
+	TestEditorSave();
+	TestCheckout();
+	TestMaxDelay();
+	TestSettings();
+	TestClear();
+	return Test::Finish("ChangeCoalescerTest");
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+/**
+ * @brief Minimal assertions for the headless tests, which have no test framework dependency.
+ *
+ * CHECK records a failure and carries on so one run reports every broken expectation.
+ * Test::Finish() prints the summary and returns the process exit code.
+ */
+namespace Test
+{
+	inline int failures = 0;
+
+	inline void Check(bool a_passed, const char* a_expression, const char* a_file, int a_line)
+	{
+		if (a_passed)
+			return;
+		failures++;
+		std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", a_file, a_line, a_expression);
+	}
+
+	inline int Finish(const char* a_name)
+	{
+		if (failures)
+			std::fprintf(stderr, "%s: %d check(s) failed\n", a_name, failures);
+		else
+			std::printf("%s: passed\n", a_name);
+		return failures ? 1 : 0;
+	}
+
+	/**
+	 * @brief Runs a_function a_iterations times and prints the mean time per call.
+	 * @return Nanoseconds per call.
+	 */
+	template <class F>
+	double Measure(const char* a_name, uint64_t a_iterations, F&& a_function)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		for (uint64_t i = 0; i < a_iterations; i++)
+			a_function(i);
+		const auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+		const double perCall = a_iterations ? elapsed / static_cast<double>(a_iterations) : 0.0;
+		std::printf("%-40s %12llu calls %10.2f ns/call\n", a_name, static_cast<unsigned long long>(a_iterations), perCall);
+		return perCall;
+	}
+
+	/**
+	 * @brief Keeps a_value alive so the optimizer cannot drop the work that produced it.
+	 */
+	template <class T>
+	void DoNotOptimize(T a_value)
+	{
+		static volatile T sink;
+		sink = a_value;
+	}
+}
+
+#define CHECK(...) Test::Check(static_cast<bool>(__VA_ARGS__), #__VA_ARGS__, __FILE__, __LINE__)
@@ -0,0 +1,119 @@
+#include "Check.h"
+
+#include "ShaderCache/CompilationQueue.h"
+
+namespace
+{
+	enum class Priority
+	{
+		OnDemand,
+		Warm,
+		Background,
+		Total
+	};
+
+	using Queue = SIE::CompilationQueue<int, Priority>;
+
+	std::vector<int> Drain(Queue& a_queue)
+	{
+		std::vector<int> order;
+		while (auto next = a_queue.Pop())
+			order.push_back(next->first);
+		return order;
+	}
+
+	void TestClassOrder()
+	{
+		Queue queue;
+		CHECK(queue.Push(1, Priority::Background) == Queue::PushResult::Added);
+		CHECK(queue.Push(2, Priority::Warm) == Queue::PushResult::Added);
+		CHECK(queue.Push(3, Priority::OnDemand) == Queue::PushResult::Added);
+		CHECK(queue.Push(4, Priority::Warm) == Queue::PushResult::Added);
+		CHECK(queue.Size() == 4);
+		CHECK(queue.Peek() == Priority::OnDemand);
+		CHECK((Drain(queue) == std::vector{ 3, 2, 4, 1 }));
+		CHECK(queue.Empty());
+		CHECK(!queue.Pop());
+	}
+
+	void TestCostOrderWithinClass()
+	{
+		Queue queue;
+		queue.Push(1, Priority::Background, 1.0f);
+		queue.Push(2, Priority::Background, 5.0f);
+		queue.Push(3, Priority::Background, 1.0f);
+		queue.Push(4, Priority::Background, 3.0f);
+		queue.Push(5, Priority::Background, 1.0f);
+		// most expensive first, equal costs in push order
+		CHECK((Drain(queue) == std::vector{ 2, 4, 1, 3, 5 }));
+	}
+
+	void TestPreemption()
+	{
+		Queue queue;
+		for (int task = 0; task < 8; task++)
+			queue.Push(task, Priority::Background, 10.0f);
+
+		auto first = queue.Pop();
+		CHECK(first && first->first == 0 && first->second == Priority::Background);
+
+		// a draw miss queued behind background work is served next
+		queue.Push(100, Priority::OnDemand);
+		auto next = queue.Pop();
+		CHECK(next && next->first == 100 && next->second == Priority::OnDemand);
+
+		queue.Push(101, Priority::Warm);
+		queue.Push(102, Priority::OnDemand);
+		CHECK(queue.Peek() == Priority::OnDemand);
+		CHECK(queue.Pop()->first == 102);
+		CHECK(queue.Pop()->first == 101);
+		CHECK(queue.Pop()->first == 1);
+		CHECK(queue.Size() == 6);
+	}
+
+	void TestPromotion()
+	{
+		Queue queue;
+		queue.Push(1, Priority::Background);
+		queue.Push(2, Priority::Background);
+		queue.Push(3, Priority::Warm);
+
+		CHECK(queue.Push(2, Priority::OnDemand) == Queue::PushResult::Promoted);
+		CHECK(queue.GetPriority(2) == Priority::OnDemand);
+		CHECK(queue.Push(2, Priority::OnDemand) == Queue::PushResult::Unchanged);
+		CHECK(queue.Push(3, Priority::Background) == Queue::PushResult::Unchanged);
+		CHECK(queue.GetPriority(3) == Priority::Warm);
+		CHECK(queue.Size() == 3);
+
+		// the stale background entry of task 2 is dropped, so it is served once
+		CHECK((Drain(queue) == std::vector{ 2, 3, 1 }));
+		CHECK(!queue.Contains(2));
+		CHECK(!queue.Peek());
+	}
+
+	void TestRequeueAfterPop()
+	{
+		Queue queue;
+		queue.Push(1, Priority::OnDemand);
+		queue.Push(1, Priority::Background);  // still queued, so unchanged
+		CHECK(queue.Pop()->first == 1);
+		CHECK(queue.Push(1, Priority::Background) == Queue::PushResult::Added);
+		CHECK(queue.Pop()->second == Priority::Background);
+		CHECK(queue.Empty());
+
+		queue.Push(2, Priority::Warm);
+		queue.Clear();
+		CHECK(queue.Empty());
+		CHECK(!queue.Peek());
+	}
+}
+
+int main()
+{
+	TestClassOrder();
+	TestCostOrderWithinClass();
+	TestPreemption();
+	TestPromotion();
+	TestRequeueAfterPop();
+	return Test::Finish("CompilationQueueTest");
+}
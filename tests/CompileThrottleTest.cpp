@@ -0,0 +1,165 @@
+#include "Check.h"
+
+#include "ShaderCache/CompileThrottle.h"
+
+using SIE::CompileThrottle;
+
+// Replays frame-time traces through the throttle. Pass a trace file with one "ms [idle]"
+// sample per line to see how a recorded session would have been throttled.
+namespace
+{
+	struct Sample
+	{
+		float ms;
+		bool idle;
+	};
+
+	using Trace = std::vector<Sample>;
+
+	struct Replay
+	{
+		int32_t finalLimit;
+		int32_t minLimit;
+		int32_t maxLimit;
+		uint32_t changes;
+	};
+
+	Replay Run(CompileThrottle& a_throttle, const Trace& a_trace)
+	{
+		Replay result{ a_throttle.GetLimit(), a_throttle.GetLimit(), a_throttle.GetLimit(), 0 };
+		for (const auto& sample : a_trace) {
+			const int32_t previous = a_throttle.GetLimit();
+			a_throttle.OnFrame(sample.ms, sample.idle);
+			const int32_t limit = a_throttle.GetLimit();
+			result.changes += limit != previous;
+			result.minLimit = std::min(result.minLimit, limit);
+			result.maxLimit = std::max(result.maxLimit, limit);
+			result.finalLimit = limit;
+		}
+		return result;
+	}
+
+	// CPU work time of a frame, with gaussian jitter and an occasional spike
+	Trace MakeTrace(size_t a_frames, float a_meanMs, float a_jitterMs, uint32_t a_seed, float a_spikeMs = 0.0f)
+	{
+		std::mt19937 random(a_seed);
+		std::normal_distribution<float> jitter(0.0f, a_jitterMs);
+		Trace trace;
+		for (size_t i = 0; i < a_frames; i++) {
+			float ms = std::max(a_meanMs + jitter(random), 0.5f);
+			if (a_spikeMs > 0.0f && i % 97 == 50)
+				ms += a_spikeMs;
+			trace.push_back({ ms, false });
+		}
+		return trace;
+	}
+
+	Trace Concat(std::initializer_list<Trace> a_traces)
+	{
+		Trace result;
+		for (const auto& trace : a_traces)
+			result.insert(result.end(), trace.begin(), trace.end());
+		return result;
+	}
+
+	// a 60 FPS budget, one to four gameplay workers and eight while idle
+	constexpr CompileThrottle::Settings Settings{ 16.7f, 1, 4, 8 };
+
+	std::optional<Trace> LoadTrace(const std::filesystem::path& a_path)
+	{
+		std::ifstream in(a_path);
+		if (!in.is_open())
+			return std::nullopt;
+		Trace trace;
+		std::string line;
+		while (std::getline(in, line)) {
+			Sample sample{};
+			int idle = 0;
+			if (std::sscanf(line.c_str(), "%f %d", &sample.ms, &idle) >= 1) {
+				sample.idle = idle != 0;
+				trace.push_back(sample);
+			}
+		}
+		return trace;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	// a 60 FPS cap with light CPU work keeps every worker, spikes included
+	{
+		CompileThrottle throttle;
+		throttle.SetSettings(Settings);
+		auto replay = Run(throttle, MakeTrace(3000, 9.0f, 1.0f, 1, 20.0f));
+		CHECK(replay.minLimit == 4);
+		CHECK(replay.changes == 0);
+	}
+
+	// work that sits right at the cap only jitters around the budget and must not ratchet down
+	{
+		CompileThrottle throttle;
+		throttle.SetSettings(Settings);
+		auto replay = Run(throttle, MakeTrace(6000, 16.6f, 0.3f, 2));
+		CHECK(replay.finalLimit == 4);
+		CHECK(replay.changes == 0);
+	}
+
+	// sustained overload backs off to the floor, one worker per BackoffFrames at most
+	{
+		CompileThrottle throttle;
+		throttle.SetSettings(Settings);
+		auto replay = Run(throttle, MakeTrace(60, 25.0f, 1.0f, 3));
+		CHECK(replay.finalLimit == 1);
+
+		CompileThrottle slow;
+		slow.SetSettings(Settings);
+		Run(slow, MakeTrace(CompileThrottle::BackoffFrames * 2, 25.0f, 0.0f, 4));
+		CHECK(slow.GetLimit() >= 4 - 2);
+	}
+
+	// workers come back one at a time once the work time drops under the headroom
+	{
+		CompileThrottle throttle;
+		throttle.SetSettings(Settings);
+		Run(throttle, MakeTrace(100, 30.0f, 1.0f, 5));
+		CHECK(throttle.GetLimit() == 1);
+		auto replay = Run(throttle, MakeTrace(CompileThrottle::RampFrames * 4 + 60, 8.0f, 0.5f, 6));
+		CHECK(replay.finalLimit == 4);
+		CHECK(replay.changes == 3);
+	}
+
+	// loading screens allow the idle count and restore the gameplay limit afterwards
+	{
+		CompileThrottle throttle;
+		throttle.SetSettings(Settings);
+		Run(throttle, MakeTrace(100, 30.0f, 1.0f, 7));
+		CHECK(throttle.GetLimit() == 1);
+		CHECK(throttle.OnFrame(500.0f, true));
+		CHECK(throttle.GetLimit() == 8 && throttle.IsIdle());
+		Run(throttle, MakeTrace(5, 30.0f, 0.0f, 8));
+		CHECK(throttle.GetLimit() == 1 && !throttle.IsIdle());
+	}
+
+	// hitches and alt-tabs are ignored
+	{
+		CompileThrottle throttle;
+		throttle.SetSettings(Settings);
+		auto replay = Run(throttle, Concat({ MakeTrace(200, 8.0f, 0.5f, 9), Trace(40, Sample{ 1000.0f, false }), MakeTrace(200, 8.0f, 0.5f, 10) }));
+		CHECK(replay.changes == 0);
+		CHECK(throttle.GetAverageFrameMs() < 10.0f);
+	}
+
+	if (argc > 1) {
+		auto trace = LoadTrace(argv[1]);
+		if (!trace) {
+			std::fprintf(stderr, "CompileThrottleTest: cannot read trace %s\n", argv[1]);
+			return 1;
+		}
+		CompileThrottle throttle;
+		throttle.SetSettings(Settings);
+		auto replay = Run(throttle, *trace);
+		std::printf("%zu frames: limit %d..%d, %u changes, final %d\n", trace->size(), replay.minLimit, replay.maxLimit, replay.changes, replay.finalLimit);
+	}
+
+	return Test::Finish("CompileThrottleTest");
+}
@@ -0,0 +1,273 @@
+#include "Check.h"
+
+#include "Utils/ComputeState.h"
+
+namespace
+{
+	struct Resource
+	{};
+
+	struct SRV
+	{
+		Resource* resource;
+	};
+
+	struct UAV
+	{
+		Resource* resource;
+	};
+
+	struct Buffer
+	{};
+
+	struct Sampler
+	{};
+
+	struct Shader
+	{};
+
+	enum class Kind
+	{
+		SRVs,
+		UAVs,
+		Buffers,
+		Samplers,
+		Shader
+	};
+
+	struct Call
+	{
+		Kind kind;
+		uint32_t start;
+		std::vector<const void*> items;
+		bool counts = false;
+	};
+
+	// records every call the state forwards
+	struct Context
+	{
+		std::vector<Call> calls;
+
+		template <class T>
+		void Record(Kind a_kind, uint32_t a_start, uint32_t a_count, T* const* a_items, bool a_counts = false)
+		{
+			calls.push_back({ a_kind, a_start, std::vector<const void*>(a_items, a_items + a_count), a_counts });
+		}
+
+		void CSSetShaderResources(uint32_t a_start, uint32_t a_count, SRV* const* a_views) { Record(Kind::SRVs, a_start, a_count, a_views); }
+		void CSSetUnorderedAccessViews(uint32_t a_start, uint32_t a_count, UAV* const* a_views, const uint32_t* a_initialCounts) { Record(Kind::UAVs, a_start, a_count, a_views, a_initialCounts != nullptr); }
+		void CSSetConstantBuffers(uint32_t a_start, uint32_t a_count, Buffer* const* a_buffers) { Record(Kind::Buffers, a_start, a_count, a_buffers); }
+		void CSSetSamplers(uint32_t a_start, uint32_t a_count, Sampler* const* a_samplers) { Record(Kind::Samplers, a_start, a_count, a_samplers); }
+		void CSSetShader(Shader* a_shader, void*, uint32_t) { Record(Kind::Shader, 0, 1, &a_shader); }
+
+		std::vector<Call> Take() { return std::exchange(calls, {}); }
+	};
+
+	struct FakeApi
+	{
+		using Context = ::Context;
+		using SRV = ::SRV;
+		using UAV = ::UAV;
+		using Buffer = ::Buffer;
+		using Sampler = ::Sampler;
+		using Shader = ::Shader;
+
+		static void* GetResource(SRV* a_view) { return a_view->resource; }
+		static void* GetResource(UAV* a_view) { return a_view->resource; }
+	};
+
+	using ComputeState = Util::BasicComputeState<FakeApi>;
+
+	bool Is(const Call& a_call, Kind a_kind, uint32_t a_start, std::vector<const void*> a_items)
+	{
+		return a_call.kind == a_kind && a_call.start == a_start && a_call.items == a_items;
+	}
+
+	void TestRedundantBinds()
+	{
+		Context context;
+		Resource a, b, c;
+		SRV srvA{ &a }, srvB{ &b }, srvC{ &c };
+		Buffer cb;
+		Sampler sampler;
+		Shader shader;
+
+		ComputeState cs(&context);
+
+		// slots start out unknown, so the first binding is always issued, even a null one
+		SRV* srvs[3]{ &srvA, &srvB, nullptr };
+		cs.SetShaderResources(0, 3, srvs);
+		Buffer* buffers[1]{ &cb };
+		cs.SetConstantBuffers(1, 1, buffers);
+		Sampler* samplers[1]{ &sampler };
+		cs.SetSamplers(0, 1, samplers);
+		cs.SetShader(&shader);
+		auto calls = context.Take();
+		CHECK(calls.size() == 4);
+		CHECK(Is(calls[0], Kind::SRVs, 0, { &srvA, &srvB, nullptr }));
+		CHECK(Is(calls[1], Kind::Buffers, 1, { &cb }));
+		CHECK(Is(calls[2], Kind::Samplers, 0, { &sampler }));
+		CHECK(Is(calls[3], Kind::Shader, 0, { &shader }));
+
+		// the same bindings again are skipped entirely
+		const auto before = ComputeState::GetStats();
+		cs.SetShaderResources(0, 3, srvs);
+		cs.SetConstantBuffers(1, 1, buffers);
+		cs.SetSamplers(0, 1, samplers);
+		cs.SetShader(&shader);
+		CHECK(context.Take().empty());
+		const auto after = ComputeState::GetStats();
+		CHECK(after.calls - before.calls == 4);
+		CHECK(after.elided - before.elided == 4);
+		CHECK(after.issued == before.issued);
+
+		// only the changed slots are issued, as one range
+		SRV* changed[4]{ &srvA, &srvC, nullptr, &srvB };
+		cs.SetShaderResources(0, 4, changed);
+		calls = context.Take();
+		CHECK(calls.size() == 1);
+		CHECK(Is(calls[0], Kind::SRVs, 1, { &srvC, nullptr, &srvB }));
+
+		// slots above the tracked range are passed through
+		SRV* high[1]{ &srvA };
+		cs.SetShaderResources(ComputeState::SRVSlots, 1, high);
+		cs.SetShaderResources(ComputeState::SRVSlots, 1, high);
+		calls = context.Take();
+		CHECK(calls.size() == 2);
+
+		// after an invalidation everything is issued again
+		cs.Invalidate();
+		cs.SetShader(&shader);
+		cs.SetConstantBuffers(1, 1, buffers);
+		CHECK(context.Take().size() == 2);
+	}
+
+	void TestHazards()
+	{
+		Context context;
+		Resource a, b, c;
+		SRV srvA{ &a }, srvB{ &b };
+		UAV uavA{ &a }, uavB{ &b }, uavC{ &c };
+
+		ComputeState cs(&context);
+
+		// first pass writes a and b
+		UAV* uavs[2]{ &uavA, &uavB };
+		cs.SetUnorderedAccessViews(0, 2, uavs);
+		context.Take();
+
+		// reading a nulls the UAV slot that writes it before the SRV is bound
+		const auto before = ComputeState::GetStats();
+		SRV* srvs[1]{ &srvA };
+		cs.SetShaderResources(0, 1, srvs);
+		auto calls = context.Take();
+		CHECK(calls.size() == 2);
+		CHECK(Is(calls[0], Kind::UAVs, 0, { nullptr }));
+		CHECK(Is(calls[1], Kind::SRVs, 0, { &srvA }));
+		CHECK(ComputeState::GetStats().hazards - before.hazards == 1);
+
+		// writing a again nulls the SRV slot that reads it
+		UAV* rewrite[1]{ &uavA };
+		cs.SetUnorderedAccessViews(2, 1, rewrite);
+		calls = context.Take();
+		CHECK(calls.size() == 2);
+		CHECK(Is(calls[0], Kind::SRVs, 0, { nullptr }));
+		CHECK(Is(calls[1], Kind::UAVs, 2, { &uavA }));
+
+		// unknown slots inside a hazard range are nulled rather than left with stale values
+		cs.Invalidate();
+		SRV* spread[3]{ &srvA, nullptr, &srvB };
+		cs.SetShaderResources(0, 3, spread);
+		context.Take();
+		cs.Invalidate();
+		cs.SetShaderResources(0, 1, spread);
+		cs.SetShaderResources(2, 1, spread + 2);
+		context.Take();
+		UAV* both[2]{ &uavA, &uavB };
+		cs.SetUnorderedAccessViews(4, 2, both);
+		calls = context.Take();
+		CHECK(calls.size() == 2);
+		CHECK(Is(calls[0], Kind::SRVs, 0, { nullptr, nullptr, nullptr }));
+		CHECK(Is(calls[1], Kind::UAVs, 4, { &uavA, &uavB }));
+
+		// initial counts reset append buffers, so the call is never skipped
+		const uint32_t counts[1]{ 0 };
+		UAV* append[1]{ &uavC };
+		cs.SetUnorderedAccessViews(6, 1, append, counts);
+		cs.SetUnorderedAccessViews(6, 1, append, counts);
+		calls = context.Take();
+		CHECK(calls.size() == 2);
+		CHECK(calls[1].counts);
+	}
+
+	void TestEndOfPass()
+	{
+		Context context;
+		Resource a, b;
+		SRV srvA{ &a };
+		UAV uavB{ &b };
+		Buffer cb;
+		Sampler sampler;
+		Shader shader;
+
+		// the destructor nulls the UAVs left bound
+		{
+			ComputeState cs(&context);
+			UAV* uavs[2]{ nullptr, &uavB };
+			cs.SetUnorderedAccessViews(0, 2, uavs);
+			context.Take();
+		}
+		auto calls = context.Take();
+		CHECK(calls.size() == 1);
+		CHECK(Is(calls[0], Kind::UAVs, 1, { nullptr }));
+
+		// an explicit cleanup is issued in full, including slots the pass never bound,
+		// and leaves nothing for the destructor to do
+		{
+			ComputeState cs(&context);
+			SRV* srvs[1]{ &srvA };
+			cs.SetShaderResources(0, 1, srvs);
+			UAV* uavs[1]{ &uavB };
+			cs.SetUnorderedAccessViews(0, 1, uavs);
+			Buffer* buffers[1]{ &cb };
+			cs.SetConstantBuffers(1, 1, buffers);
+			Sampler* samplers[1]{ &sampler };
+			cs.SetSamplers(0, 1, samplers);
+			cs.SetShader(&shader);
+			context.Take();
+
+			SRV* nullSrvs[2]{};
+			cs.SetShaderResources(0, 2, nullSrvs);
+			UAV* nullUavs[1]{};
+			cs.SetUnorderedAccessViews(0, 1, nullUavs);
+			Buffer* nullBuffers[1]{};
+			cs.SetConstantBuffers(1, 1, nullBuffers);
+			cs.SetConstantBuffers(12, 1, nullBuffers);
+			Sampler* nullSamplers[1]{};
+			cs.SetSamplers(0, 1, nullSamplers);
+			cs.SetShader(nullptr);
+			calls = context.Take();
+			CHECK(calls.size() == 6);
+			CHECK(Is(calls[0], Kind::SRVs, 0, { nullptr, nullptr }));
+			CHECK(Is(calls[1], Kind::UAVs, 0, { nullptr }));
+			CHECK(Is(calls[2], Kind::Buffers, 1, { nullptr }));
+			CHECK(Is(calls[3], Kind::Buffers, 12, { nullptr }));
+			CHECK(Is(calls[4], Kind::Samplers, 0, { nullptr }));
+			CHECK(Is(calls[5], Kind::Shader, 0, { nullptr }));
+
+			// a second cleanup is redundant
+			cs.SetShaderResources(0, 2, nullSrvs);
+			cs.SetShader(nullptr);
+			CHECK(context.Take().empty());
+		}
+		CHECK(context.Take().empty());
+	}
+}
+
+int main()
+{
+	TestRedundantBinds();
+	TestHazards();
+	TestEndOfPass();
+	return Test::Finish("ComputeStateTest");
+}
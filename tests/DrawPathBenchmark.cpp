@@ -0,0 +1,263 @@
+#include "Check.h"
+
+#include "ShaderCache/DrawPath.h"
+#include "Utils/DrawStream.h"
+
+// Replays a technique stream through SIE::DrawPath, the part of the draw hooks that needs no
+// game objects: the game's descriptor remapping, the fallback search of ResolveFallback, the
+// lookups of ShaderCache::Get*Shader and the permutation buffer check of State::Draw. Pass a
+// stream saved from the in-game Draw Path menu to time a real frame; without one a synthetic
+// stream is used.
+namespace
+{
+	namespace DrawPath = SIE::DrawPath;
+	using SIE::CompilationPriority;
+	using SIE::DescriptorRemap;
+	using SIE::ShaderType;
+	using Util::DrawStream;
+
+	struct Shader
+	{
+		uint32_t descriptor;
+	};
+
+	using Lookup = SIE::ShaderLookup<Shader>;
+
+	constexpr uint32_t TypeCount = static_cast<uint32_t>(ShaderType::Total);
+
+	DrawStream MakeSyntheticStream(size_t a_count, uint32_t a_seed)
+	{
+		DrawStream stream;
+		stream.remaps.assign(DrawPath::Remaps.begin(), DrawPath::Remaps.end());
+		stream.improvedSnow = true;
+
+		// a frame binds a few hundred permutations, most of them many times, and about half are lighting
+		std::mt19937 random(a_seed);
+		const auto next = [&]() { return static_cast<uint32_t>(random()); };
+		std::vector<DrawStream::Technique> permutations(384);
+		for (auto& permutation : permutations) {
+			const uint32_t type = next() % 2 ? static_cast<uint32_t>(ShaderType::Lighting) : 1 + next() % (TypeCount - 1);
+			permutation = { type, next() & 0x3FFFFFFF, next() & 0x3FFFFFFF, next() % 2 };
+		}
+		std::geometric_distribution<size_t> pick(0.02);
+		stream.techniques.reserve(a_count);
+		for (size_t i = 0; i < a_count; i++)
+			stream.techniques.push_back(permutations[pick(random) % permutations.size()]);
+		return stream;
+	}
+
+	std::pair<uint32_t, uint32_t> Remap(const DrawStream& a_stream, const DrawStream::Technique& a_technique)
+	{
+		return DrawPath::Remap(static_cast<ShaderType>(a_technique.type), a_technique.vertexDescriptor, a_technique.pixelDescriptor, { a_technique.deferred != 0, a_stream.improvedSnow });
+	}
+
+	void TestSaveLoad(const DrawStream& a_stream)
+	{
+		const auto path = std::filesystem::temp_directory_path() / "DrawPathBenchmark.bin";
+
+		CHECK(a_stream.Save(path));
+		DrawStream loaded;
+		CHECK(loaded.Load(path));
+		CHECK(loaded.improvedSnow == a_stream.improvedSnow);
+		CHECK(loaded.remaps.size() == a_stream.remaps.size());
+		CHECK(!std::memcmp(loaded.remaps.data(), a_stream.remaps.data(), a_stream.remaps.size() * sizeof(DescriptorRemap)));
+		CHECK(loaded.techniques == a_stream.techniques);
+
+		// a truncated file is rejected
+		std::filesystem::resize_file(path, std::filesystem::file_size(path) - 4);
+		CHECK(!loaded.Load(path));
+		CHECK(loaded.techniques.empty());
+
+		// so is a technique whose type has no remap
+		DrawStream unknown;
+		unknown.remaps.resize(1);
+		unknown.techniques.push_back({ 1, 0, 0, 0 });
+		CHECK(unknown.Save(path));
+		CHECK(!loaded.Load(path));
+
+		std::filesystem::remove(path);
+		CHECK(!loaded.Load(path));
+	}
+
+	void TestFind()
+	{
+		Lookup lookup;
+		lookup.InsertOrAssign(1, std::make_unique<Shader>(1), [](Shader&) {});
+
+		// hits record once, misses every time and are queued unless already queued at that priority or better
+		auto found = DrawPath::Find(lookup, 1, CompilationPriority::OnDemand, true);
+		CHECK(found.shader && found.record && !found.queue);
+		found = DrawPath::Find(lookup, 1, CompilationPriority::OnDemand, true);
+		CHECK(found.shader && !found.record);
+		found = DrawPath::Find(lookup, 2, CompilationPriority::Predicted, false);
+		CHECK(!found.shader && !found.record && found.queue);
+
+		lookup.SetMark(2, DrawPath::QueuedMark(CompilationPriority::Predicted));
+		CHECK(!DrawPath::Find(lookup, 2, CompilationPriority::Background, true).queue);
+		CHECK(!DrawPath::Find(lookup, 2, CompilationPriority::Predicted, true).queue);
+		CHECK(DrawPath::Find(lookup, 2, CompilationPriority::OnDemand, true).queue);
+		lookup.SetMark(2, DrawPath::FailedMark);
+		CHECK(!DrawPath::Find(lookup, 2, CompilationPriority::OnDemand, true).queue);
+	}
+
+	void TestFallback()
+	{
+		using Flags = SIE::LightingShaderFlags;
+		const auto flags = DrawPath::GetFallbackFlags(ShaderType::Lighting);
+		const auto snow = static_cast<uint32_t>(Flags::Snow);
+		const auto projectedUV = static_cast<uint32_t>(Flags::ProjectedUV);
+		const auto release = [](Shader&) {};
+		Lookup vertexShaders, pixelShaders;
+		vertexShaders.InsertOrAssign(0, std::make_unique<Shader>(0), release);
+		pixelShaders.InsertOrAssign(0, std::make_unique<Shader>(0), release);
+		pixelShaders.InsertOrAssign(projectedUV, std::make_unique<Shader>(projectedUV), release);
+		vertexShaders.InsertOrAssign(projectedUV, std::make_unique<Shader>(projectedUV), release);
+
+		int queued = 0;
+		const auto queue = [&](bool a_vertexMissing, bool a_pixelMissing) { queued += a_vertexMissing + a_pixelMissing; };
+		uint32_t vertexDescriptor = projectedUV;
+		uint32_t pixelDescriptor = projectedUV | snow;
+
+		// a missing permutation that is not queued, e.g. a failed one, keeps the vanilla shader
+		CHECK(DrawPath::FindFallback(vertexShaders, pixelShaders, flags, vertexDescriptor, pixelDescriptor, false, queue) == DrawPath::Fallback::NotNeeded);
+		CHECK(queued == 1 && pixelDescriptor == (projectedUV | snow));
+
+		// a queued one drops the fewest flags, here only snow
+		pixelShaders.SetMark(projectedUV | snow, DrawPath::QueuedMark(CompilationPriority::OnDemand));
+		CHECK(DrawPath::FindFallback(vertexShaders, pixelShaders, flags, vertexDescriptor, pixelDescriptor, false, queue) == DrawPath::Fallback::Substituted);
+		CHECK(vertexDescriptor == projectedUV && pixelDescriptor == projectedUV);
+		CHECK(DrawPath::FindFallback(vertexShaders, pixelShaders, flags, vertexDescriptor, pixelDescriptor, false, queue) == DrawPath::Fallback::NotNeeded);
+
+		// without a compiled stand-in the technique keeps its descriptors
+		uint32_t aniso = static_cast<uint32_t>(Flags::AnisoLighting) | 1;
+		vertexDescriptor = 0;
+		pixelShaders.SetMark(aniso, DrawPath::QueuedMark(CompilationPriority::OnDemand));
+		CHECK(DrawPath::FindFallback(vertexShaders, pixelShaders, flags, vertexDescriptor, aniso, false, queue) == DrawPath::Fallback::NotFound);
+		CHECK(aniso == (static_cast<uint32_t>(Flags::AnisoLighting) | 1));
+
+		DrawPath::PermutationState permutation;
+		CHECK(permutation.Update(1, 2, 3));
+		CHECK(!permutation.Update(4, 2, 3));  // vertex descriptor changes alone do not upload
+		CHECK(permutation.Update(4, 5, 3));
+		CHECK(permutation.Update(4, 5, 6));
+		permutation.forceUpdate = true;
+		CHECK(permutation.Update(4, 5, 6));
+	}
+
+	void Run(const DrawStream& a_stream, uint32_t a_repeats, bool a_expectFallbacks)
+	{
+		const auto& techniques = a_stream.techniques;
+		const uint64_t iterations = static_cast<uint64_t>(a_repeats) * techniques.size();
+
+		// the lookups are filled with every permutation of the stream, like a warm cache, except that
+		// one in eight pixel permutations with optional flags is still compiling and has a stand-in
+		std::array<Lookup, TypeCount> vertexShaders;
+		std::array<Lookup, TypeCount> pixelShaders;
+		const auto release = [](Shader&) {};
+		const auto add = [&](Lookup& a_lookup, uint32_t a_descriptor) {
+			if (!a_lookup.Find(a_descriptor))
+				a_lookup.InsertOrAssign(a_descriptor, std::make_unique<Shader>(a_descriptor), release);
+		};
+		size_t compiling = 0;
+		std::vector<std::pair<uint32_t, uint32_t>> remapped;
+		remapped.reserve(techniques.size());
+		for (const auto& technique : techniques) {
+			const auto [vertexDescriptor, pixelDescriptor] = remapped.emplace_back(Remap(a_stream, technique));
+			add(vertexShaders[technique.type], vertexDescriptor);
+			const uint32_t optional = pixelDescriptor & DrawPath::GetFallbackFlags(static_cast<ShaderType>(technique.type)).pixel;
+			if (optional && (pixelDescriptor * 0x9E3779B9u) >> 29 == 0) {
+				if (pixelShaders[technique.type].GetMark(pixelDescriptor) == DrawPath::NotPendingMark && !pixelShaders[technique.type].Find(pixelDescriptor)) {
+					pixelShaders[technique.type].SetMark(pixelDescriptor, DrawPath::QueuedMark(CompilationPriority::OnDemand));
+					compiling++;
+				}
+				add(pixelShaders[technique.type], pixelDescriptor & ~optional);
+			} else
+				add(pixelShaders[technique.type], pixelDescriptor);
+		}
+
+		size_t permutations = 0;
+		for (uint32_t type = 0; type < TypeCount; type++)
+			permutations += vertexShaders[type].Size() + pixelShaders[type].Size();
+		std::printf("%zu techniques, %zu permutations after remapping, %zu still compiling\n", techniques.size(), permutations, compiling);
+
+		Test::Measure("DrawPath::Remap", iterations, [&](uint64_t i) {
+			Test::DoNotOptimize(Remap(a_stream, techniques[i % techniques.size()]).first);
+		});
+		Test::Measure("DrawPath::Find vertex + pixel", iterations, [&](uint64_t i) {
+			const auto type = techniques[i % techniques.size()].type;
+			const auto [vertexDescriptor, pixelDescriptor] = remapped[i % techniques.size()];
+			Test::DoNotOptimize(DrawPath::Find(vertexShaders[type], vertexDescriptor, CompilationPriority::OnDemand, true).shader);
+			Test::DoNotOptimize(DrawPath::Find(pixelShaders[type], pixelDescriptor, CompilationPriority::OnDemand, true).shader);
+		});
+
+		// the same work per technique as the BeginTechnique hook and State::Draw, minus what needs the game
+		uint64_t misses = 0;
+		uint64_t fallbacks = 0;
+		uint64_t uploads = 0;
+		DrawPath::PermutationState permutation;
+		const auto time = Util::ReplayStream(std::span(techniques), a_repeats, [&](const DrawStream::Technique& a_technique) {
+			auto [vertexDescriptor, pixelDescriptor] = Remap(a_stream, a_technique);
+			auto& vertexLookup = vertexShaders[a_technique.type];
+			auto& pixelLookup = pixelShaders[a_technique.type];
+			const auto fallback = DrawPath::FindFallback(vertexLookup, pixelLookup, DrawPath::GetFallbackFlags(static_cast<ShaderType>(a_technique.type)),
+				vertexDescriptor, pixelDescriptor, false, [](bool, bool) {});
+			fallbacks += fallback == DrawPath::Fallback::Substituted;
+			const auto vertexShader = DrawPath::Find(vertexLookup, vertexDescriptor, CompilationPriority::OnDemand, true).shader;
+			const auto pixelShader = DrawPath::Find(pixelLookup, pixelDescriptor, CompilationPriority::OnDemand, true).shader;
+			misses += !vertexShader || vertexShader->descriptor != vertexDescriptor;
+			misses += !pixelShader || pixelShader->descriptor != pixelDescriptor;
+			uploads += permutation.Update(a_technique.vertexDescriptor, a_technique.pixelDescriptor, 0);
+		});
+		const double perTechnique = iterations ? static_cast<double>(time.count()) / static_cast<double>(iterations) : 0.0;
+		std::printf("%-40s %12llu calls %10.2f ns/call\n", "Replay", static_cast<unsigned long long>(iterations), perTechnique);
+		std::printf("%llu fallbacks, %llu permutation buffer uploads\n", static_cast<unsigned long long>(fallbacks), static_cast<unsigned long long>(uploads));
+		CHECK(misses == 0);
+		CHECK(!a_expectFallbacks || fallbacks > 0);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	bool quick = false;
+	std::optional<std::filesystem::path> streamPath;
+	for (int i = 1; i < argc; i++) {
+		if (std::string_view(argv[i]) == "--quick")
+			quick = true;
+		else
+			streamPath = argv[i];
+	}
+
+	const auto synthetic = MakeSyntheticStream(8192, 7);
+	TestSaveLoad(synthetic);
+	TestFind();
+	TestFallback();
+
+	// the remap rules can only collapse permutations
+	std::set<std::pair<uint32_t, uint32_t>> before, after;
+	for (const auto& technique : synthetic.techniques) {
+		before.emplace(technique.vertexDescriptor, technique.pixelDescriptor);
+		after.emplace(Remap(synthetic, technique));
+	}
+	CHECK(after.size() <= before.size());
+
+	DrawStream stream;
+	if (streamPath) {
+		if (!stream.Load(*streamPath)) {
+			std::fprintf(stderr, "DrawPathBenchmark: cannot load draw stream %s\n", streamPath->string().c_str());
+			return 1;
+		}
+		if (stream.remaps.size() != DrawPath::Remaps.size()) {
+			std::fprintf(stderr, "DrawPathBenchmark: the stream has %zu shader types, expected %zu\n", stream.remaps.size(), DrawPath::Remaps.size());
+			return 1;
+		}
+		if (std::memcmp(stream.remaps.data(), DrawPath::Remaps.data(), sizeof(DrawPath::Remaps)))
+			std::printf("The stream was recorded with a different remap table, timing the current one\n");
+	} else
+		stream = synthetic;
+
+	CHECK(!stream.techniques.empty());
+	if (!stream.techniques.empty())
+		Run(stream, quick ? 1 : 2000, !streamPath);
+
+	return Test::Finish("DrawPathBenchmark");
+}
@@ -0,0 +1,235 @@
+#include "Check.h"
+
+#include "FeatureBuffer.h"
+
+namespace
+{
+	uint64_t allocations = 0;
+}
+
+// counts every heap allocation, so the paths are compared on what they actually allocate
+void* operator new(size_t a_size)
+{
+	allocations++;
+	if (void* pointer = std::malloc(a_size ? a_size : 1))
+		return pointer;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* a_pointer) noexcept { std::free(a_pointer); }
+void operator delete(void* a_pointer, size_t) noexcept { std::free(a_pointer); }
+
+namespace
+{
+	// stand-ins shaped like the feature buffer slices: stable settings and per-frame data with padding
+	struct alignas(16) Settings
+	{
+		float values[12];
+	};
+
+	struct alignas(16) Shadows
+	{
+		bool enabled;  // followed by three bytes of padding
+		float scale[3];
+		float zRange[2];
+		float offset[2];
+	};
+
+	struct alignas(16) Weather
+	{
+		float occlusion[16];
+		float time;
+		bool raining;  // followed by padding up to the alignment
+	};
+
+	using Buffer = PackedBuffer<Settings, Shadows, Weather>;
+
+	struct Frame
+	{
+		float time;
+		bool raining;
+	};
+
+	/**
+	 * Builds a slice the way a getter returning it by value does: members are assigned
+	 * over whatever the storage held, so its padding bytes are left undefined. a_fill
+	 * stands in for the stale bytes, which differ from frame to frame.
+	 */
+	template <class T>
+	T Garbage(uint8_t a_fill)
+	{
+		T value;
+		std::memset(&value, a_fill, sizeof(T));
+		return value;
+	}
+
+	void WriteShadows(Shadows& a_data)
+	{
+		a_data.enabled = true;
+		a_data.scale[0] = a_data.scale[1] = a_data.scale[2] = 1.0f / 4096.0f;
+		a_data.zRange[0] = -2048.0f;
+		a_data.zRange[1] = 8192.0f;
+		a_data.offset[0] = a_data.offset[1] = 0.5f;
+	}
+
+	void WriteWeather(Weather& a_data, const Frame& a_frame)
+	{
+		for (int i = 0; i < 16; i++)
+			a_data.occlusion[i] = i % 5 ? 0.0f : 1.0f;
+		a_data.time = a_frame.time;
+		a_data.raining = a_frame.raining;
+	}
+
+	/**
+	 * The path before PackedBuffer: every frame allocates the whole buffer, copies each
+	 * feature's slice into it and uploads it.
+	 */
+	struct PerFrameCopy
+	{
+		uint8_t fill = 1;
+
+		size_t operator()(const Settings& a_settings, const Frame& a_frame)
+		{
+			auto shadows = Garbage<Shadows>(fill++);
+			WriteShadows(shadows);
+			auto weather = Garbage<Weather>(fill++);
+			WriteWeather(weather, a_frame);
+
+			auto data = new unsigned char[Buffer::Size];
+			std::memcpy(data + Buffer::Offsets[0], &a_settings, sizeof(Settings));
+			std::memcpy(data + Buffer::Offsets[1], &shadows, sizeof(Shadows));
+			std::memcpy(data + Buffer::Offsets[2], &weather, sizeof(Weather));
+			Test::DoNotOptimize(data[Buffer::Size - 1]);
+			delete[] data;
+			return Buffer::Size;
+		}
+	};
+
+	/**
+	 * Sets slices built by value, as FeatureBuffer::Pack did before it staged them:
+	 * differing padding bytes look like a change.
+	 */
+	struct SetByValue
+	{
+		uint8_t fill = 1;
+		Buffer buffer;
+
+		size_t operator()(const Settings& a_settings, const Frame& a_frame)
+		{
+			auto shadows = Garbage<Shadows>(fill++);
+			WriteShadows(shadows);
+			auto weather = Garbage<Weather>(fill++);
+			WriteWeather(weather, a_frame);
+
+			buffer.Set<0>(a_settings);
+			buffer.Set<1>(shadows);
+			buffer.Set<2>(weather);
+			return buffer.TakeDirty() ? Buffer::Size : 0;
+		}
+	};
+
+	/**
+	 * FeatureBuffer::Pack: per-frame slices are written into zeroed staging slices.
+	 */
+	struct StageAndCommit
+	{
+		Buffer buffer;
+
+		size_t operator()(const Settings& a_settings, const Frame& a_frame)
+		{
+			buffer.Set<0>(a_settings);
+			WriteShadows(buffer.Stage<1>());
+			WriteWeather(buffer.Stage<2>(), a_frame);
+			buffer.Commit<1>();
+			buffer.Commit<2>();
+			return buffer.TakeDirty() ? Buffer::Size : 0;
+		}
+	};
+
+	struct Totals
+	{
+		uint64_t allocations = 0;
+		uint64_t bytesUploaded = 0;
+	};
+
+	/**
+	 * @brief Packs every frame with a fresh instance of a path, prints and returns the totals.
+	 */
+	template <class Path>
+	Totals Run(const char* a_name, std::span<const Frame> a_frames, const Settings& a_settings)
+	{
+		Path path;
+		Totals totals;
+		const uint64_t before = allocations;
+		Test::Measure(a_name, a_frames.size(), [&](uint64_t i) { totals.bytesUploaded += path(a_settings, a_frames[i]); });
+		totals.allocations = allocations - before;
+
+		const double frames = static_cast<double>(a_frames.size());
+		std::printf("%-40s %12.2f allocations/frame %8.1f bytes uploaded/frame\n", a_name,
+			static_cast<double>(totals.allocations) / frames, static_cast<double>(totals.bytesUploaded) / frames);
+		return totals;
+	}
+
+	void TestStage()
+	{
+		Buffer buffer;
+		CHECK(buffer.TakeDirty() == 0b111);
+
+		// staged slices start zeroed, so only the members written count
+		auto& shadows = buffer.Stage<1>();
+		CHECK(!shadows.enabled && shadows.scale[0] == 0.0f);
+		WriteShadows(shadows);
+		CHECK(buffer.Commit<1>());
+		CHECK(buffer.TakeDirty() == 0b010);
+
+		for (uint8_t fill = 1; fill <= 8; fill++) {
+			std::memset(&buffer.Stage<1>(), 0xCD, sizeof(Shadows));  // stale staging bytes are cleared by Stage()
+			WriteShadows(buffer.Stage<1>());
+			CHECK(!buffer.Commit<1>());
+
+			// the same values with garbage padding compare as changed through Set()
+			auto garbage = Garbage<Shadows>(fill);
+			WriteShadows(garbage);
+			CHECK(buffer.Set<1>(garbage));
+			WriteShadows(buffer.Stage<1>());
+			CHECK(buffer.Commit<1>());
+		}
+		buffer.TakeDirty();
+
+		const Frame frame{ 1.0f, true };
+		WriteWeather(buffer.Stage<2>(), frame);
+		CHECK(buffer.Commit<2>());
+		WriteWeather(buffer.Stage<2>(), { 2.0f, true });
+		CHECK(buffer.Commit<2>());
+		CHECK(buffer.TakeDirty() == 0b100);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const bool quick = argc > 1 && std::string_view(argv[1]) == "--quick";
+	const size_t frameCount = quick ? 10'000 : 10'000'000;
+
+	TestStage();
+
+	// the weather slice changes on one frame in eight, the rest of the buffer stays put
+	std::vector<Frame> frames(frameCount);
+	for (size_t i = 0; i < frameCount; i++)
+		frames[i] = { static_cast<float>(i / 8), (i / 512) % 2 == 0 };
+	Settings settings{};
+	for (int i = 0; i < 12; i++)
+		settings.values[i] = static_cast<float>(i);
+
+	const auto perFrameCopy = Run<PerFrameCopy>("per-frame copy", frames, settings);
+	const auto set = Run<SetByValue>("Set, padding uninitialised", frames, settings);
+	const auto stage = Run<StageAndCommit>("Stage/Commit", frames, settings);
+
+	CHECK(perFrameCopy.allocations == frameCount);
+	CHECK(perFrameCopy.bytesUploaded == frameCount * Buffer::Size);
+	CHECK(set.allocations == 0 && stage.allocations == 0);
+	// the first frame uploads everything, then only the frames where the weather changed
+	CHECK(stage.bytesUploaded == (frameCount + 7) / 8 * Buffer::Size);
+	CHECK(stage.bytesUploaded < set.bytesUploaded);
+
+	return Test::Finish("PackedBufferBenchmark");
+}
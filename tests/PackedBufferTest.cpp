@@ -0,0 +1,81 @@
+#include "Check.h"
+
+#include "FeatureBuffer.h"
+
+namespace
+{
+	struct alignas(16) A
+	{
+		float values[4];
+	};
+
+	struct alignas(16) B
+	{
+		uint32_t flags;
+		float scale;
+		float pad[2];
+	};
+
+	struct alignas(16) C
+	{
+		float matrix[16];
+	};
+
+	using Buffer = PackedBuffer<A, B, C>;
+
+	static_assert(Buffer::Count == 3);
+	static_assert(Buffer::Size == sizeof(A) + sizeof(B) + sizeof(C));
+	static_assert(Buffer::Offsets[0] == 0);
+	static_assert(Buffer::Offsets[1] == sizeof(A));
+	static_assert(Buffer::Offsets[2] == sizeof(A) + sizeof(B));
+	static_assert(std::is_same_v<Buffer::Slice<1>, B>);
+
+	template <class T>
+	T Read(const Buffer& a_buffer, size_t a_offset)
+	{
+		T value;
+		std::memcpy(&value, a_buffer.Data() + a_offset, sizeof(T));
+		return value;
+	}
+}
+
+int main()
+{
+	Buffer buffer;
+	CHECK(reinterpret_cast<uintptr_t>(buffer.Data()) % 16 == 0);
+
+	// everything is uploaded once, even if the slices are still zero
+	CHECK(buffer.TakeDirty() == 0b111);
+	CHECK(buffer.TakeDirty() == 0);
+
+	const A a{ { 1.0f, 2.0f, 3.0f, 4.0f } };
+	const B b{ 7, 0.5f, {} };
+	CHECK(buffer.Set<0>(a));
+	CHECK(buffer.Set<1>(b));
+	CHECK(buffer.TakeDirty() == 0b011);
+	CHECK(Read<A>(buffer, Buffer::Offsets[0]).values[3] == 4.0f);
+	CHECK(Read<B>(buffer, Buffer::Offsets[1]).flags == 7);
+
+	// unchanged slices are neither repacked nor marked dirty
+	CHECK(!buffer.Set<0>(a));
+	CHECK(!buffer.Set<1>(b));
+	CHECK(!buffer.Set<2>(C{}));
+	CHECK(buffer.TakeDirty() == 0);
+
+	B changed = b;
+	changed.scale = 2.0f;
+	CHECK(buffer.Set<1>(changed));
+	CHECK(!buffer.Set<1>(changed));
+	C c{};
+	c.matrix[15] = 1.0f;
+	CHECK(buffer.Set<2>(c));
+	CHECK(buffer.TakeDirty() == 0b110);
+	CHECK(Read<B>(buffer, Buffer::Offsets[1]).scale == 2.0f);
+	CHECK(Read<C>(buffer, Buffer::Offsets[2]).matrix[15] == 1.0f);
+
+	// neighbouring slices are left untouched
+	CHECK(Read<A>(buffer, Buffer::Offsets[0]).values[0] == 1.0f);
+	CHECK(Read<B>(buffer, Buffer::Offsets[1]).flags == 7);
+
+	return Test::Finish("PackedBufferTest");
+}
@@ -0,0 +1,55 @@
+#include "Check.h"
+
+#include "ShaderCache/ReflectionMetadata.h"
+
+namespace
+{
+	using Metadata = SIE::ReflectionMetadata<64>;
+
+	Metadata MakeMetadata()
+	{
+		Metadata metadata;
+		metadata.bufferSizes = { 16, 0, 48 };
+		metadata.vertexDesc = 0x0123456789ABCDEFull;
+		for (size_t i = 0; i < metadata.constantOffsets.size(); i++)
+			metadata.constantOffsets[i] = static_cast<int8_t>(i % 3 == 0 ? -1 : i);
+		return metadata;
+	}
+}
+
+int main()
+{
+	const auto original = MakeMetadata();
+	const auto data = original.Serialize();
+	CHECK(data.size() == sizeof(Metadata::Header) + 64);
+
+	Metadata loaded;
+	CHECK(loaded.Deserialize(data));
+	CHECK(loaded.bufferSizes == original.bufferSizes);
+	CHECK(loaded.constantOffsets == original.constantOffsets);
+	CHECK(loaded.vertexDesc == original.vertexDesc);
+	CHECK(loaded.Serialize() == data);
+
+	// records of another table size or version are rejected and leave the target untouched
+	Metadata untouched = MakeMetadata();
+	CHECK(!untouched.Deserialize(SIE::ReflectionMetadata<32>{}.Serialize()));
+	CHECK(untouched.constantOffsets == original.constantOffsets);
+
+	auto wrongVersion = data;
+	Metadata::Header header;
+	std::memcpy(&header, wrongVersion.data(), sizeof(header));
+	header.version = Metadata::Version + 1;
+	std::memcpy(wrongVersion.data(), &header, sizeof(header));
+	CHECK(!Metadata{}.Deserialize(wrongVersion));
+
+	auto mislabeled = data;
+	header.version = Metadata::Version;
+	header.tableSize = 65;
+	std::memcpy(mislabeled.data(), &header, sizeof(header));
+	CHECK(!Metadata{}.Deserialize(mislabeled));
+
+	CHECK(!Metadata{}.Deserialize(std::span(data).first(data.size() - 1)));
+	CHECK(!Metadata{}.Deserialize({}));
+
+	return Test::Finish("ReflectionMetadataTest");
+}
@@ -0,0 +1,179 @@
+#include "Check.h"
+
+#include "ShaderCache/ContentKey.h"
+#include "ShaderCache/ReflectionMetadata.h"
+#include "ShaderCache/ShaderArchive.h"
+
+#include <d3d11shader.h>
+#include <d3dcompiler.h>
+#include <winrt/base.h>
+
+using SIE::ShaderArchive;
+
+namespace
+{
+	using Metadata = SIE::ReflectionMetadata<64>;
+
+	// a vertex shader with the constant buffers and inputs ReflectConstantBuffers walks
+	constexpr std::string_view Source = R"(
+cbuffer PerTechnique : register(b0)
+{
+	float4 FogParam;
+	float4 FogNearColor;
+	float4 FogFarColor;
+	float2 EyePosition;
+};
+
+cbuffer PerMaterial : register(b1)
+{
+	float4 TexcoordOffset;
+	float4 LeftEyeCenter;
+	float4 RightEyeCenter;
+	float4 MaterialData;
+};
+
+cbuffer PerGeometry : register(b2)
+{
+	row_major float3x4 World;
+	row_major float3x4 PreviousWorld;
+	float4 HighDetailRange;
+	float4 Bones[16];
+	float3 EyeNormal;
+	float WindTimer;
+};
+
+struct VS_INPUT
+{
+	float4 Position : POSITION0;
+	float2 TexCoord : TEXCOORD0;
+	float4 Normal : NORMAL0;
+	float4 Bitangent : BINORMAL0;
+	float4 Color : COLOR0;
+};
+
+float4 main(VS_INPUT input) : SV_POSITION
+{
+	float3 position = mul(World, input.Position) + mul(PreviousWorld, input.Position) * WindTimer;
+	position += Bones[(uint)input.Color.x].xyz * HighDetailRange.x + EyeNormal * FogParam.x;
+	position += (FogNearColor.xyz + FogFarColor.xyz + LeftEyeCenter.xyz + RightEyeCenter.xyz) * MaterialData.x;
+	return float4(position + input.Normal.xyz + input.Bitangent.xyz, EyePosition.x) + TexcoordOffset * input.TexCoord.x;
+}
+)";
+
+	// stand-in for the per shader type variable tables of GetVariableIndex
+	const std::unordered_map<std::string_view, int32_t> VariableIndices{
+		{ "FogParam", 0 }, { "FogNearColor", 1 }, { "FogFarColor", 2 }, { "EyePosition", 3 },
+		{ "TexcoordOffset", 4 }, { "LeftEyeCenter", 5 }, { "RightEyeCenter", 6 }, { "MaterialData", 7 },
+		{ "World", 8 }, { "PreviousWorld", 9 }, { "HighDetailRange", 10 }, { "Bones", 11 },
+		{ "EyeNormal", 12 }, { "WindTimer", 13 },
+	};
+
+	/**
+	 * The runtime path of GetConstantBufferLayout: D3DReflect and the walk ReflectConstantBuffers
+	 * does over the inputs and the three constant buffers.
+	 */
+	bool Reflect(std::span<const uint8_t> a_bytecode, Metadata& a_metadata)
+	{
+		winrt::com_ptr<ID3D11ShaderReflection> reflector;
+		if (FAILED(D3DReflect(a_bytecode.data(), a_bytecode.size(), __uuidof(ID3D11ShaderReflection), reflector.put_void())))
+			return false;
+
+		D3D11_SHADER_DESC desc;
+		if (FAILED(reflector->GetDesc(&desc)))
+			return false;
+
+		a_metadata.vertexDesc = 0;
+		for (uint32_t i = 0; i < desc.InputParameters; i++) {
+			D3D11_SIGNATURE_PARAMETER_DESC inputDesc;
+			// stand-in for the semantic to vertex attribute mapping
+			if (SUCCEEDED(reflector->GetInputParameterDesc(i, &inputDesc)))
+				a_metadata.vertexDesc |= 1ull << (std::hash<std::string_view>{}(inputDesc.SemanticName) % 64);
+		}
+
+		a_metadata.constantOffsets.fill(-1);
+		constexpr std::array<const char*, 3> buffers{ "PerTechnique", "PerMaterial", "PerGeometry" };
+		for (size_t buffer = 0; buffer < buffers.size(); buffer++) {
+			auto bufferReflector = reflector->GetConstantBufferByName(buffers[buffer]);
+			D3D11_SHADER_BUFFER_DESC bufferDesc;
+			if (!bufferReflector || FAILED(bufferReflector->GetDesc(&bufferDesc)))
+				continue;
+			for (uint32_t i = 0; i < bufferDesc.Variables; i++) {
+				D3D11_SHADER_VARIABLE_DESC variableDesc;
+				if (FAILED(bufferReflector->GetVariableByIndex(i)->GetDesc(&variableDesc)))
+					continue;
+				if (auto it = VariableIndices.find(variableDesc.Name); it != VariableIndices.end())
+					a_metadata.constantOffsets[it->second] = static_cast<int8_t>(variableDesc.StartOffset / 4);
+			}
+			a_metadata.bufferSizes[buffer] = ((bufferDesc.Size + 15) & ~15) / 16;
+		}
+		return true;
+	}
+
+	uint64_t MetadataKey(std::span<const uint8_t> a_bytecode)
+	{
+		const uint64_t seed = SIE::ContentKey::HashCombine(SHADER_CACHE_FORMAT, "reflection:benchmark:Lighting:Vertex");
+		return SIE::ContentKey::HashCombine(seed, { reinterpret_cast<const char*>(a_bytecode.data()), a_bytecode.size() });
+	}
+
+	/**
+	 * The warm path of GetConstantBufferLayout: hash the bytecode, find the record in the archive
+	 * and deserialize it.
+	 */
+	bool Load(const ShaderArchive& a_archive, std::span<const uint8_t> a_bytecode, Metadata& a_metadata)
+	{
+		auto stored = a_archive.Find(MetadataKey(a_bytecode));
+		return stored && a_metadata.Deserialize(stored.data);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const bool quick = argc > 1 && std::string_view(argv[1]) == "--quick";
+	const uint64_t iterations = quick ? 1'000 : 200'000;
+
+	winrt::com_ptr<ID3DBlob> blob;
+	winrt::com_ptr<ID3DBlob> errors;
+	const HRESULT compiled = D3DCompile(Source.data(), Source.size(), "benchmark.hlsl", nullptr, nullptr, "main", "vs_5_0",
+		D3DCOMPILE_OPTIMIZATION_LEVEL3, 0, blob.put(), errors.put());
+	if (FAILED(compiled)) {
+		std::printf("%s\n", errors ? static_cast<const char*>(errors->GetBufferPointer()) : "D3DCompile failed");
+		return 1;
+	}
+	const std::span<const uint8_t> bytecode(static_cast<const uint8_t*>(blob->GetBufferPointer()), blob->GetBufferSize());
+
+	Metadata reflected;
+	CHECK(Reflect(bytecode, reflected));
+	CHECK(reflected.bufferSizes[2] > 0);
+	CHECK(reflected.constantOffsets[13] >= 0);
+
+	const auto dir = std::filesystem::temp_directory_path() / "cs-tests-reflection-warm-start";
+	std::filesystem::remove_all(dir);
+	std::filesystem::create_directories(dir);
+	{
+		ShaderArchive archive(dir / "Lighting.pak");
+		CHECK(archive.Open());
+		CHECK(archive.Append(MetadataKey(bytecode), reflected.Serialize()));
+		CHECK(archive.Compact());
+
+		Metadata loaded;
+		CHECK(Load(archive, bytecode, loaded));
+		CHECK(loaded.bufferSizes == reflected.bufferSizes);
+		CHECK(loaded.constantOffsets == reflected.constantOffsets);
+		CHECK(loaded.vertexDesc == reflected.vertexDesc);
+
+		Metadata metadata;
+		const double runtime = Test::Measure("D3DReflect + walk", iterations, [&](uint64_t) {
+			Reflect(bytecode, metadata);
+			Test::DoNotOptimize(metadata.bufferSizes[0]);
+		});
+		const double cached = Test::Measure("archive Find + Deserialize", iterations, [&](uint64_t) {
+			Load(archive, bytecode, metadata);
+			Test::DoNotOptimize(metadata.bufferSizes[0]);
+		});
+		std::printf("cached layouts are %.1fx faster than runtime reflection\n", cached > 0.0 ? runtime / cached : 0.0);
+	}
+
+	std::error_code ec;
+	std::filesystem::remove_all(dir, ec);
+	return Test::Finish("ReflectionWarmStartBenchmark");
+}
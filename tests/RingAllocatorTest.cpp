@@ -0,0 +1,54 @@
+#include "Check.h"
+
+#include "Utils/RingAllocator.h"
+
+int main()
+{
+	Util::RingAllocator ring(1024, 256);
+	CHECK(ring.GetCapacity() == 1024);
+
+	// the first allocation wraps, so a fresh buffer is discarded before it is used
+	auto first = ring.Allocate(100);
+	CHECK(first && first->offset == 0 && first->size == 256 && first->wrapped);
+
+	// sizes are rounded up to the alignment, zero-sized ranges still take one unit
+	auto second = ring.Allocate(256);
+	CHECK(second && second->offset == 256 && second->size == 256 && !second->wrapped);
+	auto third = ring.Allocate(0);
+	CHECK(third && third->offset == 512 && third->size == 256 && !third->wrapped);
+
+	// an exact fit at the end does not wrap
+	auto fourth = ring.Allocate(200);
+	CHECK(fourth && fourth->offset == 768 && !fourth->wrapped);
+
+	// the next range no longer fits and starts over at offset 0
+	auto fifth = ring.Allocate(300);
+	CHECK(fifth && fifth->offset == 0 && fifth->size == 512 && fifth->wrapped);
+
+	// a range that does not fit behind the head wraps even if space is left
+	auto sixth = ring.Allocate(600);
+	CHECK(sixth && sixth->offset == 0 && sixth->size == 768 && sixth->wrapped);
+
+	// ranges larger than the ring fail without changing the state
+	CHECK(!ring.Allocate(1025));
+	CHECK(!ring.Allocate(SIZE_MAX / 2));
+	auto seventh = ring.Allocate(256);
+	CHECK(seventh && seventh->offset == 768 && !seventh->wrapped);
+
+	// a range of the full capacity always wraps
+	auto full = ring.Allocate(1024);
+	CHECK(full && full->offset == 0 && full->size == 1024 && full->wrapped);
+
+	auto stats = ring.GetStats();
+	CHECK(stats.allocations == 8);
+	CHECK(stats.wraps == 4);
+	CHECK(stats.bytes == 256 * 4 + 512 + 768 + 256 + 1024);
+
+	// after a reset the next allocation wraps again
+	ring.Reset();
+	auto reset = ring.Allocate(16);
+	CHECK(reset && reset->offset == 0 && reset->wrapped);
+	CHECK(ring.GetStats().wraps == 5);
+
+	return Test::Finish("RingAllocatorTest");
+}
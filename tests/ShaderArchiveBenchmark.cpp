@@ -0,0 +1,100 @@
+#include "Check.h"
+
+#include "ShaderCache/ShaderArchive.h"
+
+using SIE::ShaderArchive;
+
+namespace
+{
+	/**
+	 * Blobs sized like compiled permutations; one in eight repeats an earlier blob, as permutations
+	 * whose defines do not change the output do.
+	 */
+	std::vector<std::vector<uint8_t>> MakeBlobs(size_t a_count)
+	{
+		std::mt19937 random(3);
+		std::vector<std::vector<uint8_t>> blobs;
+		blobs.reserve(a_count);
+		for (size_t i = 0; i < a_count; i++) {
+			if (i % 8 == 7) {
+				blobs.push_back(blobs[random() % blobs.size()]);
+				continue;
+			}
+			std::vector<uint8_t> blob(2048 + random() % (24 * 1024));
+			for (auto& byte : blob)
+				byte = static_cast<uint8_t>(random());
+			blobs.push_back(std::move(blob));
+		}
+		return blobs;
+	}
+
+	/**
+	 * The layout before archives: one file per permutation, read whole into memory on load.
+	 */
+	std::vector<uint8_t> ReadFile(const std::filesystem::path& a_path)
+	{
+		std::ifstream in(a_path, std::ios::binary | std::ios::ate);
+		std::vector<uint8_t> data(static_cast<size_t>(in.tellg()));
+		in.seekg(0);
+		in.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+		return data;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const bool quick = argc > 1 && std::string_view(argv[1]) == "--quick";
+	const size_t count = quick ? 200 : 4000;
+	const auto blobs = MakeBlobs(count);
+
+	const auto dir = std::filesystem::temp_directory_path() / "cs-tests-shader-archive-benchmark";
+	std::filesystem::remove_all(dir);
+	std::filesystem::create_directories(dir / "PerFile");
+
+	uint64_t perFileBytes = 0;
+	std::vector<ShaderArchive::Source> sources;
+	for (size_t i = 0; i < count; i++) {
+		std::ofstream(dir / "PerFile" / std::format("{:016X}.bin", i), std::ios::binary)
+			.write(reinterpret_cast<const char*>(blobs[i].data()), static_cast<std::streamsize>(blobs[i].size()));
+		perFileBytes += blobs[i].size();
+		sources.push_back({ i, blobs[i], 0 });
+	}
+	const auto archivePath = dir / "Lighting.pak";
+	const auto distinct = ShaderArchive::Write(archivePath, sources);
+	CHECK(distinct.has_value() && *distinct < count);
+	std::printf("%zu permutations: %llu KB as files, %llu KB as an archive of %zu distinct blobs\n", count,
+		static_cast<unsigned long long>(perFileBytes / 1024), static_cast<unsigned long long>(std::filesystem::file_size(archivePath) / 1024),
+		distinct.value_or(0));
+
+	// the files are read once first, so both layouts are compared on the OS file cache; the archive was just written
+	uint64_t expected = 0;
+	for (size_t i = 0; i < count; i++) {
+		const auto data = ReadFile(dir / "PerFile" / std::format("{:016X}.bin", i));
+		expected += data.size() + data[data.size() / 2];
+	}
+
+	uint64_t checksum = 0;
+	const double perFile = Test::Measure("per-file open + read", count, [&](uint64_t i) {
+		const auto data = ReadFile(dir / "PerFile" / std::format("{:016X}.bin", i));
+		checksum += data.size() + data[data.size() / 2];
+	});
+	CHECK(checksum == expected);
+
+	{
+		ShaderArchive archive(archivePath);
+		Test::Measure("archive Open", 1, [&](uint64_t) { CHECK(archive.Open()); });
+		CHECK(archive.GetEntryCount() == count);
+
+		checksum = 0;
+		const double archived = Test::Measure("archive Find", count, [&](uint64_t i) {
+			const auto blob = archive.Find(i);
+			checksum += blob.data.size() + blob.data[blob.data.size() / 2];
+		});
+		CHECK(checksum == expected);
+		std::printf("archive lookups are %.1fx faster than per-file reads\n", archived > 0.0 ? perFile / archived : 0.0);
+	}
+
+	std::error_code ec;
+	std::filesystem::remove_all(dir, ec);
+	return Test::Finish("ShaderArchiveBenchmark");
+}
@@ -0,0 +1,235 @@
+#include "Check.h"
+
+#include "ShaderCache/ShaderArchive.h"
+
+using SIE::ShaderArchive;
+
+namespace
+{
+	std::vector<uint8_t> MakeBlob(uint8_t a_seed, size_t a_size)
+	{
+		std::vector<uint8_t> blob(a_size);
+		for (size_t i = 0; i < a_size; i++)
+			blob[i] = static_cast<uint8_t>(a_seed + i * 7);
+		return blob;
+	}
+
+	bool Equals(const ShaderArchive::Blob& a_blob, const std::vector<uint8_t>& a_expected)
+	{
+		return a_blob && std::ranges::equal(a_blob.data, a_expected);
+	}
+
+	void AppendRaw(const std::filesystem::path& a_path, uint64_t a_key, uint32_t a_size, std::span<const uint8_t> a_data)
+	{
+		// mirrors ShaderArchive::JournalRecord
+		struct
+		{
+			uint64_t key;
+			uint32_t size;
+			uint32_t flags;
+			int64_t writeTime;
+		} record{ a_key, a_size, 0, 0 };
+		std::ofstream out(a_path, std::ios::binary | std::ios::app);
+		out.write(reinterpret_cast<const char*>(&record), sizeof(record));
+		out.write(reinterpret_cast<const char*>(a_data.data()), static_cast<std::streamsize>(a_data.size()));
+	}
+
+	ShaderArchive::Header ReadHeader(const std::filesystem::path& a_path)
+	{
+		ShaderArchive::Header header{};
+		std::ifstream in(a_path, std::ios::binary);
+		in.read(reinterpret_cast<char*>(&header), sizeof(header));
+		return header;
+	}
+
+	void TestRoundTrip(const std::filesystem::path& a_dir)
+	{
+		const auto path = a_dir / "RoundTrip.pak";
+		const auto first = MakeBlob(1, 100);
+		const auto second = MakeBlob(2, 37);
+		{
+			ShaderArchive archive(path);
+			CHECK(archive.Open());
+			CHECK(!archive.Find(1));
+			CHECK(archive.Append(1, first));
+			CHECK(archive.Append(2, second));
+			CHECK(archive.GetPendingCount() == 2);
+			CHECK(Equals(archive.Find(1), first));
+		}
+		{
+			// the journal is merged on open
+			ShaderArchive archive(path);
+			CHECK(archive.Open());
+			CHECK(archive.GetEntryCount() == 2);
+			CHECK(archive.GetPendingCount() == 0);
+			CHECK(Equals(archive.Find(1), first));
+			CHECK(Equals(archive.Find(2), second));
+			CHECK(archive.Erase(1));
+			CHECK(!archive.Find(1));
+			CHECK(!archive.Erase(3));
+		}
+		{
+			ShaderArchive archive(path);
+			CHECK(archive.Open());
+			CHECK(archive.GetEntryCount() == 1);
+			CHECK(!archive.Find(1));
+			CHECK(Equals(archive.Find(2), second));
+		}
+	}
+
+	void TestIdenticalBlobsShareStorage(const std::filesystem::path& a_dir)
+	{
+		const auto blob = MakeBlob(3, 64);
+		const auto other = MakeBlob(4, 64);
+		std::vector<ShaderArchive::Source> sources{
+			{ 3, blob, 0 },
+			{ 1, blob, 0 },
+			{ 2, other, 0 },
+		};
+		const auto written = ShaderArchive::Write(a_dir / "Shared.pak", sources);
+		CHECK(written == 2u);
+
+		ShaderArchive archive(a_dir / "Shared.pak");
+		CHECK(archive.Open());
+		CHECK(archive.GetEntryCount() == 3);
+		CHECK(Equals(archive.Find(1), blob));
+		CHECK(Equals(archive.Find(2), other));
+		CHECK(Equals(archive.Find(3), blob));
+	}
+
+	void TestCompactionWithBlobsInUse(const std::filesystem::path& a_dir)
+	{
+		const auto path = a_dir / "Pinned.pak";
+		auto retired = path;
+		retired += ".0.old";
+		const auto first = MakeBlob(5, 16);
+		const auto second = MakeBlob(6, 16);
+
+		ShaderArchive archive(path);
+		CHECK(archive.Open());
+		CHECK(archive.Append(1, first));
+		CHECK(archive.Compact());
+
+		// the mapped file is moved aside and stays readable through the blob
+		auto pinned = archive.Find(1);
+		CHECK(archive.Append(2, second));
+		CHECK(archive.Compact());
+		CHECK(archive.GetPendingCount() == 0);
+		CHECK(archive.GetEntryCount() == 2);
+		CHECK(std::filesystem::exists(retired));
+		CHECK(Equals(pinned, first));
+		CHECK(Equals(archive.Find(2), second));
+
+		// releasing the last blob deletes the old file
+		pinned = {};
+		CHECK(!std::filesystem::exists(retired));
+
+		// closing with no blobs alive releases the file
+		archive.Close();
+		std::error_code ec;
+		CHECK(std::filesystem::remove(path, ec));
+	}
+
+	void TestDeleteWithBlobsInUse(const std::filesystem::path& a_dir)
+	{
+		const auto path = a_dir / "Deleted.pak";
+		auto retired = path;
+		retired += ".0.old";
+		const auto blob = MakeBlob(12, 48);
+
+		ShaderArchive archive(path);
+		CHECK(archive.Open());
+		CHECK(archive.Append(1, blob));
+		CHECK(archive.Compact());
+
+		auto pinned = archive.Find(1);
+		CHECK(archive.Delete());
+		CHECK(!std::filesystem::exists(path));
+		CHECK(!archive.Find(1));
+		CHECK(Equals(pinned, blob));
+
+		pinned = {};
+		CHECK(!std::filesystem::exists(retired));
+
+		// leftovers of a session that ended with blobs in use are removed on open
+		std::ofstream(retired) << "stale";
+		CHECK(archive.Open());
+		CHECK(!std::filesystem::exists(retired));
+	}
+
+	void TestExpiry(const std::filesystem::path& a_dir)
+	{
+		const auto path = a_dir / "Expiry.pak";
+		const auto used = MakeBlob(9, 32);
+		const auto unused = MakeBlob(10, 32);
+		const auto fresh = MakeBlob(11, 32);
+
+		// last used in session 0, so both are past MaxAge once the session after MaxAge opens
+		std::vector<ShaderArchive::Source> sources{
+			{ 1, used, 0, 0 },
+			{ 2, unused, 0, 0 },
+		};
+		CHECK(ShaderArchive::Write(path, sources, ShaderArchive::MaxAge));
+		{
+			ShaderArchive archive(path);
+			CHECK(archive.Open());
+			CHECK(archive.GetSession() == ShaderArchive::MaxAge + 1);
+			CHECK(archive.GetEntryCount() == 2);
+			CHECK(Equals(archive.Find(1), used));
+			CHECK(archive.Append(3, fresh));
+			CHECK(archive.Compact());
+			CHECK(archive.GetEntryCount() == 2);
+			CHECK(!archive.Find(2));
+			CHECK((archive.TakeExpired() == std::vector<uint64_t>{ 2 }));
+			CHECK(archive.TakeExpired().empty());
+		}
+		{
+			// a found entry close to expiry is restamped even without new blobs
+			std::vector<ShaderArchive::Source> stale{ { 1, used, 0, 1 } };
+			CHECK(ShaderArchive::Write(path, stale, ShaderArchive::RefreshAge));
+			ShaderArchive archive(path);
+			CHECK(archive.Open());
+			CHECK(archive.Compact());
+			CHECK(ReadHeader(path).session == ShaderArchive::RefreshAge);
+			CHECK(Equals(archive.Find(1), used));
+			CHECK(archive.Compact());
+			CHECK(ReadHeader(path).session == ShaderArchive::RefreshAge + 1);
+		}
+	}
+
+	void TestCorruptJournal(const std::filesystem::path& a_dir)
+	{
+		const auto path = a_dir / "Corrupt.pak";
+		auto journal = path;
+		journal += ".log";
+
+		const auto valid = MakeBlob(7, 24);
+		AppendRaw(journal, 1, static_cast<uint32_t>(valid.size()), valid);
+		// a size far past the end of the journal must be rejected, not allocated
+		AppendRaw(journal, 2, 0xFFFFFFF0u, MakeBlob(8, 8));
+
+		ShaderArchive archive(path);
+		CHECK(archive.Open());
+		CHECK(Equals(archive.Find(1), valid));
+		CHECK(!archive.Find(2));
+		CHECK(archive.GetEntryCount() == 1);
+	}
+}
+
+int main()
+{
+	const auto dir = std::filesystem::temp_directory_path() / "cs-tests-shader-archive";
+	std::filesystem::remove_all(dir);
+	std::filesystem::create_directories(dir);
+
+	TestRoundTrip(dir);
+	TestIdenticalBlobsShareStorage(dir);
+	TestCompactionWithBlobsInUse(dir);
+	TestDeleteWithBlobsInUse(dir);
+	TestExpiry(dir);
+	TestCorruptJournal(dir);
+
+	std::error_code ec;
+	std::filesystem::remove_all(dir, ec);
+	return Test::Finish("ShaderArchiveTest");
+}
@@ -0,0 +1,276 @@
+#include "Check.h"
+
+#include "ShaderCache/ShaderLookup.h"
+
+namespace
+{
+	struct Shader
+	{
+		uint32_t descriptor;
+
+		// readers may still hold a shader the writer just dropped, so memory is only freed by Collect()
+		static void operator delete(void* a_pointer) { graveyard.push_back(a_pointer); }
+
+		static void Collect(size_t a_keep)
+		{
+			for (size_t i = 0; i < graveyard.size() - std::min(a_keep, graveyard.size()); i++)
+				::operator delete(graveyard[i]);
+			graveyard.erase(graveyard.begin(), graveyard.end() - std::min(a_keep, graveyard.size()));
+		}
+
+		static inline std::vector<void*> graveyard;
+	};
+
+	using Lookup = SIE::ShaderLookup<Shader>;
+
+	std::vector<uint32_t> MakeDescriptors(size_t a_count, uint32_t a_seed)
+	{
+		std::mt19937 random(a_seed);
+		std::unordered_set<uint32_t> unique;
+		while (unique.size() < a_count)
+			unique.insert(random());
+		return { unique.begin(), unique.end() };
+	}
+
+	void Fill(Lookup& a_lookup, std::span<const uint32_t> a_descriptors)
+	{
+		for (auto descriptor : a_descriptors)
+			a_lookup.InsertOrAssign(descriptor, std::make_unique<Shader>(descriptor), [](Shader&) {});
+	}
+
+	void TestRelease()
+	{
+		Lookup lookup;
+		std::vector<uint32_t> released;
+		const auto release = [&](Shader& a_shader) { released.push_back(a_shader.descriptor); };
+
+		auto* first = lookup.InsertOrAssign(1, std::make_unique<Shader>(1), release);
+		CHECK(lookup.Find(1) == first);
+		CHECK(released.empty());
+
+		// replacing a shader releases the old one
+		auto* second = lookup.InsertOrAssign(1, std::make_unique<Shader>(101), release);
+		CHECK(lookup.Find(1) == second);
+		CHECK((released == std::vector<uint32_t>{ 1 }));
+
+		lookup.InsertOrAssign(2, std::make_unique<Shader>(2), release);
+		CHECK(lookup.Erase(2, release));
+		CHECK(!lookup.Erase(2, release));
+		CHECK(!lookup.Find(2));
+		CHECK((released == std::vector<uint32_t>{ 1, 2 }));
+
+		lookup.Clear(release);
+		CHECK((released == std::vector<uint32_t>{ 1, 2, 101 }));
+		CHECK(lookup.Size() == 0);
+		CHECK(!lookup.Find(1));
+	}
+
+	void TestFirstHit(std::span<const uint32_t> a_descriptors)
+	{
+		Lookup lookup;
+		const auto release = [](Shader&) {};
+		bool firstHit = true;
+
+		CHECK(!lookup.Find(1, &firstHit));
+		CHECK(!firstHit);
+
+		lookup.InsertOrAssign(1, std::make_unique<Shader>(1), release);
+		CHECK(lookup.Find(1));  // lookups without the flag do not count as hits
+		CHECK(lookup.Find(1, &firstHit) && firstHit);
+		CHECK(lookup.Find(1, &firstHit) && !firstHit);
+
+		// a replaced shader gets its own first hit
+		lookup.InsertOrAssign(1, std::make_unique<Shader>(101), release);
+		CHECK(lookup.Find(1, &firstHit) && firstHit);
+
+		// flags survive the index rebuilds caused by growth
+		Fill(lookup, a_descriptors);
+		CHECK(lookup.Find(1, &firstHit) && !firstHit);
+		size_t first = 0;
+		for (auto descriptor : a_descriptors) {
+			lookup.Find(descriptor, &firstHit);
+			first += firstHit;
+			lookup.Find(descriptor, &firstHit);
+			first += firstHit;
+		}
+		CHECK(first == a_descriptors.size());
+
+		// cleared entries start over
+		lookup.Clear(release);
+		lookup.InsertOrAssign(1, std::make_unique<Shader>(1), release);
+		CHECK(lookup.Find(1, &firstHit) && firstHit);
+		lookup.Clear(release);
+		lookup.Clear(release);
+		Shader::Collect(0);
+	}
+
+	void TestMarks(std::span<const uint32_t> a_descriptors, std::span<const uint32_t> a_missing)
+	{
+		Lookup lookup;
+		const auto release = [](Shader&) {};
+
+		// a queued permutation has a mark but no shader yet
+		CHECK(lookup.GetMark(1) == 0);
+		lookup.SetMark(1, 2);
+		CHECK(lookup.GetMark(1) == 2);
+		CHECK(!lookup.Find(1));
+		CHECK(lookup.Size() == 0);
+
+		// storing a shader resets the mark
+		lookup.InsertOrAssign(1, std::make_unique<Shader>(1), release);
+		CHECK(lookup.Find(1) && lookup.GetMark(1) == 0);
+		lookup.SetMark(1, 3);
+		CHECK(lookup.Erase(1, release));
+		CHECK(lookup.GetMark(1) == 0);
+		lookup.SetMark(1, 0);
+		CHECK(lookup.GetMark(1) == 0);
+
+		// marks without a shader survive the index rebuilds caused by growth
+		for (auto descriptor : a_missing)
+			lookup.SetMark(descriptor, 1);
+		Fill(lookup, a_descriptors);
+		bool allMarked = true;
+		for (auto descriptor : a_missing)
+			allMarked &= lookup.GetMark(descriptor) == 1 && !lookup.Find(descriptor);
+		CHECK(allMarked);
+		bool noneMarked = true;
+		for (auto descriptor : a_descriptors)
+			noneMarked &= lookup.GetMark(descriptor) == 0 && lookup.Find(descriptor);
+		CHECK(noneMarked);
+
+		lookup.ClearMarks();
+		CHECK(lookup.GetMark(a_missing[0]) == 0);
+		CHECK(lookup.Size() == a_descriptors.size());
+		lookup.SetMark(a_missing[0], 1);
+		lookup.Clear(release);
+		CHECK(lookup.GetMark(a_missing[0]) == 0);
+		lookup.Clear(release);
+		Shader::Collect(0);
+	}
+
+	void TestGrowth(std::span<const uint32_t> a_descriptors)
+	{
+		Lookup lookup;
+		Fill(lookup, a_descriptors);
+		CHECK(lookup.Size() == a_descriptors.size());
+		bool allFound = true;
+		for (auto descriptor : a_descriptors) {
+			auto* shader = lookup.Find(descriptor);
+			allFound &= shader && shader->descriptor == descriptor;
+		}
+		CHECK(allFound);
+	}
+
+	/**
+	 * Readers look up continuously while a writer replaces, erases and clears, including the
+	 * back to back clears of a cache update. A reader that sees a freed index or shader reads garbage.
+	 */
+	void TestConcurrentReaders(std::span<const uint32_t> a_descriptors, int a_rounds)
+	{
+		Lookup lookup;
+		Fill(lookup, a_descriptors);
+
+		std::atomic<bool> stop = false;
+		std::atomic<uint64_t> mismatches = 0;
+		std::atomic<uint64_t> lookups = 0;
+		std::vector<std::jthread> readers;
+		for (int reader = 0; reader < 3; reader++) {
+			readers.emplace_back([&, reader]() {
+				uint64_t count = 0;
+				for (size_t i = reader; !stop.load(std::memory_order_relaxed); i++, count++) {
+					const uint32_t descriptor = a_descriptors[i % a_descriptors.size()];
+					if (auto* shader = lookup.Find(descriptor); shader && shader->descriptor != descriptor)
+						mismatches++;
+				}
+				lookups += count;
+			});
+		}
+
+		const auto release = [](Shader&) {};
+		size_t previousRound = 0;
+		for (int round = 0; round < a_rounds; round++) {
+			const size_t collected = Shader::graveyard.size();
+			for (size_t i = 0; i < a_descriptors.size(); i += 3)
+				lookup.InsertOrAssign(a_descriptors[i], std::make_unique<Shader>(a_descriptors[i]), release);
+			for (size_t i = 1; i < a_descriptors.size(); i += 7)
+				lookup.Erase(a_descriptors[i], release);
+			lookup.Clear(release);
+			lookup.Clear(release);
+			Fill(lookup, a_descriptors);
+			// shaders get the same grace period as retired indices: dropped ones survive one more round
+			Shader::Collect(Shader::graveyard.size() - previousRound);
+			previousRound = Shader::graveyard.size() - collected;
+			// cache updates are user actions, frames apart; the grace period relies on that
+			std::this_thread::sleep_for(20ms);
+		}
+		stop = true;
+		readers.clear();
+		Shader::Collect(0);
+
+		CHECK(mismatches == 0);
+		CHECK(lookups > 0);
+	}
+
+	void Benchmark(std::span<const uint32_t> a_descriptors, std::span<const uint32_t> a_missing, uint64_t a_iterations)
+	{
+		Lookup lookup;
+		Fill(lookup, a_descriptors);
+
+		// what the lookup replaced: a map behind a reader/writer lock
+		std::unordered_map<uint32_t, std::unique_ptr<Shader>> map;
+		std::shared_mutex mapMutex;
+		for (auto descriptor : a_descriptors)
+			map.emplace(descriptor, std::make_unique<Shader>(descriptor));
+
+		const size_t count = a_descriptors.size();
+		Test::Measure("ShaderLookup::Find hit", a_iterations, [&](uint64_t i) {
+			Test::DoNotOptimize(lookup.Find(a_descriptors[i % count]));
+		});
+		bool firstHit = false;
+		Test::Measure("ShaderLookup::Find hit, first hit flag", a_iterations, [&](uint64_t i) {
+			Test::DoNotOptimize(lookup.Find(a_descriptors[i % count], &firstHit));
+		});
+		Test::Measure("ShaderLookup::Find miss", a_iterations, [&](uint64_t i) {
+			Test::DoNotOptimize(lookup.Find(a_missing[i % a_missing.size()]));
+		});
+		Test::Measure("ShaderLookup::GetMark miss", a_iterations, [&](uint64_t i) {
+			Test::DoNotOptimize(lookup.GetMark(a_missing[i % a_missing.size()]));
+		});
+		Test::Measure("shared_lock + unordered_map hit", a_iterations, [&](uint64_t i) {
+			std::shared_lock lock(mapMutex);
+			auto it = map.find(a_descriptors[i % count]);
+			Test::DoNotOptimize(it != map.end() ? it->second.get() : nullptr);
+		});
+		Test::Measure("shared_lock + unordered_map miss", a_iterations, [&](uint64_t i) {
+			std::shared_lock lock(mapMutex);
+			auto it = map.find(a_missing[i % a_missing.size()]);
+			Test::DoNotOptimize(it != map.end() ? it->second.get() : nullptr);
+		});
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const bool quick = argc > 1 && std::string_view(argv[1]) == "--quick";
+	const uint64_t iterations = quick ? 100'000 : 50'000'000;
+
+	// a typical shader type holds a few thousand permutations
+	const auto descriptors = MakeDescriptors(4096, 1);
+	std::vector<uint32_t> missing;
+	{
+		const std::unordered_set<uint32_t> present(descriptors.begin(), descriptors.end());
+		for (auto descriptor : MakeDescriptors(8192, 2)) {
+			if (!present.contains(descriptor))
+				missing.push_back(descriptor);
+		}
+	}
+
+	TestRelease();
+	TestFirstHit(descriptors);
+	TestMarks(descriptors, missing);
+	TestGrowth(descriptors);
+	TestConcurrentReaders(descriptors, quick ? 20 : 200);
+	Benchmark(descriptors, missing, iterations);
+	Shader::Collect(0);
+	return Test::Finish("ShaderLookupBenchmark");
+}
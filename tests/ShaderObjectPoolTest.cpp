@@ -0,0 +1,98 @@
+#include "Check.h"
+
+#include "ShaderCache/ShaderObjectPool.h"
+
+namespace
+{
+	struct Object
+	{
+		int* releases;
+		void Release() { (*releases)++; }
+	};
+
+	using Pool = SIE::ShaderObjectPool<Object>;
+
+	// a DXBC container header with a_checksum repeated, followed by a_size bytes of body
+	std::vector<uint8_t> MakeBytecode(uint8_t a_checksum, size_t a_size)
+	{
+		std::vector<uint8_t> bytecode{ 'D', 'X', 'B', 'C' };
+		bytecode.resize(20 + a_size, a_checksum);
+		return bytecode;
+	}
+
+	void TestDigests()
+	{
+		CHECK((Pool::GetDigest(MakeBytecode(1, 8)) == Pool::GetDigest(MakeBytecode(1, 8))));
+		CHECK((Pool::GetDigest(MakeBytecode(1, 8)) != Pool::GetDigest(MakeBytecode(2, 8))));
+		// equal checksums of different sizes are different shaders
+		CHECK((Pool::GetDigest(MakeBytecode(1, 8)) != Pool::GetDigest(MakeBytecode(1, 12))));
+		CHECK(!Pool::GetDigest(std::vector<uint8_t>(19, 'D')));
+
+		// bytecode without a DXBC header is never shared, and its objects are released directly
+		int releases = 0;
+		Object first{ &releases };
+		Object second{ &releases };
+		Object* next = &first;
+		const auto create = [&]() { return std::exchange(next, &second); };
+		Pool pool;
+		const std::vector<uint8_t> raw{ 1, 2, 3, 4 };
+		CHECK(pool.Acquire(raw, create) == &first);
+		CHECK(pool.Acquire(raw, create) == &second);
+		CHECK(pool.Size() == 0);
+		pool.Release(&first);
+		pool.Release(&second);
+		CHECK(releases == 2);
+	}
+}
+
+int main()
+{
+	TestDigests();
+
+	int releases = 0;
+	std::vector<std::unique_ptr<Object>> objects;
+	int creates = 0;
+	const auto create = [&]() {
+		creates++;
+		return objects.emplace_back(std::make_unique<Object>(&releases)).get();
+	};
+
+	Pool pool;
+	const auto bytecode = MakeBytecode(1, 8);
+	const auto sameSize = MakeBytecode(2, 8);
+
+	auto* first = pool.Acquire(bytecode, create);
+	auto* shared = pool.Acquire(std::vector<uint8_t>(bytecode), create);
+	auto* other = pool.Acquire(sameSize, create);
+	CHECK(first && first == shared);
+	CHECK(other && other != first);
+	CHECK(creates == 2);
+	CHECK(pool.Size() == 2);
+	CHECK((pool.GetCounts() == std::pair<uint64_t, uint64_t>{ 3, 2 }));
+
+	// failed creation is not cached
+	CHECK(!pool.Acquire(MakeBytecode(9, 4), []() -> Object* { return nullptr; }));
+	CHECK(pool.Size() == 2);
+
+	pool.Release(first);
+	CHECK(releases == 0);
+	pool.Release(shared);
+	CHECK(releases == 1);
+	CHECK(pool.Size() == 1);
+
+	// once released, the same bytecode creates a new object
+	auto* again = pool.Acquire(bytecode, create);
+	CHECK(again && creates == 3);
+
+	pool.Release(other);
+	pool.Release(again);
+	CHECK(releases == 3);
+	CHECK(pool.Size() == 0);
+
+	// objects the pool did not create are released directly
+	Object foreign{ &releases };
+	pool.Release(&foreign);
+	CHECK(releases == 4);
+
+	return Test::Finish("ShaderObjectPoolTest");
+}
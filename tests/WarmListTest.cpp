@@ -0,0 +1,121 @@
+#include "Check.h"
+
+#include "ShaderCache/WarmList.h"
+
+using SIE::WarmList;
+
+namespace
+{
+	void TestRecord(const std::filesystem::path& a_path)
+	{
+		WarmList list(a_path);
+		CHECK(!list.Load());
+		CHECK(list.Record(WarmList::Pack(1, 0, 0x10)));
+		CHECK(!list.Record(WarmList::Pack(1, 0, 0x10)));
+		CHECK(list.Record(WarmList::Pack(1, 1, 0x10)));
+		CHECK(list.Record(WarmList::Pack(2, 0, 0x20)));
+		CHECK(list.GetCount() == 3);
+
+		const auto permutations = list.GetPermutations(1);
+		CHECK(permutations.size() == 2);
+		CHECK(permutations[0].shaderClass == 0 && permutations[0].descriptor == 0x10);
+		CHECK(permutations[1].shaderClass == 1 && permutations[1].descriptor == 0x10);
+		CHECK(list.Save());
+
+		WarmList loaded(a_path);
+		CHECK(loaded.Load());
+		CHECK(loaded.GetCount() == 3);
+		CHECK(loaded.GetSession() == list.GetSession() + 1);
+		// seen in an earlier session, so recording refreshes it without adding it
+		CHECK(!loaded.Record(WarmList::Pack(2, 0, 0x20)));
+	}
+
+	void TestAging(const std::filesystem::path& a_path)
+	{
+		const uint64_t stale = WarmList::Pack(3, 0, 1);
+		const uint64_t fresh = WarmList::Pack(3, 0, 2);
+		{
+			WarmList list(a_path);
+			list.Load();
+			list.Record(stale);
+			list.Record(fresh);
+			list.Save();
+		}
+
+		// sessions that record nothing do not age the list
+		for (int i = 0; i < 4 * static_cast<int>(WarmList::MaxAge); i++) {
+			WarmList list(a_path);
+			CHECK(list.Load());
+			CHECK(list.Save());
+		}
+
+		for (uint32_t i = 0; i < WarmList::MaxAge; i++) {
+			WarmList list(a_path);
+			CHECK(list.Load());
+			CHECK(list.GetCount() == 2);
+			list.Record(fresh);
+			list.Save();
+		}
+
+		WarmList list(a_path);
+		CHECK(list.Load());
+		CHECK(list.GetCount() == 1);
+		CHECK(list.GetPermutations(3).size() == 1 && list.GetPermutations(3)[0].descriptor == 2);
+	}
+
+	void TestCap(const std::filesystem::path& a_path)
+	{
+		const uint32_t overflow = 100;
+		{
+			WarmList list(a_path);
+			list.Load();
+			for (uint32_t descriptor = 0; descriptor < overflow; descriptor++)
+				list.Record(WarmList::Pack(4, 0, descriptor));
+			list.Save();
+		}
+		{
+			// the later session's keys are the most recent and survive the cap
+			WarmList list(a_path);
+			list.Load();
+			for (uint32_t descriptor = overflow; descriptor < WarmList::MaxCount + overflow; descriptor++)
+				list.Record(WarmList::Pack(4, 0, descriptor));
+			CHECK(list.GetCount() == WarmList::MaxCount + overflow);
+			CHECK(list.Save());
+			CHECK(list.GetCount() == WarmList::MaxCount);
+		}
+
+		WarmList list(a_path);
+		CHECK(list.Load());
+		const auto permutations = list.GetPermutations(4);
+		CHECK(permutations.size() == WarmList::MaxCount);
+		CHECK(permutations.front().descriptor == overflow);
+	}
+
+	void TestInvalidFile(const std::filesystem::path& a_path)
+	{
+		{
+			std::ofstream out(a_path, std::ios::binary | std::ios::trunc);
+			const WarmList::Header header{ WarmList::Magic, WarmList::Version, 1000, 1, 0 };
+			out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		}
+		WarmList list(a_path);
+		CHECK(!list.Load());
+		CHECK(list.GetCount() == 0);
+	}
+}
+
+int main()
+{
+	const auto dir = std::filesystem::temp_directory_path() / "cs-tests-warm-list";
+	std::filesystem::remove_all(dir);
+	std::filesystem::create_directories(dir);
+
+	TestRecord(dir / "Record.bin");
+	TestAging(dir / "Aging.bin");
+	TestCap(dir / "Cap.bin");
+	TestInvalidFile(dir / "Invalid.bin");
+
+	std::error_code ec;
+	std::filesystem::remove_all(dir, ec);
+	return Test::Finish("WarmListTest");
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "ShaderCache/BuildManifest.h"
+#include "SourceTree.h"
+
+namespace CacheBuild
+{
+	/**
+	 * @brief Compiler used to turn manifest permutations into cache entries.
+	 *
+	 * Preprocess() output feeds the disk cache key, so a backend only produces keys the game
+	 * will hit if its preprocessor matches the game's (D3DPreprocess). Both methods are
+	 * called concurrently from worker threads.
+	 */
+	class CompilerBackend
+	{
+	public:
+		struct Preprocessed
+		{
+			std::string source;                     // all includes expanded
+			std::set<std::filesystem::path> files;  // the source file and every file it includes
+		};
+
+		virtual ~CompilerBackend() = default;
+
+		/**
+		 * @brief Returns the source with all includes expanded, or nullopt with a_errors filled.
+		 */
+		virtual std::optional<Preprocessed> Preprocess(const SIE::BuildManifest::Permutation& a_permutation, std::string& a_errors) = 0;
+
+		/**
+		 * @brief Returns the final (stripped) bytecode, or nullopt with a_errors filled.
+		 */
+		virtual std::optional<std::vector<uint8_t>> Compile(const SIE::BuildManifest::Permutation& a_permutation, std::string& a_errors) = 0;
+	};
+
+	/**
+	 * @brief Stand-in backend for platforms without d3dcompiler.
+	 *
+	 * Expands includes textually and emits a deterministic pseudo blob derived from the
+	 * preprocessed source, so the whole pipeline can be exercised on any build machine.
+	 * Its keys and blobs are not usable by the game.
+	 */
+	std::unique_ptr<CompilerBackend> CreateStandInCompilerBackend(const SourceTree& a_tree);
+
+	/**
+	 * @brief Backend using d3dcompiler_47, producing the same keys and bytecode as the game.
+	 * @return nullptr on platforms without d3dcompiler.
+	 */
+	std::unique_ptr<CompilerBackend> CreateD3DCompilerBackend(const SourceTree& a_tree);
+}
@@ -0,0 +1,175 @@
+#include "CompilerBackend.h"
+
+#ifdef _WIN32
+#	ifndef WIN32_LEAN_AND_MEAN
+#		define WIN32_LEAN_AND_MEAN
+#	endif
+#	include <Windows.h>
+#	include <d3dcompiler.h>
+#endif
+
+namespace CacheBuild
+{
+#ifdef _WIN32
+	namespace
+	{
+		template <class T>
+		struct ComPtr
+		{
+			~ComPtr()
+			{
+				if (ptr)
+					ptr->Release();
+			}
+			T** put() { return &ptr; }
+			T* operator->() const { return ptr; }
+			explicit operator bool() const { return ptr != nullptr; }
+
+			T* ptr = nullptr;
+		};
+
+		std::string GetErrors(const ComPtr<ID3DBlob>& a_errors)
+		{
+			return a_errors ? std::string(static_cast<const char*>(a_errors->GetBufferPointer()), a_errors->GetBufferSize()) : std::string();
+		}
+
+		/**
+		 * Resolves includes over the source tree the same way the plugin's include handler
+		 * resolves them over Data/Shaders, so the preprocessed text and keys match.
+		 */
+		class TreeInclude : public ID3DInclude
+		{
+		public:
+			TreeInclude(const SourceTree& a_tree, std::filesystem::path a_sourceDirectory) :
+				tree(a_tree), sourceDirectory(std::move(a_sourceDirectory)) {}
+
+			HRESULT __stdcall Open(D3D_INCLUDE_TYPE, LPCSTR a_fileName, LPCVOID a_parentData, LPCVOID* a_data, UINT* a_bytes) override
+			{
+				auto parent = openFiles.find(a_parentData);
+				auto path = tree.ResolveInclude(a_fileName, parent != openFiles.end() ? parent->second.directory : sourceDirectory);
+				if (!path)
+					return E_FAIL;
+				auto contents = SourceTree::ReadFile(*path);
+				if (!contents)
+					return E_FAIL;
+
+				auto data = std::make_unique<std::string>(std::move(*contents));
+				*a_data = data->data();
+				*a_bytes = static_cast<UINT>(data->size());
+				openFiles.emplace(data->data(), OpenFile{ std::move(data), path->parent_path() });
+				files.insert(*path);
+				return S_OK;
+			}
+
+			HRESULT __stdcall Close(LPCVOID a_data) override
+			{
+				openFiles.erase(a_data);
+				return S_OK;
+			}
+
+			std::set<std::filesystem::path>& GetFiles() { return files; }
+
+		private:
+			struct OpenFile
+			{
+				std::unique_ptr<std::string> contents;
+				std::filesystem::path directory;
+			};
+
+			const SourceTree& tree;
+			std::filesystem::path sourceDirectory;
+			std::unordered_map<const void*, OpenFile> openFiles;
+			std::set<std::filesystem::path> files;  // every file opened
+		};
+
+		class D3DCompilerBackend : public CompilerBackend
+		{
+		public:
+			explicit D3DCompilerBackend(const SourceTree& a_tree) :
+				tree(a_tree) {}
+
+			std::optional<Preprocessed> Preprocess(const SIE::BuildManifest::Permutation& a_permutation, std::string& a_errors) override
+			{
+				auto input = Prepare(a_permutation, a_errors);
+				if (!input)
+					return std::nullopt;
+
+				TreeInclude include(tree, input->path.parent_path());
+				ComPtr<ID3DBlob> preprocessed;
+				ComPtr<ID3DBlob> errors;
+				if (FAILED(D3DPreprocess(input->source.data(), input->source.size(), a_permutation.source.c_str(), input->macros.data(), &include, preprocessed.put(), errors.put()))) {
+					a_errors = GetErrors(errors);
+					return std::nullopt;
+				}
+				Preprocessed output{ std::string(static_cast<const char*>(preprocessed->GetBufferPointer()), preprocessed->GetBufferSize()), std::move(include.GetFiles()) };
+				output.files.insert(input->path);
+				return output;
+			}
+
+			std::optional<std::vector<uint8_t>> Compile(const SIE::BuildManifest::Permutation& a_permutation, std::string& a_errors) override
+			{
+				auto input = Prepare(a_permutation, a_errors);
+				if (!input)
+					return std::nullopt;
+
+				TreeInclude include(tree, input->path.parent_path());
+				ComPtr<ID3DBlob> bytecode;
+				ComPtr<ID3DBlob> errors;
+				if (FAILED(D3DCompile(input->source.data(), input->source.size(), a_permutation.source.c_str(), input->macros.data(), &include,
+						"main", a_permutation.profile.c_str(), a_permutation.flags, 0, bytecode.put(), errors.put()))) {
+					a_errors = GetErrors(errors);
+					return std::nullopt;
+				}
+
+				ComPtr<ID3DBlob> stripped;
+				if (a_permutation.stripFlags && FAILED(D3DStripShader(bytecode->GetBufferPointer(), bytecode->GetBufferSize(), a_permutation.stripFlags, stripped.put()))) {
+					a_errors = "Failed to strip shader";
+					return std::nullopt;
+				}
+				auto* result = stripped ? stripped.ptr : bytecode.ptr;
+				const auto* data = static_cast<const uint8_t*>(result->GetBufferPointer());
+				return std::vector<uint8_t>(data, data + result->GetBufferSize());
+			}
+
+		private:
+			struct Input
+			{
+				std::filesystem::path path;
+				std::string source;
+				std::vector<D3D_SHADER_MACRO> macros;  // points into the permutation's defines
+			};
+
+			std::optional<Input> Prepare(const SIE::BuildManifest::Permutation& a_permutation, std::string& a_errors) const
+			{
+				auto path = tree.ResolveSource(a_permutation.source);
+				if (!path) {
+					a_errors = std::format("{} not found in any shader root", a_permutation.source);
+					return std::nullopt;
+				}
+				auto source = SourceTree::ReadFile(*path);
+				if (!source) {
+					a_errors = std::format("Failed to read {}", path->string());
+					return std::nullopt;
+				}
+
+				Input input{ *path, std::move(*source) };
+				for (const auto& [name, definition] : a_permutation.defines)
+					input.macros.push_back({ name.c_str(), definition.c_str() });
+				input.macros.push_back({ nullptr, nullptr });
+				return input;
+			}
+
+			const SourceTree& tree;
+		};
+	}
+#endif
+
+	std::unique_ptr<CompilerBackend> CreateD3DCompilerBackend([[maybe_unused]] const SourceTree& a_tree)
+	{
+#ifdef _WIN32
+		return std::make_unique<D3DCompilerBackend>(a_tree);
+#else
+		return nullptr;
+#endif
+	}
+}
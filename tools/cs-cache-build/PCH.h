@@ -0,0 +1,59 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ranges>
+#include <set>
+#include <shared_mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <ankerl/unordered_dense.h>
+
+using namespace std::literals;
+
+// shared ShaderCache sources log through SKSE in the plugin; the tool prints warnings and errors.
+// The stubs are untyped like the ones in tests/PCH.h, so no std::format_string check runs on the call sites.
+namespace logger
+{
+	template <class... Args>
+	void trace(Args&&...)
+	{}
+	template <class... Args>
+	void debug(Args&&...)
+	{}
+	template <class... Args>
+	void info(Args&&...)
+	{}
+	template <class... Args>
+	void warn(std::string_view a_format, Args&&... a_args)
+	{
+		std::cerr << std::vformat(a_format, std::make_format_args(a_args...)) << '\n';
+	}
+	template <class... Args>
+	void error(std::string_view a_format, Args&&... a_args)
+	{
+		std::cerr << std::vformat(a_format, std::make_format_args(a_args...)) << '\n';
+	}
+}
@@ -0,0 +1,63 @@
+#include "SourceTree.h"
+
+namespace CacheBuild
+{
+	std::optional<std::filesystem::path> SourceTree::ResolveSource(std::string_view a_source) const
+	{
+		std::string relative(a_source);
+		std::ranges::replace(relative, '\\', '/');
+		constexpr std::string_view ShaderRoot = "data/shaders/";
+		if (relative.size() > ShaderRoot.size() &&
+			std::ranges::equal(std::string_view(relative).substr(0, ShaderRoot.size()), ShaderRoot, [](char a, char b) { return std::tolower(static_cast<unsigned char>(a)) == b; }))
+			relative.erase(0, ShaderRoot.size());
+
+		for (const auto& root : roots) {
+			auto candidate = root / relative;
+			if (std::filesystem::is_regular_file(candidate))
+				return candidate;
+		}
+		return std::nullopt;
+	}
+
+	std::optional<std::filesystem::path> SourceTree::ResolveInclude(std::string_view a_name, const std::filesystem::path& a_includingDirectory) const
+	{
+		std::string name(a_name);
+		std::ranges::replace(name, '\\', '/');
+
+		auto candidate = a_includingDirectory / name;
+		if (std::filesystem::is_regular_file(candidate))
+			return candidate;
+		for (const auto& root : roots) {
+			candidate = root / name;
+			if (std::filesystem::is_regular_file(candidate))
+				return candidate;
+		}
+		return std::nullopt;
+	}
+
+	std::string SourceTree::GetGamePath(const std::filesystem::path& a_path) const
+	{
+		std::error_code ec;
+		const auto path = std::filesystem::weakly_canonical(a_path, ec);
+		std::string result = a_path.generic_string();
+		for (const auto& root : roots) {
+			auto relative = path.lexically_relative(std::filesystem::weakly_canonical(root, ec));
+			if (!relative.empty() && *relative.begin() != "..") {
+				result = "data/shaders/" + relative.generic_string();
+				break;
+			}
+		}
+		std::ranges::replace(result, '\\', '/');
+		result.erase(std::unique(result.begin(), result.end(), [](char a, char b) { return a == '/' && b == '/'; }), result.end());
+		std::ranges::transform(result, result.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		return result;
+	}
+
+	std::optional<std::string> SourceTree::ReadFile(const std::filesystem::path& a_path)
+	{
+		std::ifstream file(a_path, std::ios::binary);
+		if (!file.is_open())
+			return std::nullopt;
+		return std::string{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+namespace CacheBuild
+{
+	/**
+	 * @brief Overlay of shader directories standing in for the game's `Data/Shaders`.
+	 *
+	 * Roots are searched in order, so the base package goes first and feature directories
+	 * after it, the same as their files end up merged in the game's Data folder.
+	 */
+	class SourceTree
+	{
+	public:
+		explicit SourceTree(std::vector<std::filesystem::path> a_roots) :
+			roots(std::move(a_roots)) {}
+
+		/**
+		 * @brief Maps a source path recorded in the manifest (`Data\Shaders\...`) to a file in the tree.
+		 */
+		std::optional<std::filesystem::path> ResolveSource(std::string_view a_source) const;
+
+		/**
+		 * @brief Resolves an include like the plugin does: next to the including file first, then in the roots.
+		 */
+		std::optional<std::filesystem::path> ResolveInclude(std::string_view a_name, const std::filesystem::path& a_includingDirectory) const;
+
+		/**
+		 * @brief Maps a file in the tree to the path the plugin records for it, e.g. `data/shaders/common/color.hlsli`.
+		 *
+		 * Normalized like the plugin's Util::FixFilePath, so the disk cache index written by the
+		 * tool matches the paths the game's file watcher reports.
+		 */
+		std::string GetGamePath(const std::filesystem::path& a_path) const;
+
+		static std::optional<std::string> ReadFile(const std::filesystem::path& a_path);
+
+	private:
+		std::vector<std::filesystem::path> roots;
+	};
+}
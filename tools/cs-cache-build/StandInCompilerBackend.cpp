@@ -0,0 +1,93 @@
+#include "CompilerBackend.h"
+
+#include "ShaderCache/ContentKey.h"
+
+namespace CacheBuild
+{
+	namespace
+	{
+		class StandInCompilerBackend : public CompilerBackend
+		{
+		public:
+			explicit StandInCompilerBackend(const SourceTree& a_tree) :
+				tree(a_tree) {}
+
+			std::optional<Preprocessed> Preprocess(const SIE::BuildManifest::Permutation& a_permutation, std::string& a_errors) override
+			{
+				auto path = tree.ResolveSource(a_permutation.source);
+				if (!path) {
+					a_errors = std::format("{} not found in any shader root", a_permutation.source);
+					return std::nullopt;
+				}
+				Preprocessed output;
+				if (!Expand(*path, a_permutation.source, output.source, output.files, a_errors))
+					return std::nullopt;
+				return output;
+			}
+
+			std::optional<std::vector<uint8_t>> Compile(const SIE::BuildManifest::Permutation& a_permutation, std::string& a_errors) override
+			{
+				auto preprocessed = Preprocess(a_permutation, a_errors);
+				if (!preprocessed)
+					return std::nullopt;
+
+				// "SIBC" magic followed by a digest of everything the real compiler would see
+				const uint64_t digest = SIE::ContentKey::Get(preprocessed->source, SIE::ContentKey::MergeDefines(a_permutation.defines), a_permutation.profile, a_permutation.flags, a_permutation.stripFlags);
+				std::vector<uint8_t> blob{ 'S', 'I', 'B', 'C' };
+				for (int shift = 0; shift < 64; shift += 8)
+					blob.push_back(static_cast<uint8_t>(digest >> shift));
+				return blob;
+			}
+
+		private:
+			// textual #include expansion; every file is expanded once, like files guarded by #pragma once
+			bool Expand(const std::filesystem::path& a_path, std::string_view a_name, std::string& a_output, std::set<std::filesystem::path>& a_included, std::string& a_errors) const
+			{
+				if (!a_included.insert(std::filesystem::weakly_canonical(a_path)).second)
+					return true;
+				auto source = SourceTree::ReadFile(a_path);
+				if (!source) {
+					a_errors = std::format("Failed to read {}", a_path.string());
+					return false;
+				}
+
+				a_output += std::format("#line 1 \"{}\"\n", a_name);
+				size_t lineNumber = 0;
+				for (auto lineRange : std::views::split(std::string_view(*source), '\n')) {
+					std::string_view line(lineRange.begin(), lineRange.end());
+					lineNumber++;
+					auto directive = line.substr(std::min(line.find_first_not_of(" \t"), line.size()));
+					if (!directive.starts_with("#include")) {
+						a_output += line;
+						a_output += '\n';
+						continue;
+					}
+
+					const auto open = directive.find_first_of("\"<");
+					const auto close = open == std::string_view::npos ? open : directive.find_first_of("\">", open + 1);
+					if (close == std::string_view::npos) {
+						a_errors = std::format("{}({}): malformed #include", a_path.string(), lineNumber);
+						return false;
+					}
+					const auto name = directive.substr(open + 1, close - open - 1);
+					auto includePath = tree.ResolveInclude(name, a_path.parent_path());
+					if (!includePath) {
+						a_errors = std::format("{}({}): cannot open include file {}", a_path.string(), lineNumber, name);
+						return false;
+					}
+					if (!Expand(*includePath, name, a_output, a_included, a_errors))
+						return false;
+					a_output += std::format("#line {} \"{}\"\n", lineNumber + 1, a_name);
+				}
+				return true;
+			}
+
+			const SourceTree& tree;
+		};
+	}
+
+	std::unique_ptr<CompilerBackend> CreateStandInCompilerBackend(const SourceTree& a_tree)
+	{
+		return std::make_unique<StandInCompilerBackend>(a_tree);
+	}
+}
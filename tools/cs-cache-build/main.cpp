@@ -0,0 +1,205 @@
+#include "CompilerBackend.h"
+
+#include "ShaderCache/ArchiveIndex.h"
+#include "ShaderCache/ContentKey.h"
+#include "ShaderCache/ShaderArchive.h"
+
+namespace
+{
+	constexpr std::string_view Usage =
+		"Usage: cs-cache-build --manifest <BuildManifest.tsv> --shaders <dir> [--shaders <dir>...] --output <dir>\n"
+		"                      [--backend d3d|stand-in] [--jobs <n>] [--archive <name>]\n"
+		"\n"
+		"  --manifest  permutation list recorded in game with \"Record Cache Build Manifest\"\n"
+		"  --shaders   shader root standing in for Data/Shaders; pass the base package first, then features\n"
+		"  --output    directory receiving <archive>.pak files, Index.bin and Info.ini (the game's Data/ShaderCache)\n"
+		"  --backend   compiler backend; d3d (default on Windows) or stand-in (for testing elsewhere)\n"
+		"  --jobs      worker threads (default: hardware concurrency)\n"
+		"  --archive   only build this archive; may be repeated\n";
+
+	struct Options
+	{
+		std::filesystem::path manifest;
+		std::vector<std::filesystem::path> shaderRoots;
+		std::filesystem::path output;
+		std::string backend =
+#ifdef _WIN32
+			"d3d";
+#else
+			"stand-in";
+#endif
+		unsigned jobs = std::max(1u, std::thread::hardware_concurrency());
+		std::set<std::string> archives;
+	};
+
+	std::optional<Options> ParseOptions(std::span<char*> a_args)
+	{
+		Options options;
+		for (size_t i = 1; i < a_args.size(); i++) {
+			const std::string_view arg = a_args[i];
+			if (i + 1 >= a_args.size()) {
+				std::cerr << std::format("Missing value for {}\n", arg);
+				return std::nullopt;
+			}
+			const std::string_view value = a_args[++i];
+			if (arg == "--manifest") {
+				options.manifest = value;
+			} else if (arg == "--shaders") {
+				options.shaderRoots.emplace_back(value);
+			} else if (arg == "--output") {
+				options.output = value;
+			} else if (arg == "--backend") {
+				options.backend = value;
+			} else if (arg == "--jobs") {
+				auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), options.jobs);
+				if (ec != std::errc{} || options.jobs == 0) {
+					std::cerr << std::format("Invalid job count {}\n", value);
+					return std::nullopt;
+				}
+			} else if (arg == "--archive") {
+				options.archives.emplace(value);
+			} else {
+				std::cerr << std::format("Unknown option {}\n", arg);
+				return std::nullopt;
+			}
+		}
+		if (options.manifest.empty() || options.shaderRoots.empty() || options.output.empty())
+			return std::nullopt;
+		return options;
+	}
+
+	struct CompiledShader
+	{
+		uint64_t key;
+		std::vector<uint8_t> bytecode;
+		std::vector<std::string> files;  // game paths of the source and its includes, for the disk cache index
+	};
+
+	// archive entry times are system_clock ticks of the game's runtime, which are 100 ns
+	int64_t GetWriteTime()
+	{
+		using Ticks = std::chrono::duration<int64_t, std::ratio<1, 10'000'000>>;
+		return std::chrono::duration_cast<Ticks>(std::chrono::system_clock::now().time_since_epoch()).count();
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	auto options = ParseOptions({ argv, static_cast<size_t>(argc) });
+	if (!options) {
+		std::cerr << Usage;
+		return 2;
+	}
+
+	SIE::BuildManifest manifest(options->manifest);
+	if (!manifest.Load()) {
+		std::cerr << std::format("Failed to read manifest {}\n", options->manifest.string());
+		return 1;
+	}
+	auto permutations = manifest.GetPermutations();
+	if (!options->archives.empty())
+		std::erase_if(permutations, [&](const auto& a_permutation) { return !options->archives.contains(a_permutation.archive); });
+
+	const CacheBuild::SourceTree tree(options->shaderRoots);
+	std::unique_ptr<CacheBuild::CompilerBackend> backend;
+	if (options->backend == "d3d")
+		backend = CacheBuild::CreateD3DCompilerBackend(tree);
+	else if (options->backend == "stand-in")
+		backend = CacheBuild::CreateStandInCompilerBackend(tree);
+	if (!backend) {
+		std::cerr << std::format("Compiler backend {} is not available on this platform\n", options->backend);
+		return 1;
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	std::atomic<size_t> next = 0;
+	std::atomic<size_t> failed = 0;
+	std::mutex resultsMutex;
+	std::map<std::string, std::vector<CompiledShader>> results;  // per archive
+	std::unordered_set<uint64_t> seenKeys;                       // guard with resultsMutex
+
+	auto worker = [&]() {
+		for (size_t index = next++; index < permutations.size(); index = next++) {
+			const auto& permutation = permutations[index];
+			std::string errors;
+			auto preprocessed = backend->Preprocess(permutation, errors);
+			if (!preprocessed) {
+				failed++;
+				std::cerr << std::format("Failed to preprocess {}:\n{}\n", SIE::BuildManifest::Format(permutation), errors);
+				continue;
+			}
+			const uint64_t key = SIE::ContentKey::Get(preprocessed->source, SIE::ContentKey::MergeDefines(permutation.defines), permutation.profile, permutation.flags, permutation.stripFlags);
+			{
+				std::lock_guard lock(resultsMutex);
+				if (!seenKeys.insert(key).second)
+					continue;  // a different descriptor with the same source and defines
+			}
+
+			auto bytecode = backend->Compile(permutation, errors);
+			if (!bytecode) {
+				failed++;
+				std::cerr << std::format("Failed to compile {}:\n{}\n", SIE::BuildManifest::Format(permutation), errors);
+				continue;
+			}
+			std::vector<std::string> files;
+			for (const auto& file : preprocessed->files)
+				files.push_back(tree.GetGamePath(file));
+			std::lock_guard lock(resultsMutex);
+			results[permutation.archive].push_back({ key, std::move(*bytecode), std::move(files) });
+			if (seenKeys.size() % 500 == 0)
+				std::cout << std::format("{}/{} permutations\n", std::min(next.load(), permutations.size()), permutations.size());
+		}
+	};
+	{
+		std::vector<std::jthread> workers;
+		for (unsigned i = 0; i < std::min<size_t>(options->jobs, std::max<size_t>(permutations.size(), 1)); i++)
+			workers.emplace_back(worker);
+	}
+
+	// without an index the game deletes the whole cache on the first shader edit; merged so --archive keeps other entries
+	SIE::ArchiveIndex index(options->output / "Index.bin");
+	index.Load();
+
+	size_t entries = 0;
+	size_t blobs = 0;
+	const int64_t writeTime = GetWriteTime();
+	for (auto& [archive, shaders] : results) {
+		std::vector<SIE::ShaderArchive::Source> sources;
+		sources.reserve(shaders.size());
+		for (const auto& shader : shaders)
+			sources.push_back({ shader.key, shader.bytecode, writeTime });
+
+		const auto path = options->output / std::format("{}.pak", archive);
+		const auto blobCount = SIE::ShaderArchive::Write(path, sources);
+		if (!blobCount) {
+			std::cerr << std::format("Failed to write {}\n", path.string());
+			return 1;
+		}
+		// a journal left by the game would be replayed over the fresh archive
+		std::error_code ec;
+		std::filesystem::remove(path.string() + ".log", ec);
+		entries += sources.size();
+		blobs += *blobCount;
+
+		// the manifest does not carry shader types; edits erase these entries by file instead
+		for (const auto& shader : shaders)
+			index.Record(archive, shader.key, SIE::ArchiveIndex::NoType, shader.files);
+	}
+
+	if (!index.Save()) {
+		std::cerr << std::format("Failed to write {}\n", (options->output / "Index.bin").string());
+		return 1;
+	}
+
+	std::ofstream info(options->output / "Info.ini", std::ios::trunc);
+	info << std::format("[Cache]\nFormat = {}\n", SHADER_CACHE_FORMAT);
+	if (!info) {
+		std::cerr << std::format("Failed to write {}\n", (options->output / "Info.ini").string());
+		return 1;
+	}
+
+	const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+	std::cout << std::format("Built {} archives: {} entries, {} distinct blobs, {} failed, {} permutations in {} ms with {} backend\n",
+		results.size(), entries, blobs, failed.load(), permutations.size(), elapsed.count(), options->backend);
+	return failed ? 1 : 0;
+}